@@ -0,0 +1,22 @@
+// Prints the fastest ISA level of the CPU codec (see src/ndzip/cpu_dispatch.hh) supported by the build host, for
+// NDZIP_CPU_HOST_ISA_ONLY. Mirrors host_supports() in src/ndzip/cpu_factory.cc.
+#include <cstdio>
+
+int main() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("bmi2") || !__builtin_cpu_supports("fma")) {
+        puts("generic");
+    } else if (!__builtin_cpu_supports("avx512f") || !__builtin_cpu_supports("avx512bw")) {
+        puts("avx2");
+    } else if (!__builtin_cpu_supports("avx512vbmi") || !__builtin_cpu_supports("gfni")) {
+        puts("avx512");
+    } else {
+        puts("avx512_gfni");
+    }
+#elif defined(__ARM_NEON)
+    puts("neon");
+#else
+    puts("generic");
+#endif
+}
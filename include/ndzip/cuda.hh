@@ -9,6 +9,8 @@ namespace ndzip {
 
 template<typename T>
 class cuda_compressor {
+    static_assert(gpu_supports_value_type<T>, "ndzip::cuda_compressor supports float and double only");
+
   public:
     using value_type = T;
     using compressed_type = detail::bits_type<T>;
@@ -22,6 +24,8 @@ class cuda_compressor {
 
 template<typename T>
 class cuda_decompressor {
+    static_assert(gpu_supports_value_type<T>, "ndzip::cuda_decompressor supports float and double only");
+
   public:
     using value_type = T;
     using compressed_type = detail::bits_type<T>;
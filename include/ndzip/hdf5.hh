@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ndzip.hh"
+
+#include <vector>
+
+#include <hdf5.h>
+
+
+namespace ndzip::hdf5 {
+
+// Identifier of the ndzip filter. It lies in the range 256 to 511 that HDF5 leaves to filters without a registered
+// identifier, so files written with it should not be shared with other applications that might use the same value.
+constexpr H5Z_filter_t filter_id = 311;
+
+// Registers the filter with the HDF5 library of the application. This is only needed when the filter is linked
+// directly; HDF5 also loads the h5z_ndzip library as a plugin from HDF5_PLUGIN_PATH.
+herr_t register_filter();
+
+// Adds the filter to a dataset creation property list, which must also set a chunk shape (see suggest_chunk_shape).
+// Every chunk is (de)compressed with num_threads threads, where 0 selects all cores. The compressors are kept per
+// calling thread and reused for all chunks of equal shape and element type.
+herr_t set_filter(hid_t dcpl, unsigned num_threads = 1);
+
+// Suggests a chunk shape of about target_chunk_bytes for a dataset of the given shape, slowest dimension first. The
+// filter compresses the innermost (up to three) dimensions of a chunk as one ndzip array and folds any outer dimensions
+// into the slowest of these. Chunk extents along the innermost dimensions are multiples of the hypercube side length
+// where the dataset is large enough, so that chunks have no border.
+std::vector<hsize_t> suggest_chunk_shape(
+        const std::vector<hsize_t> &dataset_shape, size_t element_size, size_t target_chunk_bytes = size_t{1} << 22u);
+
+}  // namespace ndzip::hdf5
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ndzip.hh"
+
+#include <mpi.h>
+
+
+namespace ndzip::mpi {
+
+// Domain-decomposed arrays in a single shared file. Every rank of a communicator compresses its local subdomain into a
+// regular ndzip stream, and all streams are written with collective MPI-IO behind a header of one 64-bit entry per
+// rank. Like the wide offsets in the header of an ndzip stream, entry r is the position after the stream of rank r in
+// words of compressed_type, counted from the end of the header. The streams themselves carry no extents, so readers
+// need the same decomposition as the writers. Subdomains whose offsets and extents are multiples of the hypercube side
+// length (see hypercube_count) are compressed without a border of their own.
+
+// Compresses local_data of extent local_size with the compressor of this rank and writes it to file at offset.
+// Collective over comm, which must be the communicator file was opened with. Returns the number of bytes written by
+// all ranks together, which is the offset of the next field relative to offset.
+template<typename T>
+MPI_Offset write_compressed(MPI_Comm comm, MPI_File file, MPI_Offset offset, compressor<T> &compressor,
+        const T *local_data, const extent &local_size);
+
+// Reads the stream of this rank from a field written by write_compressed at offset and decompresses it into
+// local_data, which must have the extent local_size that this rank wrote. Collective over comm, which must have the
+// same size as the communicator of the writers. Returns the number of bytes of the field.
+template<typename T>
+MPI_Offset read_compressed(MPI_Comm comm, MPI_File file, MPI_Offset offset, decompressor<T> &decompressor,
+        T *local_data, const extent &local_size);
+
+}  // namespace ndzip::mpi
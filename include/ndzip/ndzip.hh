@@ -1,10 +1,13 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 
 #if defined(__CUDA__) || defined(__NVCC__)
@@ -19,6 +22,23 @@ namespace ndzip {
 using dim_type = int;
 using index_type = uint32_t;
 
+// 16-bit floating-point elements in IEEE 754 binary16 and in bfloat16 (the upper half of a binary32) format. The codecs
+// only operate on the bit patterns, so these are plain storage types without arithmetic that applications fill from
+// their own half-precision types through a memcpy or bit_cast.
+struct float16 {
+    uint16_t bits;
+
+    friend constexpr bool operator==(float16 left, float16 right) { return left.bits == right.bits; }
+    friend constexpr bool operator!=(float16 left, float16 right) { return left.bits != right.bits; }
+};
+
+struct bfloat16 {
+    uint16_t bits;
+
+    friend constexpr bool operator==(bfloat16 left, bfloat16 right) { return left.bits == right.bits; }
+    friend constexpr bool operator!=(bfloat16 left, bfloat16 right) { return left.bits != right.bits; }
+};
+
 }  // namespace ndzip
 
 namespace ndzip::detail {
@@ -160,9 +180,13 @@ class extent {
 };
 
 
+// Element counts and linear indices are 64-bit, since arrays may exceed 2^32 elements even though each extent
+// component fits in index_type. The CPU codecs retain three 32-bit limits, beyond which they throw: every extent
+// component, the number of hypercubes of an array (see hypercube_count) and the number of border elements outside of
+// all hypercubes must each be below 2^32. The GPU codecs reject arrays of 2^32 elements or more.
 template<typename Extent>
-NDZIP_UNIVERSAL index_type num_elements(const Extent &size) {
-    index_type n = 1;
+NDZIP_UNIVERSAL size_t num_elements(const Extent &size) {
+    size_t n = 1;
     for (dim_type d = 0; d < size.dimensions(); ++d) {
         n *= size[d];
     }
@@ -170,9 +194,9 @@ NDZIP_UNIVERSAL index_type num_elements(const Extent &size) {
 }
 
 template<typename Extent>
-NDZIP_UNIVERSAL index_type linear_index(const Extent &space, const Extent &pos) {
+NDZIP_UNIVERSAL size_t linear_index(const Extent &space, const Extent &pos) {
     assert(space.dimensions() == pos.dimensions());
-    index_type l = pos[0];
+    size_t l = pos[0];
     for (dim_type d = 1; d < space.dimensions(); ++d) {
         l = l * space[d] + pos[d];
     }
@@ -213,6 +237,7 @@ using bits_type = typename bits_type_s<sizeof(T)>::type;
 
 dim_type get_dimensionality(const compressor_requirements &req);
 index_type get_num_hypercubes(const compressor_requirements &req);
+const std::vector<extent> &get_data_sizes(const compressor_requirements &req);
 
 }  // namespace ndzip::detail
 
@@ -221,8 +246,55 @@ namespace ndzip {
 template<typename T>
 using compressed_type = detail::bits_type<T>;
 
+// Side length of the hypercubes an array is divided into, relative to the standard 4096 (1D), 64^2 (2D) or 16^3 (3D)
+// elements. Larger hypercubes amortize the per-hypercube header on machines with large caches, smaller ones leave a
+// smaller border on array shapes that are not a multiple of the hypercube size. The choice is not recorded in the
+// stream, which must be decompressed with the hypercube size it was compressed with. The CPU codecs support smaller
+// and larger hypercubes for float and double, the GPU codecs support the standard size only.
+enum class hypercube_size {
+    standard,
+    smaller,  // 1024, 32^2 and 8^3 elements
+    larger,  // 16384, 128^2 and 32^3 elements
+};
+
+// Version of the stream format that compressors produce and decompressors expect, chosen at build time through the
+// NDZIP_STREAM_FORMAT_VERSION CMake option. Streams are headerless and carry no version marker, and a stream of
+// another version decodes to garbage without an error. Applications that store streams outside the compress tool
+// container should record this value next to them and reject mismatches.
+//   1: Original format
+//   2: The border of multi-dimensional arrays is a nested, compressed one-dimensional stream instead of verbatim
+//   3: Hypercubes of length 1 and of one word per element are constant and verbatim hypercubes, see
+//      detail::hypercube_encoding
+constexpr uint32_t stream_format_version = NDZIP_STREAM_FORMAT_VERSION;
+
+// Stream lengths are counted in compressed_type words and may exceed 2^32 for large arrays
+template<typename T>
+size_t compressed_length_bound(const extent &e, hypercube_size size = hypercube_size::standard);
+
+// Number of hypercubes an array is divided into, not counting its border
+index_type hypercube_count(const extent &data_size, hypercube_size size = hypercube_size::standard);
+
+// Smallest and largest value of one hypercube. An array of summaries, one per hypercube in the row-major order of the
+// hypercube grid (which is also their order in the stream), forms an optional index that applications keep next to
+// the stream. Range queries consult it to decompress only the hypercubes that may hold matching values, see
+// hypercubes_in_range() and decompressor::decompress_hypercubes(). NaNs are left out of the summary, and elements of
+// the border are not summarized at all, since the border is decompressed with every query.
+template<typename T>
+struct hypercube_summary {
+    T min;
+    T max;
+};
+
+// Summarizes the hypercubes of an array separately from compression, e.g. for streams produced by the GPU compressors
+template<typename T>
+void summarize_hypercubes(const T *data, const extent &data_size, hypercube_summary<T> *summaries,
+        hypercube_size size = hypercube_size::standard);
+
+// Indices of the hypercubes whose summary overlaps the closed interval [lower, upper]. Values are ordered numerically,
+// including float16 and bfloat16.
 template<typename T>
-index_type compressed_length_bound(const extent &e);
+std::vector<index_type> hypercubes_in_range(
+        const hypercube_summary<T> *summaries, index_type num_hypercubes, T lower, T upper);
 
 template<typename T>
 class compressor {
@@ -232,7 +304,18 @@ class compressor {
 
     virtual ~compressor() = default;
 
-    virtual index_type compress(const value_type *data, const extent &data_size, compressed_type *stream) = 0;
+    virtual size_t compress(const value_type *data, const extent &data_size, compressed_type *stream) = 0;
+
+    // Like compress(), and also writes hypercube_count(data_size) summaries. The CPU compressors compute them from
+    // every hypercube as it is loaded for compression (after any lossy truncation, so they describe the decompressed
+    // values). The default implementation runs summarize_hypercubes() after compression, for the standard hypercube
+    // size.
+    virtual size_t compress_summarized(const value_type *data, const extent &data_size, compressed_type *stream,
+            hypercube_summary<value_type> *summaries) {
+        const auto length = compress(data, data_size, stream);
+        summarize_hypercubes(data, data_size, summaries);
+        return length;
+    }
 };
 
 template<typename T>
@@ -243,14 +326,165 @@ class decompressor {
 
     virtual ~decompressor() = default;
 
-    virtual index_type decompress(const compressed_type *stream, value_type *data, const extent &data_size) = 0;
+    virtual size_t decompress(const compressed_type *stream, value_type *data, const extent &data_size) = 0;
+
+    // Decodes the box [region_offset, region_offset + region_size) of an array with extent data_size into the dense
+    // array `region`. Only the hypercubes and border elements overlapping the box are touched.
+    virtual void decompress_region(const compressed_type *stream, const extent &data_size,
+            const extent &region_offset, const extent &region_size, value_type *region)
+            = 0;
+
+    // Decodes the hypercubes listed in hc_indices (see hypercube_summary) and the border into the array `data`, leaving
+    // all other elements of data unchanged. Indices beyond the hypercubes of the array are rejected with
+    // std::runtime_error before anything is decoded. The default implementation decompresses the entire array.
+    virtual void decompress_hypercubes(const compressed_type *stream, value_type *data, const extent &data_size,
+            const index_type * /* hc_indices */, index_type /* num_indices */) {
+        decompress(stream, data, data_size);
+    }
+};
+
+// Placement of the worker threads of multi-threaded CPU compressors and decompressors
+enum class thread_placement {
+    // Leave thread placement to the OpenMP runtime and balance work dynamically
+    any,
+    // Pin threads (OpenMP proc_bind(spread)) and give every thread a contiguous range of hypercubes, so that on NUMA
+    // machines each thread reads input and writes output pages that live on (or are first-touched by) its own node.
+    // The compressor then stages each thread's output in node-local scratch memory of the size of the compressed
+    // stream before copying it into place.
+    numa,
+};
+
+// Opt-in lossy compression for data where quantized output is acceptable. Before the block transform, the compressor
+// keeps the sign, the exponent and the leading mantissa bits of every value and replaces the remaining low mantissa
+// bits by whichever pattern cancels the low bits of the transform residual, which turns the noisy low bit-planes into
+// zero words that are dropped from the stream. Decompressed values are therefore not truncated towards zero but may
+// lie on either side of the input, including further away from zero. Infinities and NaNs are kept bit for bit. The
+// stream format is unchanged, so decompression needs no knowledge of the precision used. Integer element types are
+// always compressed losslessly.
+class lossy_precision {
+  public:
+    // Lossless compression
+    constexpr lossy_precision() noexcept = default;
+
+    // Keeps the sign, the exponent and the `bits` most significant explicit mantissa bits (of 23 for float, 52 for
+    // double, 10 for float16 and 7 for bfloat16) of every value. The error is less than one unit in the last kept
+    // mantissa place, which for normal values is less than 2^-bits times their magnitude.
+    constexpr static lossy_precision mantissa_bits(unsigned bits) noexcept { return lossy_precision{bits, 0}; }
+
+    // Frees as many low mantissa bits of every finite value as keeps its absolute error below `bound`. Values of a
+    // magnitude below the largest power of two not exceeding the bound have no mantissa bits left to keep and decode
+    // to zero or to a subnormal of the same sign, whichever compresses best.
+    constexpr static lossy_precision absolute_error(double bound) noexcept {
+        return lossy_precision{no_mantissa_bits_limit, bound};
+    }
+
+    constexpr bool is_lossless() const noexcept { return _mantissa_bits == no_mantissa_bits_limit && _bound <= 0; }
+
+    constexpr unsigned kept_mantissa_bits() const noexcept { return _mantissa_bits; }
+
+    // Zero unless constructed through absolute_error()
+    constexpr double absolute_error_bound() const noexcept { return _bound > 0 ? _bound : 0; }
+
+  private:
+    constexpr static unsigned no_mantissa_bits_limit = ~0u;
+
+    unsigned _mantissa_bits = no_mantissa_bits_limit;
+    double _bound = 0;
+
+    constexpr lossy_precision(unsigned mantissa_bits, double bound) noexcept
+        : _mantissa_bits(mantissa_bits), _bound(bound) {}
 };
 
+// The GPU codecs map the 32 or 64 bit-planes of a hypercube chunk onto warp lanes and are built for float and double
+// only. The narrower element types are compressed on the CPU.
+template<typename T>
+inline constexpr bool gpu_supports_value_type = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// The CPU codecs support float, double, float16, bfloat16 and 8-, 16- and 32-bit signed and unsigned integer elements
 template<typename T>
-std::unique_ptr<compressor<T>> make_compressor(dim_type dims, unsigned num_threads = 0);
+std::unique_ptr<compressor<T>> make_compressor(dim_type dims, unsigned num_threads = 0,
+        thread_placement placement = thread_placement::any, const lossy_precision &precision = {},
+        hypercube_size size = hypercube_size::standard);
+
+template<typename T>
+std::unique_ptr<decompressor<T>> make_decompressor(dim_type dims, unsigned num_threads = 0,
+        thread_placement placement = thread_placement::any, hypercube_size size = hypercube_size::standard);
+
+// Caller-owned host memory that CPU compressors and decompressors carve their working buffers from. Codecs created on
+// an arena take every buffer that grows with the hypercube size, the thread count or the array size from it once, at
+// construction, so that applications creating codecs per variable and time step neither allocate nor fault in fresh
+// pages. Such a codec only accepts arrays covered by the compressor_requirements it was created with. The arena hands
+// out memory linearly and never reclaims it; reset() makes all of it available again once every codec created on it
+// has been destroyed.
+class scratch_arena {
+  public:
+    // Alignment of every buffer carved from the arena
+    constexpr static size_t alignment = 64;
+
+    scratch_arena(void *memory, size_t size) noexcept : _memory(static_cast<std::byte *>(memory)), _size(size) {}
+
+    // Throws std::bad_alloc if fewer than `size` bytes (plus alignment) are left
+    void *allocate(size_t size);
+
+    void reset() noexcept { _used = 0; }
+
+    size_t size() const noexcept { return _size; }
+
+    size_t used() const noexcept { return _used; }
+
+  private:
+    std::byte *_memory;
+    size_t _size;
+    size_t _used = 0;
+};
+
+// Arena bytes needed by one compressor, or by one decompressor, created on a scratch_arena with the same arguments. An
+// arena shared by several codecs needs the sum of their requirements.
+template<typename T>
+size_t required_scratch_bytes(const compressor_requirements &req, unsigned num_threads = 0,
+        thread_placement placement = thread_placement::any, hypercube_size size = hypercube_size::standard);
+
+template<typename T>
+std::unique_ptr<compressor<T>> make_compressor(const compressor_requirements &req, scratch_arena &arena,
+        unsigned num_threads = 0, thread_placement placement = thread_placement::any,
+        const lossy_precision &precision = {}, hypercube_size size = hypercube_size::standard);
+
+template<typename T>
+std::unique_ptr<decompressor<T>> make_decompressor(const compressor_requirements &req, scratch_arena &arena,
+        unsigned num_threads = 0, thread_placement placement = thread_placement::any,
+        hypercube_size size = hypercube_size::standard);
+
+// Compresses an array that becomes available incrementally in rows along its slowest-iterating dimension 0, such as a
+// field written out slab by slab by a simulation. Every completed row of hypercubes is compressed and handed to the
+// sink right away, so neither the whole array nor a compressed_length_bound() output buffer need to be resident in
+// memory. Only the border elements and hypercube offsets are retained until finish(). The resulting stream is
+// identical to the output of compressor<T>::compress().
+template<typename T>
+class stream_compressor {
+  public:
+    using value_type = T;
+    using compressed_type = detail::bits_type<T>;
+
+    // Receives `count` words to be stored at word `offset` of the compressed stream. Hypercube data is emitted in
+    // ascending order during write_rows(); finish() then emits the border after it and finally the header at offset 0.
+    using sink_type = std::function<void(size_t offset, const compressed_type *words, size_t count)>;
+
+    virtual ~stream_compressor() = default;
+
+    // Appends the next num_rows rows (slices perpendicular to dimension 0) of the array. Rows may be passed in any
+    // grouping, but groups of rows_per_slab() rows are compressed without an intermediate copy.
+    virtual void write_rows(const value_type *rows, index_type num_rows) = 0;
+
+    // Number of rows spanned by one row of hypercubes, i.e. the hypercube side length
+    virtual index_type rows_per_slab() const = 0;
+
+    // Emits border and header once all rows of the array have been written and returns the total stream length
+    virtual size_t finish() = 0;
+};
 
 template<typename T>
-std::unique_ptr<decompressor<T>> make_decompressor(dim_type dims, unsigned num_threads = 0);
+std::unique_ptr<stream_compressor<T>> make_stream_compressor(
+        const extent &data_size, typename stream_compressor<T>::sink_type sink, unsigned num_threads = 0);
 
 class compressor_requirements {
   public:
@@ -263,9 +497,11 @@ class compressor_requirements {
   private:
     friend dim_type detail::get_dimensionality(const compressor_requirements &);
     friend index_type detail::get_num_hypercubes(const compressor_requirements &);
+    friend const std::vector<extent> &detail::get_data_sizes(const compressor_requirements &);
 
     dim_type _dims = -1;
     index_type _max_num_hypercubes = 0;
+    std::vector<extent> _data_sizes;  // distinct, for sizing scratch buffers of any hypercube size
 };
 
 using kernel_duration = std::chrono::duration<uint64_t, std::nano>;
@@ -2,6 +2,35 @@
 
 #include "ndzip.hh"
 
+#include <algorithm>
+#include <future>
+#include <vector>
+
+
+namespace ndzip::detail {
+
+// Runs the operations submitted by offloader::compress_async and decompress_async one after another on a worker
+// thread of its own. Offloaders create their queue on the first asynchronous call.
+class offload_queue {
+  public:
+    offload_queue();
+    offload_queue(const offload_queue &) = delete;
+    offload_queue &operator=(const offload_queue &) = delete;
+
+    // Completes all submitted operations before joining the worker
+    ~offload_queue();
+
+    void submit(std::function<void()> op);
+
+    // Blocks until all submitted operations have completed
+    void wait();
+
+  private:
+    struct state;
+    std::unique_ptr<state> _state;
+};
+
+}  // namespace ndzip::detail
 
 namespace ndzip {
 
@@ -13,24 +42,100 @@ class offloader {
 
     virtual ~offloader() = default;
 
-    index_type compress(const value_type *data, const extent &data_size, compressed_type *stream,
+    size_t compress(const value_type *data, const extent &data_size, compressed_type *stream,
             kernel_duration *duration = nullptr) {
+        finish_async();
         return do_compress(data, data_size, stream, duration);
     }
 
-    index_type decompress(const compressed_type *stream, index_type length, value_type *data, const extent &data_size,
+    size_t decompress(const compressed_type *stream, size_t length, value_type *data, const extent &data_size,
             kernel_duration *duration = nullptr) {
+        finish_async();
         return do_decompress(stream, length, data, data_size, duration);
     }
 
+    // Like compress and decompress, but return immediately. Operations run in submission order on a worker thread
+    // owned by the offloader, so the device receives the next array as soon as the previous one is done while the
+    // calling thread continues. `data`, `stream` and `duration` must stay valid until the future is ready, which
+    // also delivers any exception. Synchronous calls wait for all outstanding operations first.
+    std::future<size_t> compress_async(const value_type *data, const extent &data_size, compressed_type *stream,
+            kernel_duration *duration = nullptr) {
+        return submit_async([=] { return do_compress(data, data_size, stream, duration); });
+    }
+
+    std::future<size_t> decompress_async(const compressed_type *stream, size_t length, value_type *data,
+            const extent &data_size, kernel_duration *duration = nullptr) {
+        return submit_async([=] { return do_decompress(stream, length, data, data_size, duration); });
+    }
+
+    void decompress_region(const compressed_type *stream, size_t length, const extent &data_size,
+            const extent &region_offset, const extent &region_size, value_type *region,
+            kernel_duration *duration = nullptr) {
+        if (region_offset.dimensions() != data_size.dimensions()
+                || region_size.dimensions() != data_size.dimensions()) {
+            throw std::runtime_error("region dimensionality does not match data dimensionality");
+        }
+        for (dim_type d = 0; d < data_size.dimensions(); ++d) {
+            if (region_offset[d] > data_size[d] || region_size[d] > data_size[d] - region_offset[d]) {
+                throw std::runtime_error("region exceeds the bounds of the array");
+            }
+        }
+        finish_async();
+        do_decompress_region(stream, length, data_size, region_offset, region_size, region, duration);
+    }
+
   protected:
-    virtual index_type
+    // Asynchronous operations call into the implementation, so every implementation waits for them in its destructor
+    void finish_async() {
+        if (_async_queue) { _async_queue->wait(); }
+    }
+
+    virtual size_t
     do_compress(const value_type *data, const extent &data_size, compressed_type *stream, kernel_duration *duration)
             = 0;
 
-    virtual index_type do_decompress(const compressed_type *stream, index_type length, value_type *data,
+    virtual size_t do_decompress(const compressed_type *stream, size_t length, value_type *data,
             const extent &data_size, kernel_duration *duration)
             = 0;
+
+    // Fallback for implementations without native region-of-interest support: decompress the entire array and copy
+    // the region out row by row.
+    virtual void do_decompress_region(const compressed_type *stream, size_t length, const extent &data_size,
+            const extent &region_offset, const extent &region_size, value_type *region, kernel_duration *duration) {
+        std::vector<value_type> data(num_elements(data_size));
+        do_decompress(stream, length, data.data(), data_size, duration);
+
+        const auto dims = data_size.dimensions();
+        const auto row_length = region_size[dims - 1];
+        extent row_size = region_size;
+        row_size[dims - 1] = 1;
+        for (size_t row = 0; row < num_elements(row_size); ++row) {
+            extent pos(dims);
+            auto r = row;
+            for (dim_type d = dims - 1; d >= 0; --d) {
+                pos[d] = r % row_size[d];
+                r /= row_size[d];
+            }
+            extent data_pos = pos;
+            for (dim_type d = 0; d < dims; ++d) {
+                data_pos[d] += region_offset[d];
+            }
+            std::copy_n(data.data() + linear_index(data_size, data_pos), row_length,
+                    region + linear_index(region_size, pos));
+        }
+    }
+
+  private:
+    std::unique_ptr<detail::offload_queue> _async_queue;
+
+    template<typename F>
+    std::future<size_t> submit_async(F &&op) {
+        if (!_async_queue) { _async_queue = std::make_unique<detail::offload_queue>(); }
+        auto task = std::make_shared<std::packaged_task<size_t()>>(std::forward<F>(op));
+        auto result = task->get_future();
+        _async_queue->submit([task] { (*task)(); });
+        return result;
+    }
 };
 
 enum class target {
@@ -44,27 +149,62 @@ enum class target {
 };
 
 template<typename T>
-std::unique_ptr<offloader<T>> make_cpu_offloader(dim_type dims, unsigned num_threads = 0);
+std::unique_ptr<offloader<T>> make_cpu_offloader(dim_type dims, unsigned num_threads = 0,
+        thread_placement placement = thread_placement::any, const lossy_precision &precision = {},
+        hypercube_size size = hypercube_size::standard);
+
+// Splits every array into one shard of contiguous hypercube rows per offloader in `devices`, (de)compresses the shards
+// concurrently and stitches the results into the same stream a single offloader produces. Arrays with fewer rows of
+// hypercubes than devices use only as many devices as there are rows.
+template<typename T>
+std::unique_ptr<offloader<T>>
+make_multi_device_offloader(dim_type dimensions, std::vector<std::unique_ptr<offloader<T>>> devices);
 
 #if NDZIP_HIPSYCL_SUPPORT
+namespace detail {
 template<typename T>
-std::unique_ptr<offloader<T>> make_sycl_offloader(dim_type dimensions, bool enable_profiling = false);
+std::unique_ptr<offloader<T>> make_sycl_offloader(dim_type dimensions, bool enable_profiling);
+}
+
+// Float and double only, see gpu_supports_value_type
+template<typename T>
+std::unique_ptr<offloader<T>> make_sycl_offloader(dim_type dimensions, bool enable_profiling = false) {
+    static_assert(gpu_supports_value_type<T>, "ndzip::make_sycl_offloader: the SYCL backend supports float and double "
+                                              "only, use make_cpu_offloader for other element types");
+    return detail::make_sycl_offloader<T>(dimensions, enable_profiling);
+}
 #endif
 
 #if NDZIP_CUDA_SUPPORT
+namespace detail {
 template<typename T>
 std::unique_ptr<offloader<T>> make_cuda_offloader(dim_type dimensions);
+}
+
+// Float and double only, see gpu_supports_value_type
+template<typename T>
+std::unique_ptr<offloader<T>> make_cuda_offloader(dim_type dimensions) {
+    static_assert(gpu_supports_value_type<T>, "ndzip::make_cuda_offloader: the CUDA backend supports float and double "
+                                              "only, use make_cpu_offloader for other element types");
+    return detail::make_cuda_offloader<T>(dimensions);
+}
 #endif
 
+// target::cpu supports every element type of make_compressor. The GPU targets support float and double only (see
+// gpu_supports_value_type) and throw std::runtime_error for the other element types, which are CPU-only.
 template<typename T>
 std::unique_ptr<offloader<T>> make_offloader(target target, dim_type dimensions, bool enable_profiling = false) {
     switch (target) {
         case target::cpu: return make_cpu_offloader<T>(dimensions);
 #if NDZIP_HIPSYCL_SUPPORT
-        case target::sycl: return make_sycl_offloader<T>(dimensions, enable_profiling);
+        case target::sycl:
+            if constexpr (gpu_supports_value_type<T>) { return make_sycl_offloader<T>(dimensions, enable_profiling); }
+            throw std::runtime_error("ndzip::make_offloader: the SYCL backend supports float and double only");
 #endif
 #if NDZIP_CUDA_SUPPORT
-        case target::cuda: return make_cuda_offloader<T>(dimensions);
+        case target::cuda:
+            if constexpr (gpu_supports_value_type<T>) { return make_cuda_offloader<T>(dimensions); }
+            throw std::runtime_error("ndzip::make_offloader: the CUDA backend supports float and double only");
 #endif
         default: throw std::runtime_error("ndzip::make_offloader: invalid target");
     }
@@ -29,6 +29,8 @@ struct sycl_decompress_events {
 
 template<typename T>
 class sycl_compressor {
+    static_assert(gpu_supports_value_type<T>, "ndzip::sycl_compressor supports float and double only");
+
   public:
     using value_type = T;
     using compressed_type = detail::bits_type<T>;
@@ -63,6 +65,8 @@ class sycl_buffer_compressor : public sycl_compressor<T> {
 
 template<typename T>
 class sycl_decompressor {
+    static_assert(gpu_supports_value_type<T>, "ndzip::sycl_decompressor supports float and double only");
+
   public:
     using value_type = T;
     using compressed_type = detail::bits_type<T>;
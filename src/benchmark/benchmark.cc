@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <complex>  // we don't use <complex>, but not including it triggers a CUDA error
 #include <cstdio>
@@ -6,6 +7,7 @@
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <thread>
 #include <utility>
@@ -297,6 +299,43 @@ static std::chrono::microseconds time_cuda_kernel(cudaEvent_t before, cudaEvent_
 #endif
 
 
+static const char *to_string(ndzip::hypercube_size size) {
+    switch (size) {
+        case ndzip::hypercube_size::smaller: return "smaller";
+        case ndzip::hypercube_size::larger: return "larger";
+        default: return "standard";
+    }
+}
+
+// Times a warm compression and decompression of the dataset with every hypercube size and returns the fastest one
+template<typename T>
+static ndzip::hypercube_size select_fastest_hypercube_size(
+        const T *input_buffer, const ndzip::extent &extent, size_t num_threads) {
+    const auto dims = extent.dimensions();
+    auto decompress_buffer = scratch_buffer<T>(ndzip::num_elements(extent));
+    auto fastest = ndzip::hypercube_size::standard;
+    auto fastest_duration = ndzip::kernel_duration::max();
+    for (auto size : {ndzip::hypercube_size::smaller, ndzip::hypercube_size::standard, ndzip::hypercube_size::larger}) {
+        const auto offloader = ndzip::make_cpu_offloader<T>(
+                dims, static_cast<unsigned>(num_threads), ndzip::thread_placement::any, {}, size);
+        auto compress_buffer
+                = scratch_buffer<ndzip::compressed_type<T>>{ndzip::compressed_length_bound<T>(extent, size)};
+        ndzip::kernel_duration compression_duration, decompression_duration;
+        size_t compressed_length = 0;
+        for (int rep = 0; rep < 2; ++rep) {  // the first repetition warms up caches and scratch buffers
+            compressed_length
+                    = offloader->compress(input_buffer, extent, compress_buffer.data(), &compression_duration);
+            offloader->decompress(compress_buffer.data(), compressed_length, decompress_buffer.data(), extent,
+                    &decompression_duration);
+        }
+        if (compression_duration + decompression_duration < fastest_duration) {
+            fastest = size;
+            fastest_duration = compression_duration + decompression_duration;
+        }
+    }
+    return fastest;
+}
+
 template<typename T>
 static benchmark_result benchmark_ndzip_target(
         ndzip::target target, const T *input_buffer, const metadata &meta, const benchmark_params &params) {
@@ -308,9 +347,26 @@ static benchmark_result benchmark_ndzip_target(
         extent[d] = static_cast<ndzip::index_type>(meta.extent[d]);
     }
 
+    // The CPU tunable selects the hypercube size: 1 = smaller, 2 = standard, 3 = larger
+    auto hypercube_size = ndzip::hypercube_size::standard;
+    if (target == ndzip::target::cpu) {
+        if (params.auto_tune) {
+            hypercube_size = select_fastest_hypercube_size(input_buffer, extent, params.num_threads);
+            fprintf(stderr, "ndzip selected hypercube size %s for %s\n", to_string(hypercube_size),
+                    meta.path.filename().c_str());
+        } else if (params.tunable == 1) {
+            hypercube_size = ndzip::hypercube_size::smaller;
+        } else if (params.tunable == 3) {
+            hypercube_size = ndzip::hypercube_size::larger;
+        }
+    }
+
     std::unique_ptr<ndzip::offloader<T>> offloader;
     switch (target) {
-        case ndzip::target::cpu: offloader = ndzip::make_cpu_offloader<T>(dims, params.num_threads); break;
+        case ndzip::target::cpu:
+            offloader = ndzip::make_cpu_offloader<T>(dims, static_cast<unsigned>(params.num_threads),
+                    ndzip::thread_placement::any, {}, hypercube_size);
+            break;
 
 #if NDZIP_HIPSYCL_SUPPORT
         case ndzip::target::sycl: offloader = ndzip::make_sycl_offloader<T>(dims, true); break;
@@ -326,7 +382,7 @@ static benchmark_result benchmark_ndzip_target(
     const auto uncompressed_length = ndzip::num_elements(extent);
     auto bench = benchmark{params};
 
-    auto compress_buffer = scratch_buffer<compressed_type>{ndzip::compressed_length_bound<T>(extent)};
+    auto compress_buffer = scratch_buffer<compressed_type>{ndzip::compressed_length_bound<T>(extent, hypercube_size)};
     size_t compressed_length;
     while (bench.compress_more()) {
         ndzip::kernel_duration duration;
@@ -1199,10 +1255,10 @@ const algorithm_map &available_algorithms() {
     // clang-format off
     static const algorithm_map algorithms {
         {"memcpy", {benchmark_memcpy}},
-        {"ndzip", {benchmark_ndzip(ndzip::target::cpu)}},
+        {"ndzip", {benchmark_ndzip(ndzip::target::cpu), 1, 2, 3}},
 #if NDZIP_OPENMP_SUPPORT
         {"memcpy-mt", {benchmark_memcpy_mt, 1, 1, 1, true /* multithreaded */}},
-        {"ndzip-mt", {benchmark_ndzip(ndzip::target::cpu), 1, 1, 1, true /* multithreaded */}},
+        {"ndzip-mt", {benchmark_ndzip(ndzip::target::cpu), 1, 2, 3, true /* multithreaded */}},
 #endif
 #if NDZIP_HIPSYCL_SUPPORT
         {"ndzip-sycl", {benchmark_ndzip(ndzip::target::sycl)}},
@@ -1282,6 +1338,30 @@ struct join {
 };
 
 
+static const char *data_type_name(data_type type) {
+    return type == data_type::t_float ? "float" : "double";
+}
+
+
+// Returns an empty result if the algorithm does not support the dataset
+static std::optional<benchmark_result> run_benchmark(const std::string &name, const algorithm &algo,
+        const void *input_buffer, const metadata &metadata, const benchmark_params &params) {
+    try {
+        return algo.benchmark(input_buffer, metadata, params);
+    } catch (not_implemented &) { return std::nullopt; } catch (buffer_mismatch &) {
+        std::ostringstream msg;
+        msg << "mismatch between input and decompressed buffer for " << metadata.path.filename().string() << " with "
+            << name << " (tunable=" << params.tunable << ")";
+        throw std::logic_error(msg.str());
+    } catch (std::exception &e) {
+        std::ostringstream msg;
+        msg << "exception raised by " << name << " benchmark (tunable=" << params.tunable << ") with "
+            << metadata.path.filename().string() << ": " << e.what();
+        throw std::runtime_error(msg.str());
+    }
+}
+
+
 static void benchmark_file(const metadata &metadata, const algorithm_map &algorithms, bool warm_up,
         std::chrono::microseconds min_time, unsigned min_reps, unsigned max_reps, tuning tunables,
         bool benchmark_scaling, bool auto_tune, const ndzip::detail::io_factory &io_factory) {
@@ -1315,29 +1395,88 @@ static void benchmark_file(const metadata &metadata, const algorithm_map &algori
             for (size_t num_threads = min_num_threads; num_threads <= max_num_threads; ++num_threads) {
                 auto params = benchmark_params{tunable, num_threads, min_time, min_reps, max_reps, warm_up, auto_tune};
 
-                benchmark_result result;
-                try {
-                    result = algo.benchmark(input_buffer, metadata, params);
-                } catch (not_implemented &) { continue; } catch (buffer_mismatch &) {
-                    std::ostringstream msg;
-                    msg << "mismatch between input and decompressed buffer for " << metadata.path.filename().string()
-                        << " with " << name << " (tunable=" << tunable << ")";
-                    throw std::logic_error(msg.str());
-                } catch (std::exception &e) {
-                    std::ostringstream msg;
-                    msg << "exception raised by " << name << " benchmark (tunable=" << tunable << ") with "
-                        << metadata.path.filename().string() << ": " << e.what();
-                    throw std::runtime_error(msg.str());
-                }
-                std::cout << metadata.path.filename().string() << ";"
-                          << (metadata.data_type == data_type::t_float ? "float" : "double") << ";"
+                auto result = run_benchmark(name, algo, input_buffer, metadata, params);
+                if (!result) { continue; }
+                std::cout << metadata.path.filename().string() << ";" << data_type_name(metadata.data_type) << ";"
                           << metadata.extent.size() << ";" << name << ";" << tunable << ";" << num_threads << ";"
-                          << join(",", result.compression_times, [](auto d) { return d.count(); }) << ";"
-                          << join(",", result.decompression_times, [](auto d) { return d.count(); }) << ";"
-                          << result.uncompressed_bytes << ";" << result.compressed_bytes << "\n";
+                          << join(",", result->compression_times, [](auto d) { return d.count(); }) << ";"
+                          << join(",", result->decompression_times, [](auto d) { return d.count(); }) << ";"
+                          << result->uncompressed_bytes << ";" << result->compressed_bytes << "\n";
+            }
+        }
+    }
+}
+
+
+static std::string json_string(const std::string &str) {
+    std::string quoted = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') { quoted.push_back('\\'); }
+        quoted.push_back(c);
+    }
+    return quoted + '"';
+}
+
+
+// Bytes per microsecond are MB/s
+static double mean_throughput_gbps(uint64_t bytes, const std::vector<std::chrono::microseconds> &times) {
+    std::chrono::microseconds total{};
+    for (auto t : times) {
+        total += t;
+    }
+    return static_cast<double>(bytes) * static_cast<double>(times.size()) / static_cast<double>(total.count()) * 1e-3;
+}
+
+
+// Runs every multi-threaded algorithm at 1 to max_num_threads threads next to memcpy-mt at the same thread count,
+// which bounds the throughput that the memory system allows for that many cores, and every other algorithm (the GPU
+// targets) once. Prints one JSON object per dataset.
+static void sweep_file(const metadata &metadata, const algorithm_map &algorithms, size_t max_num_threads,
+        const benchmark_params &base_params, const ndzip::detail::io_factory &io_factory, std::ostream &json) {
+    auto input_stream = io_factory.create_input_stream(metadata.path.string(), metadata.size_in_bytes());
+    auto input_buffer = input_stream->read_exact();
+
+    json << "    {\"dataset\": " << json_string(metadata.path.filename().string()) << ", \"data type\": \""
+         << data_type_name(metadata.data_type) << "\", \"dimensions\": [" << join(", ", metadata.extent)
+         << "], \"uncompressed bytes\": " << metadata.size_in_bytes() << ", \"points\": [";
+
+    size_t num_points = 0;
+    auto sweep_point = [&](const std::string &name, const algorithm &algo, std::optional<size_t> num_threads) {
+        auto params = base_params;
+        params.tunable = algo.tunable_good;
+        params.num_threads = num_threads.value_or(1);
+        const auto result = run_benchmark(name, algo, input_buffer, metadata, params);
+        if (!result) { return; }
+
+        json << (num_points++ > 0 ? ",\n" : "\n") << "        {\"algorithm\": " << json_string(name)
+             << ", \"threads\": " << (num_threads ? std::to_string(*num_threads) : "null")
+             << ", \"compressed bytes\": " << result->compressed_bytes << ", \"compression GB/s\": "
+             << mean_throughput_gbps(result->uncompressed_bytes, result->compression_times)
+             << ", \"decompression GB/s\": "
+             << mean_throughput_gbps(result->uncompressed_bytes, result->decompression_times) << "}";
+        std::cerr << metadata.path.filename().string() << ": " << name;
+        if (num_threads) { std::cerr << " with " << *num_threads << " threads"; }
+        std::cerr << " done\n";
+    };
+
+    const auto reference = available_algorithms().find("memcpy-mt");
+    const bool sweep_threads = std::any_of(
+            algorithms.begin(), algorithms.end(), [](auto &named_algo) { return named_algo.second.multithreaded; });
+    if (sweep_threads) {
+        for (size_t num_threads = 1; num_threads <= max_num_threads; ++num_threads) {
+            if (reference != available_algorithms().end()) {
+                sweep_point(reference->first, reference->second, num_threads);
+            }
+            for (auto &[name, algo] : algorithms) {
+                if (algo.multithreaded && name != "memcpy-mt") { sweep_point(name, algo, num_threads); }
             }
         }
     }
+    for (auto &[name, algo] : algorithms) {
+        if (!algo.multithreaded) { sweep_point(name, algo, std::nullopt); }
+    }
+
+    json << "\n    ]}";
 }
 
 
@@ -1392,6 +1531,8 @@ int main(int argc, char **argv) {
     bool no_mmap = false;
     bool no_warmup = false;
     bool benchmark_scaling = false;
+    bool sweep = false;
+    size_t sweep_max_threads = std::thread::hardware_concurrency();
     bool auto_tune = false;
 
     auto usage = "Usage: "s + argv[0] + " [options] csv-file\n\n";
@@ -1410,10 +1551,14 @@ int main(int argc, char **argv) {
             ("max-reps,R", opts::value(&benchmark_max_reps), "repeat each at most n times (default 100)")
             ("tunables", opts::value<std::string>(), "tunables good|minmax|max|full (default good)")
             ("scaling", opts::bool_switch(&benchmark_scaling), "vary number of threads for multi-threaded algorithms")
+            ("sweep", opts::bool_switch(&sweep),
+                    "run ndzip at 1..max-threads threads next to memcpy-mt and on every GPU target, output JSON")
+            ("max-threads", opts::value(&sweep_max_threads),
+                    "highest number of threads for --sweep (default: number of hardware threads)")
             ("no-mmap", opts::bool_switch(&no_mmap), "do not use memory-mapped I/O")
             ("no-warmup", opts::bool_switch(&no_warmup), "do not perform an additional warm-up step per benchmark")
             ("auto-tune", opts::bool_switch(&auto_tune),
-                    "auto-select optimal configuration per dataset (nvCOMP Cascaded)");
+                    "auto-select optimal configuration per dataset (nvCOMP Cascaded, ndzip hypercube size)");
     // clang-format on
 
     opts::positional_options_description pos;
@@ -1458,7 +1603,12 @@ int main(int argc, char **argv) {
     }
 
     algorithm_map selected_algorithms;
-    if (!include_algorithms.empty()) {
+    if (sweep && include_algorithms.empty()) {
+        // The multi-threaded CPU compressor with 1 thread is the single-threaded one
+        for (auto &[name, algo] : available_algorithms()) {
+            if (name.rfind("ndzip-", 0) == 0) { selected_algorithms.emplace(name, algo); }
+        }
+    } else if (!include_algorithms.empty()) {
         for (auto &name : include_algorithms) {
             if (auto iter = available_algorithms().find(name); iter != available_algorithms().end()) {
                 selected_algorithms.insert(*iter);
@@ -1483,6 +1633,25 @@ int main(int argc, char **argv) {
 #endif
     if (!io_factory) { io_factory = std::make_unique<ndzip::detail::stdio_io_factory>(); }
 
+    if (sweep) {
+        try {
+            const auto params = benchmark_params{1, 1, std::chrono::milliseconds(benchmark_ms), benchmark_min_reps,
+                    benchmark_max_reps, !no_warmup, auto_tune};
+            size_t num_datasets = 0;
+            std::cout << "{\"sweep\": [\n";
+            for (auto &metadata : load_metadata_file(metadata_csv_file)) {
+                if (num_datasets++ > 0) { std::cout << ",\n"; }
+                sweep_file(metadata, selected_algorithms, std::max(size_t{1}, sweep_max_threads), params, *io_factory,
+                        std::cout);
+            }
+            std::cout << "\n]}\n";
+            return EXIT_SUCCESS;
+        } catch (std::exception &e) {
+            std::cerr << "fatal: " << e.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
     try {
         std::cout << "dataset;data type;dimensions;algorithm;tunable;number of threads;"
                      "compression times (microseconds);decompression times (microseconds);"
@@ -3,6 +3,7 @@
 # pipe input from benchmark binary into this script to plot throughput vs. compression ratio
 
 import csv
+import json
 import sys
 from collections import defaultdict
 from operator import itemgetter
@@ -192,13 +193,61 @@ def plot_scaling(algorithms, by_data_type_and_algorithm, output_pgf):
         plt.show()
 
 
+def plot_sweep(sweeps, output_pgf):
+    datasets = [d for s in sweeps for d in s['sweep']]
+    algorithms = sorted({p['algorithm'] for d in datasets for p in d['points']})
+    algorithm_colors = dict(zip(algorithms, PALETTE))
+
+    for d in datasets:
+        print(f'({d["dataset"]}, {d["data type"]})')
+        print(tabulate([[p['algorithm'], p['threads'] if p['threads'] is not None else '-',
+                         *('{:,.2f} GB/s'.format(p[f'{o} GB/s']) for o in OPERATIONS)]
+                        for p in sorted(d['points'], key=lambda p: (p['algorithm'], p['threads'] or 0))],
+                       headers=['algorithm', 'threads', *OPERATIONS], stralign='right', disable_numparse=True))
+        print()
+
+    fig, axes = plt.subplots(len(datasets), len(OPERATIONS), figsize=(10, 3 * len(datasets)), squeeze=False)
+    fig.subplots_adjust(top=0.92, bottom=0.1, left=0.08, right=0.85, wspace=0.2, hspace=0.5)
+    for row, d in enumerate(datasets):
+        for col, operation in enumerate(OPERATIONS):
+            ax = axes[row, col]
+            for algo in algorithms:
+                points = sorted((p['threads'], p[f'{operation} GB/s']) for p in d['points']
+                                if p['algorithm'] == algo and p['threads'] is not None)
+                if points:
+                    threads, throughputs = zip(*points)
+                    # memcpy-mt is the memory-bandwidth roofline at each thread count
+                    ax.plot(threads, throughputs, color=algorithm_colors[algo], marker='o',
+                            linestyle='--' if algo == 'memcpy-mt' else '-')
+                for p in d['points']:
+                    if p['algorithm'] == algo and p['threads'] is None:
+                        ax.axhline(p[f'{operation} GB/s'], color=algorithm_colors[algo], linestyle=':')
+            ax.set_title(f'{d["dataset"]} {operation}')
+            ax.set_xlabel('number of threads')
+            ax.set_ylabel('mean uncompressed throughput [GB/s]')
+
+    fig.legend(
+        handles=[patches.Patch(color=c, label=a) for a, c in sorted(algorithm_colors.items(), key=itemgetter(0))],
+        loc='center right')
+
+    if output_pgf:
+        plt.savefig('sweep.pgf')
+    else:
+        plt.show()
+
+
 def main():
     parser = ArgumentParser(description='Visualize benchmark results')
     parser.add_argument('csv_files', metavar='CSVS', nargs='*', help='benchmark csv files')
     parser.add_argument('--scaling', action='store_true', help='plot scaling (default: throughput vs ratio)')
+    parser.add_argument('--sweep', action='store_true', help='plot JSON output of benchmark --sweep')
     parser.add_argument('--pgf', action='store_true', help='output pgfplots')
     args = parser.parse_args()
 
+    if args.sweep:
+        plot_sweep([json.load(f) for f in input_files(args.csv_files)], args.pgf)
+        return
+
     by_data_type_and_algorithm = defaultdict(lambda: defaultdict(lambda: defaultdict(lambda: defaultdict(list))))
     algorithms = set()
     for f in input_files(args.csv_files):
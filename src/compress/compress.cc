@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <io/io.hh>
@@ -12,42 +21,476 @@ namespace opts = boost::program_options;
 
 namespace ndzip::detail {
 
-enum class data_type { t_float, t_double };
+// Numeric values are stored in the container header, new types are appended
+enum class data_type {
+    t_float,
+    t_double,
+    t_float16,
+    t_bfloat16,
+    t_int8,
+    t_uint8,
+    t_int16,
+    t_uint16,
+    t_int32,
+    t_uint32,
+    num_data_types,
+};
+
+struct data_type_name {
+    data_type type;
+    const char *name;
+};
+
+constexpr data_type_name data_type_names[] = {
+        {data_type::t_float, "float"},
+        {data_type::t_double, "double"},
+        {data_type::t_float16, "float16"},
+        {data_type::t_bfloat16, "bfloat16"},
+        {data_type::t_int8, "int8"},
+        {data_type::t_uint8, "uint8"},
+        {data_type::t_int16, "int16"},
+        {data_type::t_uint16, "uint16"},
+        {data_type::t_int32, "int32"},
+        {data_type::t_uint32, "uint32"},
+};
+
+// Invokes f(T{}) for the element type T denoted by `type`
+template<typename F>
+void visit_data_type(data_type type, F &&f) {
+    switch (type) {
+        case data_type::t_float: return f(float{});
+        case data_type::t_double: return f(double{});
+        case data_type::t_float16: return f(float16{});
+        case data_type::t_bfloat16: return f(bfloat16{});
+        case data_type::t_int8: return f(int8_t{});
+        case data_type::t_uint8: return f(uint8_t{});
+        case data_type::t_int16: return f(int16_t{});
+        case data_type::t_uint16: return f(uint16_t{});
+        case data_type::t_int32: return f(int32_t{});
+        case data_type::t_uint32: return f(uint32_t{});
+        default: std::terminate();
+    }
+}
+
+// Container layout: a fixed-size file header, the compressed chunk streams back-to-back, an index holding the byte
+// offset of every chunk and finally a fixed-size footer locating the index. The footer is written last so that
+// compression can proceed on non-seekable outputs, while decompression needs a seekable input to locate the index.
+constexpr char container_magic[8] = {'N', 'D', 'Z', 'I', 'P', 'C', 'F', '\0'};
+// Version 2: borders of multi-dimensional chunks are compressed as one-dimensional streams
+// Version 3: chunks between keyframes may be stored as the difference to their predecessor
+// Version 4: records the hypercube size of the chunk streams
+// Version 5: chunk streams may contain constant and raw hypercubes, see detail::hypercube_encoding
+// Version 6: records the stream format version of the chunk streams, which depends on the build
+constexpr uint32_t container_version = 6;
+
+struct container_header {
+    char magic[8];
+    uint32_t version;
+    uint8_t data_type;
+    uint8_t dimensions;
+    uint16_t keyframe_interval;  // 0 or 1 if every chunk is compressed independently, see temporal_delta
+    uint64_t chunk_size[max_dimensionality];
+    uint8_t hypercube_size;  // ndzip::hypercube_size
+    uint8_t stream_format_version;  // ndzip::stream_format_version
+    uint8_t reserved[6];
+};
+
+struct container_footer {
+    uint64_t index_offset;
+    uint64_t num_chunks;
+    char magic[8];
+};
+
+static_assert(sizeof(container_header) % sizeof(uint64_t) == 0);
+static_assert(sizeof(container_footer) % sizeof(uint64_t) == 0);
+
+struct container_info {
+    data_type type;
+    ndzip::extent chunk_size;
+    ndzip::hypercube_size hypercube_size = ndzip::hypercube_size::standard;
+    size_t keyframe_interval = 0;
+    std::vector<uint64_t> chunk_offsets;  // num_chunks + 1 entries, the last one being the index offset
+};
+
+// The inverse of visit_data_type
+template<typename T>
+constexpr data_type data_type_of = data_type::num_data_types;
+template<>
+constexpr data_type data_type_of<float> = data_type::t_float;
+template<>
+constexpr data_type data_type_of<double> = data_type::t_double;
+template<>
+constexpr data_type data_type_of<float16> = data_type::t_float16;
+template<>
+constexpr data_type data_type_of<bfloat16> = data_type::t_bfloat16;
+template<>
+constexpr data_type data_type_of<int8_t> = data_type::t_int8;
+template<>
+constexpr data_type data_type_of<uint8_t> = data_type::t_uint8;
+template<>
+constexpr data_type data_type_of<int16_t> = data_type::t_int16;
+template<>
+constexpr data_type data_type_of<uint16_t> = data_type::t_uint16;
+template<>
+constexpr data_type data_type_of<int32_t> = data_type::t_int32;
+template<>
+constexpr data_type data_type_of<uint32_t> = data_type::t_uint32;
+
+void write_bytes(output_stream &out, size_t max_chunk_size, const void *data, size_t size) {
+    for (size_t offset = 0; offset < size;) {
+        const auto chunk_size = std::min(max_chunk_size, size - offset);
+        memcpy(out.get_write_buffer(), static_cast<const std::byte *>(data) + offset, chunk_size);
+        out.commit_chunk(chunk_size);
+        offset += chunk_size;
+    }
+}
+
+container_info read_container_info(random_access_input &in) {
+    if (in.size() < sizeof(container_header) + sizeof(container_footer)) {
+        throw io_error("Input is not an ndzip container (file too small)");
+    }
+
+    container_header header;
+    memcpy(&header, in.read_at(0, sizeof header), sizeof header);
+    if (memcmp(header.magic, container_magic, sizeof container_magic) != 0) {
+        throw io_error("Input is not an ndzip container (bad magic), use --raw for headerless streams");
+    }
+    if (header.version != container_version) {
+        throw io_error("Unsupported container version " + std::to_string(header.version));
+    }
+    if (header.data_type >= static_cast<uint8_t>(data_type::num_data_types) || header.dimensions < 1
+            || header.dimensions > max_dimensionality
+            || header.hypercube_size > static_cast<uint8_t>(ndzip::hypercube_size::larger)) {
+        throw io_error("Corrupted container header");
+    }
+    if (header.stream_format_version != ndzip::stream_format_version) {
+        throw io_error("Container holds streams of format version " + std::to_string(header.stream_format_version)
+                + ", but this build reads version " + std::to_string(ndzip::stream_format_version));
+    }
+
+    container_footer footer;
+    memcpy(&footer, in.read_at(in.size() - sizeof footer, sizeof footer), sizeof footer);
+    if (memcmp(footer.magic, container_magic, sizeof container_magic) != 0) {
+        throw io_error("Container footer is missing, the file might be truncated");
+    }
+    if (footer.index_offset < sizeof header || footer.index_offset > in.size() - sizeof footer
+            || footer.num_chunks != (in.size() - sizeof footer - footer.index_offset) / sizeof(uint64_t)) {
+        throw io_error("Corrupted container footer");
+    }
+
+    container_info info;
+    info.type = static_cast<data_type>(header.data_type);
+    info.chunk_size = ndzip::extent(header.dimensions);
+    info.hypercube_size = static_cast<ndzip::hypercube_size>(header.hypercube_size);
+    info.keyframe_interval = header.keyframe_interval;
+    for (dim_type d = 0; d < header.dimensions; ++d) {
+        if (header.chunk_size[d] == 0 || header.chunk_size[d] > std::numeric_limits<index_type>::max()) {
+            throw io_error("Corrupted container header");
+        }
+        info.chunk_size[d] = static_cast<index_type>(header.chunk_size[d]);
+    }
+    info.chunk_offsets.resize(footer.num_chunks + 1);
+    memcpy(info.chunk_offsets.data(), in.read_at(footer.index_offset, footer.num_chunks * sizeof(uint64_t)),
+            footer.num_chunks * sizeof(uint64_t));
+    info.chunk_offsets.back() = footer.index_offset;
+    for (size_t i = 0; i < footer.num_chunks; ++i) {
+        if (info.chunk_offsets[i] < sizeof header || info.chunk_offsets[i] > info.chunk_offsets[i + 1]) {
+            throw io_error("Corrupted container index");
+        }
+    }
+    return info;
+}
+
+// Temporal mode for time series, where successive chunks are consecutive timesteps of the same field. Every chunk except
+// each keyframe_interval-th one is compressed as the bitwise XOR with its predecessor, which leaves only the bits
+// that changed between timesteps and turns the stable high bit-planes into zero words. Keyframes are compressed as they
+// are, so decompressing a chunk range only needs to start at the keyframe preceding it. Chunks must be passed in order.
+// A keyframe interval of 0 or 1 makes every chunk a keyframe, in which case the compress tool does without a
+// temporal_delta altogether.
+template<typename T>
+class temporal_delta {
+  public:
+    using bits_type = ndzip::compressed_type<T>;
+
+    temporal_delta(size_t chunk_length, size_t keyframe_interval)
+        : _keyframe_interval(keyframe_interval), _previous(chunk_length), _delta(chunk_length) {
+        assert(keyframe_interval > 1);
+    }
+
+    bool is_keyframe(size_t chunk_index) const { return chunk_index % _keyframe_interval == 0; }
+
+    size_t preceding_keyframe(size_t chunk_index) const { return chunk_index - chunk_index % _keyframe_interval; }
+
+    // Returns the values to compress in place of `chunk`, which remain valid until the next call
+    const T *encode(size_t chunk_index, const T *chunk) {
+        const auto bits = reinterpret_cast<const bits_type *>(chunk);
+        if (is_keyframe(chunk_index)) {
+            std::copy(bits, bits + _previous.size(), _previous.begin());
+            return chunk;
+        }
+        if (is_keyframe(chunk_index + 1)) {
+            // Nothing is encoded against this chunk
+            for (size_t i = 0; i < _previous.size(); ++i) {
+                _delta[i] = bits[i] ^ _previous[i];
+            }
+        } else {
+            for (size_t i = 0; i < _previous.size(); ++i) {
+                _delta[i] = bits[i] ^ _previous[i];
+                _previous[i] = bits[i];
+            }
+        }
+        return reinterpret_cast<const T *>(_delta.data());
+    }
+
+    // Reconstructs a decompressed chunk in place
+    void decode(size_t chunk_index, T *chunk) {
+        const auto bits = reinterpret_cast<bits_type *>(chunk);
+        const auto next_is_keyframe = is_keyframe(chunk_index + 1);
+        if (is_keyframe(chunk_index)) {
+            std::copy(bits, bits + _previous.size(), _previous.begin());
+        } else if (next_is_keyframe) {
+            for (size_t i = 0; i < _previous.size(); ++i) {
+                bits[i] ^= _previous[i];
+            }
+        } else {
+            for (size_t i = 0; i < _previous.size(); ++i) {
+                bits[i] ^= _previous[i];
+                _previous[i] = bits[i];
+            }
+        }
+    }
+
+  private:
+    size_t _keyframe_interval;
+    std::vector<bits_type> _previous;
+    std::vector<bits_type> _delta;
+};
+
+struct chunk_range {
+    size_t first = 0;
+    std::optional<size_t> count;
+};
+
+struct stream_options {
+    bool raw = false;
+    size_t pipeline_depth = 0;
+    ndzip::thread_placement cpu_thread_placement = ndzip::thread_placement::any;
+    ndzip::lossy_precision precision;
+    ndzip::hypercube_size hypercube_size = ndzip::hypercube_size::standard;
+    size_t keyframe_interval = 0;
+};
+
+template<typename T>
+class blocking_queue {
+  public:
+    void push(T item) {
+        {
+            std::lock_guard lock{_mutex};
+            _items.push(std::move(item));
+        }
+        _cv.notify_one();
+    }
+
+    // returns std::nullopt once the queue has been closed
+    std::optional<T> pop() {
+        std::unique_lock lock{_mutex};
+        _cv.wait(lock, [&] { return _closed || !_items.empty(); });
+        if (_closed) { return std::nullopt; }
+        auto item = std::move(_items.front());
+        _items.pop();
+        return item;
+    }
+
+    void close() {
+        {
+            std::lock_guard lock{_mutex};
+            _closed = true;
+        }
+        _cv.notify_all();
+    }
+
+  private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::queue<T> _items;
+    bool _closed = false;
+};
+
+struct pipeline_slot {
+    std::vector<std::byte> input;
+    std::vector<std::byte> output;
+    const void *input_chunk = nullptr;  // points into `input` unless the input retains its chunks
+    size_t input_size = 0;
+    size_t output_size = 0;
+    kernel_duration duration{};
+};
+
+// Runs the read, process and write stages concurrently on a bounded ring of `depth` slots, so that I/O overlaps with
+// (de)compression. Slots pass through the stages in order. `read` returns false at the end of input. The first
+// exception thrown by any stage aborts the pipeline and is re-thrown to the caller. Inputs that retain their chunks
+// (see input_stream::retains_chunks) are passed to the process stage in place with an input_slot_size of 0.
+template<typename Read, typename Process, typename Write>
+void run_pipeline(size_t depth, size_t input_slot_size, size_t output_slot_size, const Read &read,
+        const Process &process, const Write &write) {
+    assert(depth > 0);
+
+    // nullptr signals the end of input
+    blocking_queue<pipeline_slot *> free_slots, read_slots, processed_slots;
+    std::vector<pipeline_slot> slots(depth);
+    for (auto &slot : slots) {
+        slot.input.resize(input_slot_size);
+        slot.output.resize(output_slot_size);
+        free_slots.push(&slot);
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto abort_pipeline = [&] {
+        {
+            std::lock_guard lock{error_mutex};
+            if (!error) { error = std::current_exception(); }
+        }
+        free_slots.close();
+        read_slots.close();
+        processed_slots.close();
+    };
+
+    std::thread reader([&] {
+        try {
+            while (const auto slot = free_slots.pop()) {
+                if (!read(**slot)) {
+                    read_slots.push(nullptr);
+                    break;
+                }
+                read_slots.push(*slot);
+            }
+        } catch (...) { abort_pipeline(); }
+    });
+
+    std::thread writer([&] {
+        try {
+            while (const auto slot = processed_slots.pop()) {
+                if (!*slot) { break; }
+                write(**slot);
+                free_slots.push(*slot);
+            }
+        } catch (...) { abort_pipeline(); }
+    });
+
+    try {
+        while (const auto slot = read_slots.pop()) {
+            if (*slot) { process(**slot); }
+            processed_slots.push(*slot);
+            if (!*slot) { break; }
+        }
+    } catch (...) { abort_pipeline(); }
+
+    reader.join();
+    writer.join();
+    if (error) { std::rethrow_exception(error); }
+}
 
 template<typename T>
 void compress_stream(const std::string &in, const std::string &out, const ndzip::extent &size,
-        ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io) {
+        ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io, const stream_options &options) {
     using compressed_type = ndzip::compressed_type<T>;
 
     const auto array_chunk_length = static_cast<size_t>(num_elements(size));
     const auto array_chunk_size = array_chunk_length * sizeof(T);
-    const auto max_compressed_chunk_length = ndzip::compressed_length_bound<T>(size);
+    const auto max_compressed_chunk_length = ndzip::compressed_length_bound<T>(size, options.hypercube_size);
     const auto max_compressed_chunk_size = max_compressed_chunk_length * sizeof(compressed_type);
+    const auto max_write_size = std::max(max_compressed_chunk_size, sizeof(container_header));
 
     size_t compressed_length = 0;
     size_t n_chunks = 0;
     kernel_duration total_duration{};
     {
         auto in_stream = io.create_input_stream(in, array_chunk_size);
-        auto out_stream = io.create_output_stream(out, max_compressed_chunk_size);
-
-        while (auto *chunk = in_stream->read_exact()) {
-            const auto input_buffer = static_cast<const T *>(chunk);
-            const auto write_buffer = static_cast<compressed_type *>(out_stream->get_write_buffer());
-            kernel_duration chunk_duration;
-            const auto compressed_chunk_length = offloader.compress(input_buffer, size, write_buffer, &chunk_duration);
-            const auto compressed_chunk_size = compressed_chunk_length * sizeof(compressed_type);
-            assert(compressed_chunk_length <= max_compressed_chunk_length);
-            out_stream->commit_chunk(compressed_chunk_size);
-            compressed_length += compressed_chunk_length;
+        auto out_stream = io.create_output_stream(out, max_write_size);
+
+        if (!options.raw) {
+            container_header header{};
+            memcpy(header.magic, container_magic, sizeof container_magic);
+            header.version = container_version;
+            header.data_type = static_cast<uint8_t>(data_type_of<T>);
+            header.dimensions = static_cast<uint8_t>(size.dimensions());
+            header.keyframe_interval = static_cast<uint16_t>(options.keyframe_interval);
+            header.hypercube_size = static_cast<uint8_t>(options.hypercube_size);
+            header.stream_format_version = static_cast<uint8_t>(ndzip::stream_format_version);
+            for (dim_type d = 0; d < size.dimensions(); ++d) {
+                header.chunk_size[d] = size[d];
+            }
+            write_bytes(*out_stream, max_write_size, &header, sizeof header);
+        }
+
+        std::optional<temporal_delta<T>> delta;
+        if (options.keyframe_interval > 1) { delta.emplace(array_chunk_length, options.keyframe_interval); }
+        const auto encode = [&](size_t chunk_index, const void *chunk) {
+            return delta ? delta->encode(chunk_index, static_cast<const T *>(chunk)) : static_cast<const T *>(chunk);
+        };
+
+        std::vector<uint64_t> chunk_offsets;
+        uint64_t file_offset = options.raw ? 0 : sizeof(container_header);
+        const auto record_chunk = [&](size_t compressed_chunk_size, kernel_duration chunk_duration) {
+            assert(compressed_chunk_size <= max_compressed_chunk_size);
+            chunk_offsets.push_back(file_offset);
+            file_offset += compressed_chunk_size;
+            compressed_length += compressed_chunk_size / sizeof(compressed_type);
             total_duration += chunk_duration;
             ++n_chunks;
+        };
+
+        if (options.pipeline_depth == 0) {
+            while (auto *chunk = in_stream->read_exact()) {
+                const auto input_buffer = encode(n_chunks, chunk);
+                const auto write_buffer = static_cast<compressed_type *>(out_stream->get_write_buffer());
+                kernel_duration chunk_duration;
+                const auto compressed_chunk_size
+                        = offloader.compress(input_buffer, size, write_buffer, &chunk_duration)
+                        * sizeof(compressed_type);
+                out_stream->commit_chunk(compressed_chunk_size);
+                record_chunk(compressed_chunk_size, chunk_duration);
+            }
+        } else {
+            size_t next_chunk_to_compress = 0;
+            const auto retains_chunks = in_stream->retains_chunks();
+            run_pipeline(
+                    options.pipeline_depth, retains_chunks ? 0 : array_chunk_size, max_compressed_chunk_size,
+                    [&](pipeline_slot &slot) {
+                        const auto *chunk = in_stream->read_exact();
+                        if (chunk && !retains_chunks) {
+                            memcpy(slot.input.data(), chunk, array_chunk_size);
+                            chunk = slot.input.data();
+                        }
+                        slot.input_chunk = chunk;
+                        return chunk != nullptr;
+                    },
+                    [&](pipeline_slot &slot) {
+                        const auto input_buffer = encode(next_chunk_to_compress++, slot.input_chunk);
+                        slot.output_size = offloader.compress(input_buffer, size,
+                                                   reinterpret_cast<compressed_type *>(slot.output.data()),
+                                                   &slot.duration)
+                                * sizeof(compressed_type);
+                    },
+                    [&](const pipeline_slot &slot) {
+                        write_bytes(*out_stream, max_write_size, slot.output.data(), slot.output_size);
+                        record_chunk(slot.output_size, slot.duration);
+                    });
+        }
+
+        if (!options.raw) {
+            write_bytes(*out_stream, max_write_size, chunk_offsets.data(), chunk_offsets.size() * sizeof(uint64_t));
+            container_footer footer{};
+            footer.index_offset = file_offset;
+            footer.num_chunks = n_chunks;
+            memcpy(footer.magic, container_magic, sizeof container_magic);
+            write_bytes(*out_stream, max_write_size, &footer, sizeof footer);
         }
     }
 
     const auto in_file_size = n_chunks * array_chunk_size;
     const auto compressed_size = compressed_length * sizeof(compressed_type);
-    std::cerr << "raw = " << n_chunks * in_file_size << " bytes";
+    std::cerr << "raw = " << in_file_size << " bytes";
     if (n_chunks > 1) { std::cerr << " (" << n_chunks << " chunks à " << array_chunk_size << " bytes)"; }
     std::cerr << ", compressed = " << compressed_size << " bytes";
     std::cerr << ", ratio = " << std::fixed << std::setprecision(4)
@@ -57,13 +500,13 @@ void compress_stream(const std::string &in, const std::string &out, const ndzip:
 }
 
 template<typename T>
-void decompress_stream(const std::string &in, const std::string &out, const ndzip::extent &size,
-        ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io) {
+void decompress_raw_stream(const std::string &in, const std::string &out, const ndzip::extent &size,
+        ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io, const stream_options &options) {
     using compressed_type = ndzip::compressed_type<T>;
 
     const auto array_chunk_length = static_cast<size_t>(num_elements(size));
     const auto array_chunk_size = array_chunk_length * sizeof(T);
-    const auto max_compressed_chunk_length = ndzip::compressed_length_bound<T>(size);
+    const auto max_compressed_chunk_length = ndzip::compressed_length_bound<T>(size, options.hypercube_size);
     const auto max_compressed_chunk_size = max_compressed_chunk_length * sizeof(compressed_type);
 
     const auto in_stream = io.create_input_stream(in, max_compressed_chunk_size);
@@ -86,38 +529,143 @@ void decompress_stream(const std::string &in, const std::string &out, const ndzi
 }
 
 template<typename T>
-void process_stream(bool decompress, const std::string &in, const std::string &out, const ndzip::extent &size,
-        ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io) {
-    if (decompress) {
-        decompress_stream(in, out, size, offloader, io);
+void decompress_container(random_access_input &in_file, const container_info &info, const chunk_range &range,
+        const std::string &out, ndzip::offloader<T> &offloader, const ndzip::detail::io_factory &io,
+        const stream_options &options) {
+    using compressed_type = ndzip::compressed_type<T>;
+
+    const auto &size = info.chunk_size;
+    const auto array_chunk_size = static_cast<size_t>(num_elements(size)) * sizeof(T);
+    const auto max_compressed_chunk_size
+            = ndzip::compressed_length_bound<T>(size, info.hypercube_size) * sizeof(compressed_type);
+    const auto num_chunks = info.chunk_offsets.size() - 1;
+    if (range.first > num_chunks || (range.count && *range.count > num_chunks - range.first)) {
+        throw io_error("Chunk range exceeds the " + std::to_string(num_chunks) + " chunks in the container");
+    }
+    const auto end = range.count ? range.first + *range.count : num_chunks;
+
+    // Chunks from the preceding keyframe up to range.first are only decompressed to reconstruct their successors
+    std::optional<temporal_delta<T>> delta;
+    if (info.keyframe_interval > 1) { delta.emplace(static_cast<size_t>(num_elements(size)), info.keyframe_interval); }
+    const auto begin = delta ? delta->preceding_keyframe(range.first) : range.first;
+
+    const auto read_chunk = [&](size_t chunk_index) {
+        const auto chunk_size = info.chunk_offsets[chunk_index + 1] - info.chunk_offsets[chunk_index];
+        if (chunk_size > max_compressed_chunk_size) {
+            throw io_error("Chunk " + std::to_string(chunk_index) + " exceeds the maximum compressed chunk size");
+        }
+        return std::pair{in_file.read_at(info.chunk_offsets[chunk_index], chunk_size), chunk_size};
+    };
+
+    const auto decompress_chunk = [&](size_t chunk_index, const void *chunk, size_t chunk_size, void *output) {
+        const auto compressed_length = offloader.decompress(static_cast<const compressed_type *>(chunk),
+                chunk_size / sizeof(compressed_type), static_cast<T *>(output), size);
+        if (compressed_length * sizeof(compressed_type) != chunk_size) {
+            throw io_error("Chunk " + std::to_string(chunk_index) + " does not match its index entry");
+        }
+        if (delta) { delta->decode(chunk_index, static_cast<T *>(output)); }
+    };
+
+    const auto out_stream = io.create_output_stream(out, array_chunk_size);
+    if (options.pipeline_depth == 0) {
+        std::vector<std::byte> skipped_chunk(begin < range.first ? array_chunk_size : 0);
+        for (size_t i = begin; i < end; ++i) {
+            const auto [chunk, chunk_size] = read_chunk(i);
+            if (i < range.first) {
+                decompress_chunk(i, chunk, chunk_size, skipped_chunk.data());
+            } else {
+                decompress_chunk(i, chunk, chunk_size, out_stream->get_write_buffer());
+                out_stream->commit_chunk(array_chunk_size);
+            }
+        }
     } else {
-        compress_stream(in, out, size, offloader, io);
+        size_t next_chunk_to_read = begin;
+        size_t next_chunk_to_decompress = begin;
+        size_t next_chunk_to_write = begin;
+        const auto retains_chunks = in_file.retains_chunks();
+        run_pipeline(
+                options.pipeline_depth, retains_chunks ? 0 : max_compressed_chunk_size, array_chunk_size,
+                [&](pipeline_slot &slot) {
+                    if (next_chunk_to_read == end) { return false; }
+                    const auto [chunk, chunk_size] = read_chunk(next_chunk_to_read++);
+                    if (retains_chunks) {
+                        slot.input_chunk = chunk;
+                    } else {
+                        memcpy(slot.input.data(), chunk, chunk_size);
+                        slot.input_chunk = slot.input.data();
+                    }
+                    slot.input_size = chunk_size;
+                    return true;
+                },
+                [&](pipeline_slot &slot) {
+                    decompress_chunk(next_chunk_to_decompress++, slot.input_chunk, slot.input_size,
+                            slot.output.data());
+                },
+                [&](const pipeline_slot &slot) {
+                    if (next_chunk_to_write++ >= range.first) {
+                        write_bytes(*out_stream, array_chunk_size, slot.output.data(), array_chunk_size);
+                    }
+                });
     }
 }
 
+template<typename T>
+std::unique_ptr<ndzip::offloader<T>> make_offloader(const ndzip::extent &size, ndzip::target target,
+        std::optional<size_t> num_cpu_threads, const stream_options &options) {
+    const auto placement = options.cpu_thread_placement;
+    if (target == ndzip::target::cpu
+            && (num_cpu_threads.has_value() || placement != ndzip::thread_placement::any
+                    || !options.precision.is_lossless() || options.hypercube_size != ndzip::hypercube_size::standard)) {
+        return ndzip::make_cpu_offloader<T>(size.dimensions(), num_cpu_threads.value_or(0), placement,
+                options.precision, options.hypercube_size);
+    } else {
+        return ndzip::make_offloader<T>(target, size.dimensions(), true /* enable_profiling */);
+    }
+}
+
+template<typename T>
+void decompress_container(random_access_input &in_file, const container_info &info, const chunk_range &range,
+        const std::string &out, ndzip::target target, std::optional<size_t> num_cpu_threads,
+        const ndzip::detail::io_factory &io, const stream_options &options) {
+    auto container_options = options;
+    container_options.hypercube_size = info.hypercube_size;
+    if (target != ndzip::target::cpu && info.hypercube_size != ndzip::hypercube_size::standard) {
+        throw io_error("Containers of a non-standard hypercube size can only be decompressed with -e cpu");
+    }
+    auto offloader = make_offloader<T>(info.chunk_size, target, num_cpu_threads, container_options);
+    decompress_container(in_file, info, range, out, *offloader, io, container_options);
+}
+
+void decompress_container(const chunk_range &range, ndzip::target target, std::optional<size_t> num_cpu_threads,
+        const std::string &in, const std::string &out, const ndzip::detail::io_factory &io,
+        const stream_options &options) {
+    const auto in_file = io.create_random_access_input(in);
+    const auto info = read_container_info(*in_file);
+    visit_data_type(info.type, [&](auto value) {
+        using value_type = decltype(value);
+        decompress_container<value_type>(*in_file, info, range, out, target, num_cpu_threads, io, options);
+    });
+}
+
 template<typename T>
 void process_stream(bool decompress, const ndzip::extent &size, ndzip::target target,
         std::optional<size_t> num_cpu_threads, const std::string &in, const std::string &out,
-        const ndzip::detail::io_factory &io) {
-    std::unique_ptr<ndzip::offloader<T>> offloader;
-    if (target == ndzip::target::cpu && num_cpu_threads.has_value()) {
-        offloader = ndzip::make_cpu_offloader<T>(size.dimensions(), *num_cpu_threads);
+        const ndzip::detail::io_factory &io, const stream_options &options) {
+    auto offloader = make_offloader<T>(size, target, num_cpu_threads, options);
+    if (decompress) {
+        decompress_raw_stream(in, out, size, *offloader, io, options);
     } else {
-        offloader = ndzip::make_offloader<T>(target, size.dimensions(), true /* enable_profiling */);
+        compress_stream(in, out, size, *offloader, io, options);
     }
-    process_stream(decompress, in, out, size, *offloader, io);
 }
 
 void process_stream(bool decompress, const ndzip::extent &size, ndzip::target target,
         std::optional<size_t> num_cpu_threads, const data_type &data_type, const std::string &in,
-        const std::string &out, const ndzip::detail::io_factory &io) {
-    switch (data_type) {
-        case detail::data_type::t_float:
-            return process_stream<float>(decompress, size, target, num_cpu_threads, in, out, io);
-        case detail::data_type::t_double:
-            return process_stream<double>(decompress, size, target, num_cpu_threads, in, out, io);
-        default: std::terminate();
-    }
+        const std::string &out, const ndzip::detail::io_factory &io, const stream_options &options) {
+    visit_data_type(data_type, [&](auto value) {
+        using value_type = decltype(value);
+        process_stream<value_type>(decompress, size, target, num_cpu_threads, in, out, io, options);
+    });
 }
 
 }  // namespace ndzip::detail
@@ -127,12 +675,20 @@ int main(int argc, char **argv) {
 
     bool decompress = false;
     bool no_mmap = false;
+    bool io_uring = false;
+    ndzip::detail::stream_options stream_options;
+    size_t first_chunk = 0;
+    size_t num_chunks_or_0 = 0;
     std::vector<ndzip::index_type> size_components;
     std::string input = "-";
     std::string output = "-";
     std::string data_type_str = "float";
     std::string target_str = "cpu";
     size_t num_threads_or_0 = 0;
+    bool numa = false;
+    std::optional<unsigned> mantissa_bits;
+    std::optional<double> max_abs_error;
+    std::string hypercube_size_str = "standard";
 
     auto usage = "Usage: "s + argv[0] + " [options]\n\n";
 
@@ -141,9 +697,11 @@ int main(int argc, char **argv) {
     desc.add_options()
         ("help", "show this help")
         ("decompress,d", opts::bool_switch(&decompress), "decompress (default compress)")
-        ("array-size,n", opts::value(&size_components)->required()->multitoken(),
-                "array size (one value per dimension, first-major)")
-        ("data-type,t", opts::value(&data_type_str), "float|double (default float)")
+        ("array-size,n", opts::value(&size_components)->multitoken(),
+                "array size (one value per dimension, first-major), not needed for decompressing a container")
+        ("data-type,t", opts::value(&data_type_str), "float|double|float16|bfloat16|int8|uint8|int16|uint16|int32|"
+                "uint32 (default float, types other than float and double require -e cpu), not needed for "
+                "decompressing a container")
         ("target_str,e", opts::value(&target_str), "cpu"
 #if NDZIP_HIPSYCL_SUPPORT
                                              "|sycl"
@@ -153,15 +711,35 @@ int main(int argc, char **argv) {
 #endif
                                              " (default cpu)")
         ("threads,T", opts::value(&num_threads_or_0), "number of CPU threads")
+        ("numa", opts::bool_switch(&numa), "pin CPU threads to OMP_PLACES and keep their memory NUMA-local")
+        ("mantissa-bits", opts::value<unsigned>()->notifier([&](unsigned b) { mantissa_bits = b; }),
+                "lossy: keep only this many explicit mantissa bits of every value (CPU target only)")
+        ("max-abs-error", opts::value<double>()->notifier([&](double e) { max_abs_error = e; }),
+                "lossy: keep every value within less than this absolute error (CPU target only)")
         ("input,i", opts::value(&input), "input file (default '-' is stdin)")
         ("output,o", opts::value(&output), "output file (default '-' is stdout)")
-        ("no-mmap", opts::bool_switch(&no_mmap), "do not use memory-mapped I/O");
+        ("no-mmap", opts::bool_switch(&no_mmap), "do not use memory-mapped I/O")
+#if NDZIP_SUPPORT_IO_URING
+        ("io-uring", opts::bool_switch(&io_uring), "read and write files through io_uring with O_DIRECT, bypassing "
+                "the page cache (requires -i <file> and -o <file>)")
+#endif
+        ("raw", opts::bool_switch(&stream_options.raw), "read / write headerless concatenated streams instead of a container")
+        ("first-chunk", opts::value(&first_chunk), "index of the first chunk to decompress from a container")
+        ("num-chunks", opts::value(&num_chunks_or_0), "number of chunks to decompress from a container "
+                "(default all)")
+        ("hypercube-size", opts::value(&hypercube_size_str), "standard|smaller|larger (default standard, others "
+                "require -e cpu and -t float|double), not needed for decompressing a container")
+        ("keyframe-interval", opts::value(&stream_options.keyframe_interval), "temporal mode for time series: "
+                "compress all but every k-th chunk as the difference to the preceding chunk (default 0 = off)")
+        ("pipeline-depth", opts::value(&stream_options.pipeline_depth), "number of chunks in flight between "
+                "concurrent reader, codec and writer threads (default 0 = no pipelining, not supported for --raw "
+                "decompression)");
     // clang-format on
 
     opts::variables_map vars;
     ndzip::target target;
     ndzip::extent size;
-    ndzip::detail::data_type data_type;
+    ndzip::detail::data_type data_type = ndzip::detail::data_type::t_float;
     std::optional<size_t> opt_num_threads;
     try {
         auto parsed = opts::command_line_parser(argc, argv).options(desc).run();
@@ -188,23 +766,81 @@ int main(int argc, char **argv) {
             throw opts::error{"Unimplemented target " + target_str};
         }
 
-        if (size_components.empty() || size_components.size() > 3) {
-            throw opts::error{"Expected between 1 and 3 dimensions, got " + std::to_string(size_components.size())};
+        if (!decompress || stream_options.raw) {
+            if (size_components.empty() || size_components.size() > 3) {
+                throw opts::error{
+                        "Expected between 1 and 3 dimensions, got " + std::to_string(size_components.size())};
+            }
+            size = ndzip::extent(static_cast<ndzip::dim_type>(size_components.size()));
+            for (ndzip::dim_type d = 0; d < size.dimensions(); ++d) {
+                size[d] = size_components[d];
+            }
+
+            const auto named_type = std::find_if(std::begin(ndzip::detail::data_type_names),
+                    std::end(ndzip::detail::data_type_names),
+                    [&](const auto &entry) { return entry.name == data_type_str; });
+            if (named_type == std::end(ndzip::detail::data_type_names)) {
+                throw opts::error{"Invalid data type " + data_type_str};
+            }
+            data_type = named_type->type;
+
+            if (hypercube_size_str == "smaller") {
+                stream_options.hypercube_size = ndzip::hypercube_size::smaller;
+            } else if (hypercube_size_str == "larger") {
+                stream_options.hypercube_size = ndzip::hypercube_size::larger;
+            } else if (hypercube_size_str != "standard") {
+                throw opts::error{"Invalid hypercube size " + hypercube_size_str};
+            }
+            if (stream_options.hypercube_size != ndzip::hypercube_size::standard
+                    && (target != ndzip::target::cpu
+                            || (data_type != ndzip::detail::data_type::t_float
+                                    && data_type != ndzip::detail::data_type::t_double))) {
+                throw opts::error{"--hypercube-size " + hypercube_size_str + " requires -e cpu and -t float|double"};
+            }
+        } else if (vars.count("hypercube-size")) {
+            throw opts::error{"--hypercube-size is recorded in the container and not needed for decompressing it"};
         }
-        size = ndzip::extent(static_cast<ndzip::dim_type>(size_components.size()));
-        for (ndzip::dim_type d = 0; d < size.dimensions(); ++d) {
-            size[d] = size_components[d];
+
+        if ((!decompress || stream_options.raw) && (vars.count("first-chunk") || num_chunks_or_0 != 0)) {
+            throw opts::error{"--first-chunk and --num-chunks only apply when decompressing a container"};
         }
 
-        if (data_type_str == "float") {
-            data_type = ndzip::detail::data_type::t_float;
-        } else if (data_type_str == "double") {
-            data_type = ndzip::detail::data_type::t_double;
-        } else {
-            throw opts::error{"Invalid data type " + data_type_str};
+        if (mantissa_bits || max_abs_error) {
+            if (decompress) { throw opts::error{"--mantissa-bits and --max-abs-error only apply to compression"}; }
+            if (target != ndzip::target::cpu) {
+                throw opts::error{"--mantissa-bits and --max-abs-error require -e cpu"};
+            }
+            if (mantissa_bits && max_abs_error) {
+                throw opts::error{"--mantissa-bits and --max-abs-error are mutually exclusive"};
+            }
+            if (max_abs_error && !(*max_abs_error > 0)) { throw opts::error{"--max-abs-error must be positive"}; }
+            stream_options.precision = mantissa_bits ? ndzip::lossy_precision::mantissa_bits(*mantissa_bits)
+                                                     : ndzip::lossy_precision::absolute_error(*max_abs_error);
+        }
+
+        if (stream_options.keyframe_interval != 0) {
+            if (decompress || stream_options.raw) {
+                throw opts::error{"--keyframe-interval only applies to compressing a container"};
+            }
+            if (stream_options.keyframe_interval > std::numeric_limits<uint16_t>::max()) {
+                throw opts::error{"--keyframe-interval must not exceed "
+                        + std::to_string(std::numeric_limits<uint16_t>::max())};
+            }
+            // Truncating differences would let the error of every chunk accumulate up to the next keyframe
+            if (!stream_options.precision.is_lossless()) {
+                throw opts::error{"--keyframe-interval cannot be combined with lossy compression"};
+            }
+        }
+
+        if (io_uring) {
+            if (no_mmap) { throw opts::error{"--io-uring and --no-mmap are mutually exclusive"}; }
+            if (input.empty() || input == "-" || output.empty() || output == "-") {
+                throw opts::error{"--io-uring requires an input and an output file"};
+            }
         }
 
         if (num_threads_or_0 != 0) { opt_num_threads = num_threads_or_0; }
+        if (numa) { stream_options.cpu_thread_placement = ndzip::thread_placement::numa; }
 
     } catch (opts::error &e) {
         std::cerr << e.what() << "\n\n" << usage << desc;
@@ -212,13 +848,25 @@ int main(int argc, char **argv) {
     }
 
     std::unique_ptr<ndzip::detail::io_factory> io_factory;
+#if NDZIP_SUPPORT_IO_URING
+    if (io_uring) { io_factory = std::make_unique<ndzip::detail::io_uring_io_factory>(); }
+#endif
 #if NDZIP_SUPPORT_MMAP
-    if (!no_mmap) { io_factory = std::make_unique<ndzip::detail::mmap_io_factory>(); }
+    if (!io_factory && !no_mmap) { io_factory = std::make_unique<ndzip::detail::mmap_io_factory>(); }
 #endif
     if (!io_factory) { io_factory = std::make_unique<ndzip::detail::stdio_io_factory>(); }
 
     try {
-        ndzip::detail::process_stream(decompress, size, target, opt_num_threads, data_type, input, output, *io_factory);
+        if (decompress && !stream_options.raw) {
+            ndzip::detail::chunk_range range;
+            range.first = first_chunk;
+            if (num_chunks_or_0 != 0) { range.count = num_chunks_or_0; }
+            ndzip::detail::decompress_container(
+                    range, target, opt_num_threads, input, output, *io_factory, stream_options);
+        } else {
+            ndzip::detail::process_stream(
+                    decompress, size, target, opt_num_threads, data_type, input, output, *io_factory, stream_options);
+        }
         return EXIT_SUCCESS;
     } catch (opts::error &e) {
         std::cerr << e.what() << "\n\n" << usage << desc;
@@ -0,0 +1,271 @@
+#include "ubench.hh"
+
+#include <ndzip/cpu_codec.inl>
+#include <test/test_utils.hh>
+
+#include <cmath>
+
+using namespace ndzip;
+using namespace ndzip::detail;
+
+
+#define ALL_PROFILES (profile<DATA_TYPE, DIMENSIONS>)
+
+// Every translation unit benchmarks the kernels of one ISA level (see NDZIP_CPU_ISAS), which is part of the test name
+#define UBENCH_STRINGIFY_EXPAND(x) #x
+#define UBENCH_STRINGIFY(x) UBENCH_STRINGIFY_EXPAND(x)
+#define UBENCH_ISA UBENCH_STRINGIFY(NDZIP_CPU_ISA_NAMESPACE)
+
+
+namespace {
+
+// Enough hypercubes to amortize the timer, few enough to stay mostly within the last-level cache
+constexpr index_type n_blocks = 256;
+
+enum class bit_distribution {
+    smooth,  // block-transformed residuals of a smooth field, as the encoder sees them for typical simulation data
+    random,  // uniformly random bits, which leave no zero words to compact
+    zero,    // all-zero hypercubes, which take the fast paths of the encoder and decoder
+};
+
+constexpr bit_distribution all_bit_distributions[] = {
+        bit_distribution::smooth, bit_distribution::random, bit_distribution::zero};
+
+const char *to_string(bit_distribution dist) {
+    switch (dist) {
+        case bit_distribution::smooth: return "smooth";
+        case bit_distribution::random: return "random";
+        case bit_distribution::zero: return "zero";
+    }
+    return "unknown";
+}
+
+bool host_supports_isa() {
+#ifdef NDZIP_CPU_ISA
+    const auto isas = cpu::supported_isas();
+    return std::find(isas.begin(), isas.end(), cpu::isa::NDZIP_CPU_ISA) != isas.end();
+#else
+    return true;
+#endif
+}
+
+template<typename Profile>
+constexpr size_t num_words = size_t{n_blocks} * ipow(Profile::hypercube_side_length, Profile::dimensions);
+
+template<typename Profile>
+cpu::simd_aligned_buffer<typename Profile::bits_type> make_hypercubes(bit_distribution dist) {
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+    constexpr auto hc_size = ipow(Profile::hypercube_side_length, Profile::dimensions);
+
+    cpu::simd_aligned_buffer<bits_type> cubes(num_words<Profile>);
+    if (dist == bit_distribution::smooth) {
+        for (size_t i = 0; i < num_words<Profile>; ++i) {
+            const auto x = static_cast<double>(i);
+            cubes[i] = bit_cast<bits_type>(static_cast<value_type>(100 * std::sin(0.001 * x) + std::cos(0.037 * x)));
+        }
+        for (index_type hc_index = 0; hc_index < n_blocks; ++hc_index) {
+            cpu::block_transform<Profile>(cubes.data() + size_t{hc_index} * hc_size);
+        }
+    } else if (dist == bit_distribution::random) {
+        const auto random = make_random_vector<bits_type>(num_words<Profile>);
+        std::copy(random.begin(), random.end(), cubes.data());
+    } else {
+        std::fill_n(cubes.data(), num_words<Profile>, bits_type{0});
+    }
+    return cubes;
+}
+
+}  // namespace
+
+
+// The per-group kernels are always_inline and must be inlined into code compiled for the same ISA level
+#ifdef NDZIP_CPU_TARGET
+#ifdef __clang__
+NDZIP_CPU_PRAGMA(clang attribute push(__attribute__((target(NDZIP_CPU_TARGET))), apply_to = function))
+#else
+#pragma GCC push_options
+NDZIP_CPU_PRAGMA(GCC target(NDZIP_CPU_TARGET))
+#endif
+#endif
+
+namespace {
+
+template<typename Bits>
+[[gnu::noinline]] void transpose_all_trivial(const Bits *in, Bits *out, size_t n_words) {
+    for (size_t i = 0; i < n_words; i += bits_of<Bits>) {
+        cpu::transpose_bits_trivial(in + i, out + i);
+    }
+}
+
+template<typename Bits>
+[[gnu::noinline]] void transpose_all(const Bits *in, Bits *out, size_t n_words) {
+    for (size_t i = 0; i < n_words; i += bits_of<Bits>) {
+        cpu::transpose_bits(in + i, out + i);
+    }
+}
+
+template<typename Bits>
+[[gnu::noinline]] void generate_all_zero_maps(const Bits *in, Bits *heads, size_t n_words) {
+    for (size_t i = 0; i < n_words; i += bits_of<Bits>) {
+        heads[i / bits_of<Bits>] = cpu::generate_zero_map(in + i);
+    }
+}
+
+template<typename Bits>
+[[gnu::noinline]] size_t compact_all(const Bits *transposed, std::byte *out, size_t n_words) {
+    size_t pos = 0;
+    for (size_t i = 0; i < n_words; i += bits_of<Bits>) {
+        pos += cpu::compact_zero_words(transposed + i, out + pos);
+    }
+    return pos;
+}
+
+template<typename Bits>
+[[gnu::noinline]] size_t expand_all(const std::byte *in, const Bits *heads, Bits *transposed, size_t n_words) {
+    size_t pos = 0;
+    for (size_t i = 0; i < n_words; i += bits_of<Bits>) {
+        pos += cpu::expand_zero_words(in + pos, transposed + i, heads[i / bits_of<Bits>]);
+    }
+    return pos;
+}
+
+}  // namespace
+
+#ifdef NDZIP_CPU_TARGET
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+
+TEMPLATE_TEST_CASE("Bit transposition (" UBENCH_ISA ")", "[transpose]", ALL_PROFILES) {
+    if (!host_supports_isa()) {
+        WARN("host does not support " UBENCH_ISA);
+        return;
+    }
+
+    using bits_type = typename TestType::bits_type;
+    constexpr auto n_words = num_words<TestType>;
+    constexpr auto n_bytes = n_words * sizeof(bits_type);
+
+    // Transposition does not branch on the data
+    const auto cubes = make_hypercubes<TestType>(bit_distribution::smooth);
+    cpu::simd_aligned_buffer<bits_type> transposed(n_words);
+
+    CPU_BENCHMARK("Trivial", n_bytes) {
+        transpose_all_trivial(cubes.data(), transposed.data(), n_words);
+        black_hole(transposed);
+    };
+
+    CPU_BENCHMARK("Dispatched", n_bytes) {
+        transpose_all(cubes.data(), transposed.data(), n_words);
+        black_hole(transposed);
+    };
+}
+
+
+TEMPLATE_TEST_CASE("Block transform (" UBENCH_ISA ")", "[transform]", ALL_PROFILES) {
+    if (!host_supports_isa()) {
+        WARN("host does not support " UBENCH_ISA);
+        return;
+    }
+
+    using bits_type = typename TestType::bits_type;
+    constexpr auto hc_size = ipow(TestType::hypercube_side_length, TestType::dimensions);
+    constexpr auto n_bytes = num_words<TestType> * sizeof(bits_type);
+
+    // The transforms are applied in place over and over, which is fine since they do not branch on the data either
+    auto cubes = make_hypercubes<TestType>(bit_distribution::smooth);
+
+    CPU_BENCHMARK("Forward", n_bytes) {
+        for (index_type hc_index = 0; hc_index < n_blocks; ++hc_index) {
+            cpu::block_transform<TestType>(cubes.data() + size_t{hc_index} * hc_size);
+        }
+        black_hole(cubes);
+    };
+
+    CPU_BENCHMARK("Inverse", n_bytes) {
+        for (index_type hc_index = 0; hc_index < n_blocks; ++hc_index) {
+            cpu::inverse_block_transform<TestType>(cubes.data() + size_t{hc_index} * hc_size);
+        }
+        black_hole(cubes);
+    };
+}
+
+
+TEMPLATE_TEST_CASE("Zero-word compaction (" UBENCH_ISA ")", "[zero_words]", ALL_PROFILES) {
+    if (!host_supports_isa()) {
+        WARN("host does not support " UBENCH_ISA);
+        return;
+    }
+
+    using bits_type = typename TestType::bits_type;
+    constexpr auto n_words = num_words<TestType>;
+    constexpr auto n_bytes = n_words * sizeof(bits_type);
+
+    for (auto dist : all_bit_distributions) {
+        const auto cubes = make_hypercubes<TestType>(dist);
+        cpu::simd_aligned_buffer<bits_type> heads(n_words / bits_of<bits_type>);
+        cpu::simd_aligned_buffer<bits_type> transposed(n_words);
+        cpu::simd_aligned_buffer<bits_type> expanded(n_words);
+        cpu::simd_aligned_buffer<std::byte> compact(n_bytes);
+        transpose_all(cubes.data(), transposed.data(), n_words);
+
+        CPU_BENCHMARK(std::string{"Zero map, "} + to_string(dist), n_bytes) {
+            generate_all_zero_maps(cubes.data(), heads.data(), n_words);
+            black_hole(heads);
+        };
+
+        size_t compact_length = 0;
+        CPU_BENCHMARK(std::string{"Compact, "} + to_string(dist), n_bytes) {
+            compact_length = compact_all(transposed.data(), compact.data(), n_words);
+            black_hole(compact);
+        };
+
+        CPU_BENCHMARK(std::string{"Expand, "} + to_string(dist), n_bytes) {
+            const auto expand_length = expand_all(compact.data(), heads.data(), expanded.data(), n_words);
+            black_hole(expanded);
+            assert(expand_length == compact_length);
+            (void) expand_length;
+        };
+    }
+}
+
+
+TEMPLATE_TEST_CASE("Zero-bit encoding (" UBENCH_ISA ")", "[encode]", ALL_PROFILES) {
+    if (!host_supports_isa()) {
+        WARN("host does not support " UBENCH_ISA);
+        return;
+    }
+
+    using bits_type = typename TestType::bits_type;
+    constexpr auto hc_size = ipow(TestType::hypercube_side_length, TestType::dimensions);
+    constexpr auto n_bytes = num_words<TestType> * sizeof(bits_type);
+    // Every hypercube is encoded into a slot of its own that holds the heads and all words of an incompressible cube
+    constexpr size_t slot_bytes = (hc_size + hc_size / bits_of<bits_type>) * sizeof(bits_type);
+
+    for (auto dist : all_bit_distributions) {
+        const auto cubes = make_hypercubes<TestType>(dist);
+        cpu::simd_aligned_buffer<std::byte> stream(n_blocks * slot_bytes);
+        cpu::simd_aligned_buffer<bits_type> decoded(num_words<TestType>);
+
+        CPU_BENCHMARK(std::string{"Encode, "} + to_string(dist), n_bytes) {
+            for (index_type hc_index = 0; hc_index < n_blocks; ++hc_index) {
+                cpu::zero_bit_encode(cubes.data() + size_t{hc_index} * hc_size,
+                        stream.data() + size_t{hc_index} * slot_bytes, hc_size);
+            }
+            black_hole(stream);
+        };
+
+        CPU_BENCHMARK(std::string{"Decode, "} + to_string(dist), n_bytes) {
+            for (index_type hc_index = 0; hc_index < n_blocks; ++hc_index) {
+                cpu::zero_bit_decode(stream.data() + size_t{hc_index} * slot_bytes,
+                        decoded.data() + size_t{hc_index} * hc_size, hc_size);
+            }
+            black_hole(decoded);
+        };
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+// Every run of a CPU benchmark processes `bytes` bytes of uncompressed data. Runs are timed on the host clock like
+// SYCL_BENCHMARK times kernels through profiling events, and the mean throughput in GB/s is appended to the name,
+// since Catch reports times only.
+struct CpuBenchmark {
+    std::string name;
+    size_t bytes;
+};
+
+template<typename Lambda>
+void operator<<=(CpuBenchmark &&bench, Lambda &&lambda) {
+    Catch::IConfigPtr cfg = Catch::getCurrentContext().getConfig();
+    size_t warmup_runs = cfg->benchmarkWarmupTime() < std::chrono::milliseconds(1) ? 0 : 1;
+
+    using duration = std::chrono::duration<double, std::nano>;
+    Catch::Benchmark::Environment<duration> env{{duration{100}, {}}, {duration{0.0}, {}}};
+
+    std::vector<duration> samples(static_cast<size_t>(cfg->benchmarkSamples()));
+    for (size_t i = 0; i < warmup_runs + samples.size(); ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        lambda();
+        const auto end = std::chrono::steady_clock::now();
+        if (i >= warmup_runs) { samples[i - warmup_runs] = std::chrono::duration_cast<duration>(end - start); }
+    }
+
+    auto analysis = Catch::Benchmark::Detail::analyse(*cfg, env, samples.begin(), samples.end());
+
+    char throughput[32];
+    const auto bytes_per_ns = static_cast<double>(bench.bytes) / analysis.mean.point.count();
+    snprintf(throughput, sizeof throughput, " (%.2f GB/s)", bytes_per_ns);
+    auto name = bench.name + throughput;
+
+    Catch::getResultCapture().benchmarkPreparing(name);
+
+    Catch::BenchmarkInfo info{std::move(name), 0.0, 1, cfg->benchmarkSamples(), cfg->benchmarkResamples(),
+            env.clock_resolution.mean.count(), env.clock_cost.mean.count()};
+
+    Catch::getResultCapture().benchmarkStarting(info);
+
+    Catch::BenchmarkStats<duration> stats{info, analysis.samples, analysis.mean, analysis.standard_deviation,
+            analysis.outliers, analysis.outlier_variance};
+
+    Catch::getResultCapture().benchmarkEnded(stats);
+}
+
+#define CPU_BENCHMARK(name, bytes) CpuBenchmark{name, bytes} <<= [&]
+
+// Keeps the compiler from discarding results that are never read
+template<typename T>
+void black_hole(const T &value) {
+#ifdef __GNUC__
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
@@ -0,0 +1,236 @@
+#include <ndzip/common.hh>
+#include <ndzip/hdf5.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+
+#include <H5PLextern.h>
+
+
+namespace ndzip::hdf5 {
+namespace {
+
+enum class element_type : unsigned { f32, f64, i8, u8, i16, u16, i32, u32 };
+
+// Client data of the filter. set_filter only stores the number of threads, set_local completes the remaining values
+// from the chunk shape and element type of the dataset.
+enum cd_index : size_t {
+    cd_num_threads,
+    cd_element_type,
+    cd_dimensions,
+    cd_extent,  // followed by the extents of the slower dimensions
+    cd_length = cd_extent + 3,
+};
+
+std::optional<element_type> element_type_of(hid_t type) {
+    const auto size = H5Tget_size(type);
+    switch (H5Tget_class(type)) {
+        case H5T_FLOAT:
+            if (size == 4) { return element_type::f32; }
+            if (size == 8) { return element_type::f64; }
+            break;
+        case H5T_INTEGER: {
+            const bool is_signed = H5Tget_sign(type) == H5T_SGN_2;
+            if (size == 1) { return is_signed ? element_type::i8 : element_type::u8; }
+            if (size == 2) { return is_signed ? element_type::i16 : element_type::u16; }
+            if (size == 4) { return is_signed ? element_type::i32 : element_type::u32; }
+            break;
+        }
+        default: break;
+    }
+    return std::nullopt;
+}
+
+template<typename F>
+auto with_element_type(element_type type, F &&f) {
+    switch (type) {
+        case element_type::f32: return f(float{});
+        case element_type::f64: return f(double{});
+        case element_type::i8: return f(int8_t{});
+        case element_type::u8: return f(uint8_t{});
+        case element_type::i16: return f(int16_t{});
+        case element_type::u16: return f(uint16_t{});
+        case element_type::i32: return f(int32_t{});
+        case element_type::u32: return f(uint32_t{});
+    }
+    throw std::runtime_error{"ndzip HDF5 filter: invalid element type"};
+}
+
+// Compressors keep scratch memory and, when multi-threaded, an OpenMP team, so each calling thread creates them once
+// per configuration instead of once per chunk
+template<typename T>
+struct codec_pair {
+    std::unique_ptr<compressor<T>> co;
+    std::unique_ptr<decompressor<T>> de;
+};
+
+template<typename T>
+codec_pair<T> &thread_codecs(dim_type dims, unsigned num_threads) {
+    thread_local std::map<std::pair<dim_type, unsigned>, codec_pair<T>> cache;
+    return cache[{dims, num_threads}];
+}
+
+template<typename T>
+size_t compress_chunk(const extent &chunk_size, unsigned num_threads, size_t nbytes, size_t *buf_size, void **buf) {
+    if (nbytes != num_elements(chunk_size) * sizeof(T)) { return 0; }
+
+    auto &codecs = thread_codecs<T>(chunk_size.dimensions(), num_threads);
+    if (!codecs.co) { codecs.co = make_compressor<T>(chunk_size.dimensions(), num_threads); }
+
+    const auto bound_bytes = compressed_length_bound<T>(chunk_size) * sizeof(compressed_type<T>);
+    auto stream = static_cast<compressed_type<T> *>(H5allocate_memory(bound_bytes, false));
+    if (!stream) { return 0; }
+    const auto length = codecs.co->compress(static_cast<const T *>(*buf), chunk_size, stream);
+
+    H5free_memory(*buf);
+    *buf = stream;
+    *buf_size = bound_bytes;
+    return length * sizeof(compressed_type<T>);
+}
+
+template<typename T>
+size_t decompress_chunk(const extent &chunk_size, unsigned num_threads, size_t *buf_size, void **buf) {
+    auto &codecs = thread_codecs<T>(chunk_size.dimensions(), num_threads);
+    if (!codecs.de) { codecs.de = make_decompressor<T>(chunk_size.dimensions(), num_threads); }
+
+    const auto data_bytes = num_elements(chunk_size) * sizeof(T);
+    auto data = static_cast<T *>(H5allocate_memory(data_bytes, false));
+    if (!data) { return 0; }
+    codecs.de->decompress(static_cast<const compressed_type<T> *>(*buf), data, chunk_size);
+
+    H5free_memory(*buf);
+    *buf = data;
+    *buf_size = data_bytes;
+    return data_bytes;
+}
+
+htri_t can_apply(hid_t /* dcpl */, hid_t type, hid_t /* space */) {
+    return element_type_of(type) ? 1 : 0;
+}
+
+herr_t set_local(hid_t dcpl, hid_t type, hid_t /* space */) {
+    const auto elem_type = element_type_of(type);
+    if (!elem_type) { return -1; }
+
+    unsigned flags;
+    size_t cd_nelmts = 1;
+    unsigned cd_values[cd_length] = {};
+    if (H5Pget_filter_by_id2(dcpl, filter_id, &flags, &cd_nelmts, cd_values, 0, nullptr, nullptr) < 0) { return -1; }
+
+    hsize_t chunk[H5S_MAX_RANK];
+    const auto rank = H5Pget_chunk(dcpl, H5S_MAX_RANK, chunk);
+    if (rank < 1) { return -1; }
+
+    // Outer dimensions beyond the three ndzip supports are folded into the slowest of the innermost three
+    const auto dims = std::min(rank, 3);
+    hsize_t slowest = 1;
+    for (int d = 0; d <= rank - dims; ++d) {
+        slowest *= chunk[d];
+    }
+    if (slowest > std::numeric_limits<index_type>::max()) { return -1; }
+
+    cd_values[cd_element_type] = static_cast<unsigned>(*elem_type);
+    cd_values[cd_dimensions] = static_cast<unsigned>(dims);
+    cd_values[cd_extent] = static_cast<unsigned>(slowest);
+    for (int d = 1; d < dims; ++d) {
+        cd_values[cd_extent + d] = static_cast<unsigned>(chunk[rank - dims + d]);
+    }
+
+    return H5Pmodify_filter(dcpl, filter_id, flags, cd_extent + dims, cd_values);
+}
+
+size_t filter(unsigned flags, size_t cd_nelmts, const unsigned cd_values[], size_t nbytes, size_t *buf_size,
+        void **buf) {
+    if (cd_nelmts < cd_extent + 1 || cd_nelmts != cd_extent + cd_values[cd_dimensions]) { return 0; }
+
+    const auto dims = static_cast<dim_type>(cd_values[cd_dimensions]);
+    extent chunk_size(dims);
+    for (dim_type d = 0; d < dims; ++d) {
+        chunk_size[d] = cd_values[cd_extent + d];
+    }
+    const auto num_threads = cd_values[cd_num_threads];
+
+    // HDF5 expects a return value of 0 on failure and does not pass exceptions on
+    try {
+        return with_element_type(static_cast<element_type>(cd_values[cd_element_type]), [&](auto value) {
+            using value_type = decltype(value);
+            if (flags & H5Z_FLAG_REVERSE) {
+                return decompress_chunk<value_type>(chunk_size, num_threads, buf_size, buf);
+            } else {
+                return compress_chunk<value_type>(chunk_size, num_threads, nbytes, buf_size, buf);
+            }
+        });
+    } catch (...) { return 0; }
+}
+
+const H5Z_class2_t filter_class = {
+        H5Z_CLASS_T_VERS,
+        filter_id,
+        1,  // encoder present
+        1,  // decoder present
+        "ndzip",
+        can_apply,
+        set_local,
+        filter,
+};
+
+}  // namespace
+
+herr_t register_filter() {
+    return H5Zregister(&filter_class);
+}
+
+herr_t set_filter(hid_t dcpl, unsigned num_threads) {
+    return H5Pset_filter(dcpl, filter_id, H5Z_FLAG_MANDATORY, 1, &num_threads);
+}
+
+std::vector<hsize_t> suggest_chunk_shape(
+        const std::vector<hsize_t> &dataset_shape, size_t element_size, size_t target_chunk_bytes) {
+    const auto rank = static_cast<int>(dataset_shape.size());
+    if (rank < 1) { throw std::runtime_error{"suggest_chunk_shape: dataset must have at least one dimension"}; }
+    const auto dims = std::min(rank, 3);
+    const auto side_length = detail::hypercube_side_length_for(dims, hypercube_size::standard);
+    const auto inner = rank - dims;
+
+    // Start from a single hypercube (or the whole dataset where it is smaller)...
+    std::vector<hsize_t> chunk(dataset_shape.size(), 1);
+    size_t chunk_elements = 1;
+    for (int d = inner; d < rank; ++d) {
+        chunk[d] = std::max(hsize_t{1}, std::min(hsize_t{side_length}, dataset_shape[d]));
+        chunk_elements *= chunk[d];
+    }
+
+    // ... and grow it by whole hypercubes, fastest dimension first so that chunks cover contiguous rows, then along the
+    // outer dimensions
+    const auto target_elements = std::max(size_t{1}, target_chunk_bytes / std::max(size_t{1}, element_size));
+    for (int d = rank - 1; d >= inner; --d) {
+        if (chunk[d] < side_length) { continue; }
+        const auto slice_elements = chunk_elements / chunk[d];
+        const auto side_multiple = std::max(hsize_t{1}, hsize_t{target_elements / (slice_elements * side_length)});
+        chunk[d] = std::min(dataset_shape[d] / side_length * side_length, side_multiple * side_length);
+        chunk_elements = slice_elements * chunk[d];
+    }
+    for (int d = inner - 1; d >= 0; --d) {
+        const auto slice_elements = chunk_elements / chunk[d];
+        chunk[d] = std::max(hsize_t{1}, std::min(dataset_shape[d], hsize_t{target_elements / slice_elements}));
+        chunk_elements = slice_elements * chunk[d];
+    }
+    return chunk;
+}
+
+}  // namespace ndzip::hdf5
+
+
+extern "C" {
+
+H5PL_type_t H5PLget_plugin_type() {
+    return H5PL_TYPE_FILTER;
+}
+
+const void *H5PLget_plugin_info() {
+    return &ndzip::hdf5::filter_class;
+}
+}
@@ -78,7 +78,7 @@ class stdio_output_stream final : public output_stream {
             _file = fopen(file_name.c_str(), "wb");
             if (!_file) { throw io_error("fopen: " + file_name + ": " + strerror(errno)); }
         } else {
-            _file = freopen(nullptr, "wb", stdin);
+            _file = freopen(nullptr, "wb", stdout);
             if (!_file) { throw io_error("freopen: stdout: "s + strerror(errno)); }
         }
     }
@@ -113,6 +113,55 @@ class stdio_output_stream final : public output_stream {
     bool _should_zero_buffer = false;
 };
 
+class stdio_random_access_input final : public random_access_input {
+  public:
+    explicit stdio_random_access_input(const std::string &file_name) {
+        if (!file_name.empty() && file_name != "-") {
+            _file = fopen(file_name.c_str(), "rb");
+            if (!_file) { throw io_error("fopen: " + file_name + ": " + strerror(errno)); }
+        } else {
+            _file = freopen(nullptr, "rb", stdin);
+            if (!_file) { throw io_error("freopen: stdin: "s + strerror(errno)); }
+        }
+        if (fseeko(_file, 0, SEEK_END) != 0) {
+            if (_file != stdin) { fclose(_file); }
+            throw io_error("fseeko: input is not seekable: "s + strerror(errno));
+        }
+        _size = static_cast<size_t>(ftello(_file));
+    }
+
+    ~stdio_random_access_input() noexcept(false) override {
+        free(_buffer);
+        if (_file != stdin) {
+            if (fclose(_file) != 0) { throw io_error("fclose: "s + strerror(errno)); }
+        }
+    }
+
+    stdio_random_access_input(const stdio_random_access_input &) = delete;
+    stdio_random_access_input &operator=(const stdio_random_access_input &) = delete;
+
+    size_t size() const override { return _size; }
+
+    const void *read_at(size_t offset, size_t length) override {
+        if (offset > _size || length > _size - offset) { throw io_error("Read beyond the end of input"); }
+        if (length > _capacity) {
+            free(_buffer);
+            _buffer = malloc(length);
+            if (!_buffer) { throw std::bad_alloc(); }
+            _capacity = length;
+        }
+        if (fseeko(_file, static_cast<off_t>(offset), SEEK_SET) != 0) { throw io_error("fseeko: "s + strerror(errno)); }
+        if (length > 0 && fread(_buffer, length, 1, _file) < 1) { throw io_error("fread: "s + strerror(errno)); }
+        return _buffer;
+    }
+
+  private:
+    FILE *_file;
+    size_t _size;
+    void *_buffer = nullptr;
+    size_t _capacity = 0;
+};
+
 #if NDZIP_SUPPORT_MMAP
 
 class mmap_input_stream final : public input_stream {
@@ -166,6 +215,8 @@ class mmap_input_stream final : public input_stream {
         }
     }
 
+    bool retains_chunks() const override { return true; }
+
   private:
     int _fd = STDIN_FILENO;
     size_t _max_chunk_size;
@@ -174,6 +225,54 @@ class mmap_input_stream final : public input_stream {
     size_t _offset = 0;
 };
 
+class mmap_random_access_input final : public random_access_input {
+  public:
+    explicit mmap_random_access_input(const std::string &file_name) {
+        if (!file_name.empty() && file_name != "-") {
+            _fd = open(file_name.c_str(), O_RDONLY);
+            if (_fd == -1) { throw io_error("open: " + file_name + ": " + strerror(errno)); }
+        }
+
+        struct stat buf {};
+        if (fstat(_fd, &buf) == -1) {
+            if (_fd != STDIN_FILENO) { close(_fd); }
+            throw io_error("fstat: " + file_name + ": " + strerror(errno));
+        }
+        _size = static_cast<size_t>(buf.st_size);
+        if (_size > 0) {
+            _map = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+            if (_map == MAP_FAILED) {
+                if (_fd != STDIN_FILENO) { close(_fd); }
+                throw io_error("mmap: " + file_name + ": " + strerror(errno));
+            }
+        }
+    }
+
+    mmap_random_access_input(const mmap_random_access_input &) = delete;
+    mmap_random_access_input &operator=(const mmap_random_access_input &) = delete;
+
+    ~mmap_random_access_input() noexcept(false) override {
+        auto munmap_result = _map ? munmap(_map, _size) : 0;
+        auto close_result = _fd != STDIN_FILENO ? close(_fd) : 0;
+        if (munmap_result == -1) { throw io_error("munmap: input: "s + strerror(errno)); }
+        if (close_result == -1) { throw io_error("close: input: "s + strerror(errno)); }
+    }
+
+    size_t size() const override { return _size; }
+
+    const void *read_at(size_t offset, size_t length) override {
+        if (offset > _size || length > _size - offset) { throw io_error("Read beyond the end of input"); }
+        return static_cast<const char *>(_map) + offset;
+    }
+
+    bool retains_chunks() const override { return true; }
+
+  private:
+    int _fd = STDIN_FILENO;
+    void *_map = nullptr;
+    size_t _size = 0;
+};
+
 class mmap_output_stream final : public output_stream {
   public:
     explicit mmap_output_stream(const std::string &file_name, size_t max_chunk_size) : _max_chunk_size(max_chunk_size) {
@@ -253,6 +352,10 @@ std::unique_ptr<output_stream> stdio_io_factory::create_output_stream(
     return std::make_unique<stdio_output_stream>(file_name, max_chunk_length);
 }
 
+std::unique_ptr<random_access_input> stdio_io_factory::create_random_access_input(const std::string &file_name) const {
+    return std::make_unique<stdio_random_access_input>(file_name);
+}
+
 #if NDZIP_SUPPORT_MMAP
 
 std::unique_ptr<input_stream> mmap_io_factory::create_input_stream(
@@ -265,6 +368,10 @@ std::unique_ptr<output_stream> mmap_io_factory::create_output_stream(
     return std::make_unique<mmap_output_stream>(file_name, max_chunk_length);
 }
 
+std::unique_ptr<random_access_input> mmap_io_factory::create_random_access_input(const std::string &file_name) const {
+    return std::make_unique<mmap_random_access_input>(file_name);
+}
+
 #endif  // NDZIP_SUPPORT_MMAP
 
 }  // namespace ndzip::detail
@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <utility>
 
 
@@ -12,6 +13,12 @@
 #define NDZIP_SUPPORT_MMAP 0
 #endif
 
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define NDZIP_SUPPORT_IO_URING 1
+#else
+#define NDZIP_SUPPORT_IO_URING 0
+#endif
+
 
 namespace ndzip::detail {
 
@@ -28,6 +35,9 @@ class input_stream {
     std::pair<const void *, size_t> read_some() { return read_some(0); }
 
     virtual const void *read_exact() = 0;
+
+    // Whether returned chunks remain valid until the stream is destroyed, not only until the next read
+    virtual bool retains_chunks() const { return false; }
 };
 
 class output_stream {
@@ -37,6 +47,17 @@ class output_stream {
     virtual void commit_chunk(size_t length) = 0;
 };
 
+// Positional reads from a seekable file. The returned pointer remains valid until the next call to read_at().
+class random_access_input {
+  public:
+    virtual ~random_access_input() noexcept(false) {}
+    virtual size_t size() const = 0;
+    virtual const void *read_at(size_t offset, size_t length) = 0;
+
+    // Whether returned pointers remain valid until the input is destroyed, not only until the next read_at()
+    virtual bool retains_chunks() const { return false; }
+};
+
 class io_factory {
   public:
     virtual ~io_factory() = default;
@@ -44,6 +65,7 @@ class io_factory {
             const std::string &file_name, size_t chunk_length) const = 0;
     virtual std::unique_ptr<output_stream> create_output_stream(
             const std::string &file_name, size_t max_chunk_length) const = 0;
+    virtual std::unique_ptr<random_access_input> create_random_access_input(const std::string &file_name) const = 0;
 };
 
 class stdio_io_factory : public io_factory {
@@ -52,6 +74,8 @@ class stdio_io_factory : public io_factory {
 
     std::unique_ptr<output_stream> create_output_stream(
             const std::string &file_name, size_t max_chunk_length) const override;
+
+    std::unique_ptr<random_access_input> create_random_access_input(const std::string &file_name) const override;
 };
 
 #if NDZIP_SUPPORT_MMAP
@@ -62,6 +86,32 @@ class mmap_io_factory : public io_factory {
 
     std::unique_ptr<output_stream> create_output_stream(
             const std::string &file_name, size_t max_chunk_length) const override;
+
+    std::unique_ptr<random_access_input> create_random_access_input(const std::string &file_name) const override;
+};
+
+#endif
+
+#if NDZIP_SUPPORT_IO_URING
+
+// Reads and writes files with O_DIRECT through io_uring, keeping queue_depth chunks in flight while the caller works
+// on the current one. Data moves between the device and aligned buffers without passing through the page cache, which
+// on parallel file systems otherwise competes with the application for memory. File systems that reject O_DIRECT are
+// accessed through the page cache instead. Only named files are supported, not stdin and stdout.
+class io_uring_io_factory : public io_factory {
+  public:
+    explicit io_uring_io_factory(unsigned queue_depth = 4);
+
+    std::unique_ptr<input_stream> create_input_stream(const std::string &file_name, size_t chunk_length) const override;
+
+    std::unique_ptr<output_stream> create_output_stream(
+            const std::string &file_name, size_t max_chunk_length) const override;
+
+    // Positional reads are synchronous preads of the aligned blocks covering the requested range
+    std::unique_ptr<random_access_input> create_random_access_input(const std::string &file_name) const override;
+
+  private:
+    unsigned _queue_depth;
 };
 
 #endif
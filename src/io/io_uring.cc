@@ -0,0 +1,544 @@
+#include "io.hh"
+
+#if NDZIP_SUPPORT_IO_URING
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+using namespace std::string_literals;
+
+
+namespace ndzip::detail {
+
+// O_DIRECT requires buffer addresses, file offsets and transfer lengths to be multiples of the logical block size of
+// the device, which is at most 4 KiB on current hardware
+constexpr size_t direct_io_alignment = 4096;
+
+static size_t align_down(size_t x) {
+    return x / direct_io_alignment * direct_io_alignment;
+}
+
+static size_t align_up(size_t x) {
+    return align_down(x + direct_io_alignment - 1);
+}
+
+namespace {
+
+struct free_deleter {
+    void operator()(void *p) const { free(p); }
+};
+
+using aligned_buffer = std::unique_ptr<std::byte, free_deleter>;
+
+aligned_buffer make_aligned_buffer(size_t size) {
+    auto p = static_cast<std::byte *>(aligned_alloc(direct_io_alignment, align_up(std::max(size_t{1}, size))));
+    if (!p) { throw std::bad_alloc(); }
+    return aligned_buffer{p};
+}
+
+int open_direct(const std::string &file_name, int flags) {
+    if (file_name.empty() || file_name == "-") {
+        throw io_error("io_uring I/O requires a named file instead of stdin / stdout");
+    }
+    // tmpfs and some network file systems reject O_DIRECT, which then only costs the bypass of the page cache
+    int fd = open(file_name.c_str(), flags | O_DIRECT, 0666);
+    if (fd == -1 && errno == EINVAL) { fd = open(file_name.c_str(), flags, 0666); }
+    if (fd == -1) { throw io_error("open: " + file_name + ": " + strerror(errno)); }
+    return fd;
+}
+
+size_t file_size(int fd, const std::string &file_name) {
+    struct stat buf {};
+    if (fstat(fd, &buf) == -1) { throw io_error("fstat: " + file_name + ": " + strerror(errno)); }
+    return static_cast<size_t>(buf.st_size);
+}
+
+// Submission and completion rings of an io_uring instance, set up through the raw system calls so that no liburing is
+// required. Operations are submitted one at a time and identified by a caller-chosen tag in their completion.
+class io_uring_queue {
+  public:
+    struct completion {
+        uint64_t tag;
+        int result;  // bytes transferred or a negative errno value
+    };
+
+    explicit io_uring_queue(unsigned entries) {
+        io_uring_params params{};
+        _fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (_fd == -1) { throw io_error("io_uring_setup: "s + strerror(errno)); }
+
+        _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+        }
+        _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+        try {
+            _sq_ring = map(_sq_ring_size, IORING_OFF_SQ_RING);
+            _cq_ring = params.features & IORING_FEAT_SINGLE_MMAP ? _sq_ring : map(_cq_ring_size, IORING_OFF_CQ_RING);
+            _sqes = static_cast<io_uring_sqe *>(map(_sqes_size, IORING_OFF_SQES));
+        } catch (...) {
+            unmap();
+            close(_fd);
+            throw;
+        }
+
+        const auto sq = static_cast<std::byte *>(_sq_ring);
+        _sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        _sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        const auto cq = static_cast<std::byte *>(_cq_ring);
+        _cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        _cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    io_uring_queue(const io_uring_queue &) = delete;
+    io_uring_queue &operator=(const io_uring_queue &) = delete;
+
+    ~io_uring_queue() {
+        unmap();
+        close(_fd);
+    }
+
+    void submit(uint8_t opcode, int fd, void *buffer, size_t length, size_t offset, uint64_t tag) {
+        // The kernel consumes every entry within io_uring_enter, so the submission ring is always empty here
+        const auto tail = *_sq_tail;
+        const auto index = tail & _sq_mask;
+        auto &sqe = _sqes[index];
+        memset(&sqe, 0, sizeof sqe);
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buffer);
+        sqe.len = static_cast<uint32_t>(length);
+        sqe.off = offset;
+        sqe.user_data = tag;
+        _sq_array[index] = index;
+        __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        for (;;) {
+            const auto submitted = syscall(__NR_io_uring_enter, _fd, 1, 0, 0, nullptr, 0);
+            if (submitted == 1) { return; }
+            if (submitted == -1 && errno != EINTR) { throw io_error("io_uring_enter: "s + strerror(errno)); }
+        }
+    }
+
+    completion wait() {
+        for (;;) {
+            const auto head = *_cq_head;
+            if (head != __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+                const auto &cqe = _cqes[head & _cq_mask];
+                const completion c{cqe.user_data, cqe.res};
+                __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+                return c;
+            }
+            if (syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) == -1 && errno != EINTR) {
+                throw io_error("io_uring_enter: "s + strerror(errno));
+            }
+        }
+    }
+
+  private:
+    int _fd;
+    void *_sq_ring = nullptr;
+    void *_cq_ring = nullptr;
+    io_uring_sqe *_sqes = nullptr;
+    size_t _sq_ring_size;
+    size_t _cq_ring_size;
+    size_t _sqes_size;
+    unsigned *_sq_tail;
+    unsigned _sq_mask;
+    unsigned *_sq_array;
+    unsigned *_cq_head;
+    unsigned *_cq_tail;
+    unsigned _cq_mask;
+    io_uring_cqe *_cqes;
+
+    void *map(size_t size, off_t offset) {
+        auto p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+        if (p == MAP_FAILED) { throw io_error("mmap: io_uring: "s + strerror(errno)); }
+        return p;
+    }
+
+    void unmap() {
+        if (_sqes) { munmap(_sqes, _sqes_size); }
+        if (_cq_ring && _cq_ring != _sq_ring) { munmap(_cq_ring, _cq_ring_size); }
+        if (_sq_ring) { munmap(_sq_ring, _sq_ring_size); }
+    }
+};
+
+// A transfer between one buffer and the file, resubmitted until complete if the kernel returns early. O_DIRECT
+// rejects requests at unaligned positions, so a short transfer is resumed at the beginning of its last partial block,
+// which is transferred again.
+struct buffer_transfer {
+    size_t offset = 0;  // in the file
+    size_t length = 0;  // aligned length of the request
+    size_t expected = 0;  // bytes that must be transferred, less than length only at the end of the file
+    size_t done = 0;
+    size_t resumed = 0;  // aligned position of the request in flight, relative to offset
+    bool in_flight = false;
+
+    // Accounts for a completion with a non-negative result. Returns false if the request made no progress.
+    bool complete(size_t result) {
+        if (resumed + result <= done) { return false; }
+        done = resumed + result;
+        resumed = align_down(done);
+        return true;
+    }
+};
+
+}  // namespace
+
+
+// The file is read in segments of the chunk size rounded up to the alignment, one per buffer, which are requested
+// queue_depth segments ahead of the one read_some() returns. A chunk that lies within one segment is returned in
+// place, otherwise it is assembled from the two segments it spans.
+class io_uring_input_stream final : public input_stream {
+  public:
+    io_uring_input_stream(const std::string &file_name, size_t chunk_size, unsigned queue_depth)
+        : _chunk_size(chunk_size)
+        , _segment_size(align_up(std::max(size_t{1}, chunk_size)))
+        , _ring(queue_depth)
+        , _transfers(queue_depth)
+        , _chunk(make_aligned_buffer(chunk_size)) {
+        assert(queue_depth >= 2);  // see io_uring_io_factory
+        _fd = open_direct(file_name, O_RDONLY);
+        try {
+            _size = file_size(_fd, file_name);
+            _num_segments = (_size + _segment_size - 1) / _segment_size;
+            for (unsigned i = 0; i < queue_depth; ++i) {
+                _buffers.push_back(make_aligned_buffer(_segment_size));
+            }
+            for (size_t segment = 0; segment < std::min<size_t>(queue_depth, _num_segments); ++segment) {
+                request(segment);
+            }
+        } catch (...) {
+            drain();
+            close(_fd);
+            throw;
+        }
+    }
+
+    io_uring_input_stream(const io_uring_input_stream &) = delete;
+    io_uring_input_stream &operator=(const io_uring_input_stream &) = delete;
+
+    ~io_uring_input_stream() noexcept(false) override {
+        drain();
+        if (close(_fd) == -1) { throw io_error("close: input: "s + strerror(errno)); }
+    }
+
+    std::pair<const void *, size_t> read_some(size_t remainder_from_last_chunk) override {
+        assert(remainder_from_last_chunk <= std::min(_chunk_size, _offset));
+        const auto begin = _offset - remainder_from_last_chunk;
+        const auto length = std::min(_chunk_size, _size - begin);
+        _offset = begin + length;
+        if (length == 0) { return {_chunk.get(), 0}; }
+
+        // Chunks never move backwards past the beginning of the previous one, so earlier segments can be reused
+        const auto first_segment = begin / _segment_size;
+        const auto last_segment = (begin + length - 1) / _segment_size;
+        for (; _next_segment_to_release < first_segment; ++_next_segment_to_release) {
+            const auto next = _next_segment_to_release + _transfers.size();
+            if (next < _num_segments) { request(next); }
+        }
+
+        wait_for(first_segment);
+        const auto first_offset = begin - first_segment * _segment_size;
+        if (first_segment == last_segment) { return {segment_data(first_segment) + first_offset, length}; }
+
+        wait_for(last_segment);
+        const auto first_length = _segment_size - first_offset;
+        memcpy(_chunk.get(), segment_data(first_segment) + first_offset, first_length);
+        memcpy(_chunk.get() + first_length, segment_data(last_segment), length - first_length);
+        return {_chunk.get(), length};
+    }
+
+    const void *read_exact() override {
+        auto [chunk, bytes_read] = read_some(0);
+        if (bytes_read == _chunk_size) {
+            return chunk;
+        } else if (bytes_read == 0) {
+            return nullptr;
+        } else {
+            throw io_error("Input file size is not a multiple of the chunk size");
+        }
+    }
+
+  private:
+    int _fd;
+    size_t _chunk_size;
+    size_t _segment_size;
+    size_t _size = 0;
+    size_t _num_segments = 0;
+    size_t _offset = 0;
+    size_t _next_segment_to_release = 0;
+    io_uring_queue _ring;
+    std::vector<aligned_buffer> _buffers;
+    std::vector<buffer_transfer> _transfers;
+    aligned_buffer _chunk;
+
+    const std::byte *segment_data(size_t segment) const { return _buffers[segment % _buffers.size()].get(); }
+
+    void request(size_t segment) {
+        const auto slot = segment % _transfers.size();
+        auto &t = _transfers[slot];
+        assert(!t.in_flight);
+        t.offset = segment * _segment_size;
+        t.expected = std::min(_segment_size, _size - t.offset);
+        t.length = align_up(t.expected);
+        t.done = t.resumed = 0;
+        t.in_flight = true;
+        _ring.submit(IORING_OP_READ, _fd, _buffers[slot].get(), t.length, t.offset, slot);
+    }
+
+    void wait_for(size_t segment) {
+        while (_transfers[segment % _transfers.size()].in_flight) {
+            complete(_ring.wait());
+        }
+    }
+
+    void complete(io_uring_queue::completion c) {
+        auto &t = _transfers[c.tag];
+        if (c.result < 0) {
+            t.in_flight = false;
+            throw io_error("io_uring read: "s + strerror(-c.result));
+        }
+        if (!t.complete(static_cast<size_t>(c.result))) {
+            t.in_flight = false;
+            throw io_error("io_uring read: input file was truncated while reading");
+        }
+        if (t.done < t.expected) {
+            _ring.submit(IORING_OP_READ, _fd, _buffers[c.tag].get() + t.resumed, t.length - t.resumed,
+                    t.offset + t.resumed, c.tag);
+        } else {
+            t.in_flight = false;
+        }
+    }
+
+    // Buffers must not be released while the kernel may still write to them
+    void drain() noexcept {
+        for (auto &t : _transfers) {
+            while (t.in_flight) {
+                try {
+                    complete(_ring.wait());
+                } catch (...) {}
+            }
+        }
+    }
+};
+
+
+// Committed chunks are written in whole aligned blocks as soon as they are complete, from a ring of queue_depth
+// buffers. The unaligned tail of every chunk is carried over to the beginning of the next buffer, and the final partial
+// block is written with zero padding that is truncated away when the stream is closed.
+class io_uring_output_stream final : public output_stream {
+  public:
+    io_uring_output_stream(const std::string &file_name, size_t max_chunk_size, unsigned queue_depth)
+        : _max_chunk_size(max_chunk_size)
+        , _buffer_size(align_up(max_chunk_size) + direct_io_alignment)
+        , _ring(queue_depth)
+        , _transfers(queue_depth) {
+        _fd = open_direct(file_name, O_WRONLY | O_CREAT | O_TRUNC);
+        try {
+            for (unsigned i = 0; i < queue_depth; ++i) {
+                _buffers.push_back(make_aligned_buffer(_buffer_size));
+            }
+        } catch (...) {
+            close(_fd);
+            throw;
+        }
+        memset(_buffers[0].get(), 0, _buffer_size);
+    }
+
+    io_uring_output_stream(const io_uring_output_stream &) = delete;
+    io_uring_output_stream &operator=(const io_uring_output_stream &) = delete;
+
+    ~io_uring_output_stream() noexcept(false) override {
+        try {
+            if (_tail > 0) {
+                memset(_buffers[_current].get() + _tail, 0, direct_io_alignment - _tail);
+                write(_current, direct_io_alignment);
+            }
+            for (size_t slot = 0; slot < _transfers.size(); ++slot) {
+                wait_for(slot);
+            }
+            if (ftruncate(_fd, static_cast<off_t>(_size)) == -1) { throw io_error("ftruncate: "s + strerror(errno)); }
+        } catch (...) {
+            drain();
+            close(_fd);
+            throw;
+        }
+        if (close(_fd) == -1) { throw io_error("close: output: "s + strerror(errno)); }
+    }
+
+    void *get_write_buffer() override {
+        wait_for(_current);
+        if (_should_zero_buffer) {
+            memset(_buffers[_current].get() + _tail, 0, _max_chunk_size);
+            _should_zero_buffer = false;
+        }
+        return _buffers[_current].get() + _tail;
+    }
+
+    void commit_chunk(size_t length) override {
+        assert(length <= _max_chunk_size);
+        _size += length;
+        const auto filled = _tail + length;
+        const auto aligned = align_down(filled);
+        _should_zero_buffer = true;
+        if (aligned == 0) {
+            _tail = filled;
+            return;
+        }
+
+        write(_current, aligned);
+        const auto next = (_current + 1) % _buffers.size();
+        wait_for(next);
+        _tail = filled - aligned;
+        memmove(_buffers[next].get(), _buffers[_current].get() + aligned, _tail);
+        _current = next;
+    }
+
+  private:
+    int _fd;
+    size_t _max_chunk_size;
+    size_t _buffer_size;
+    size_t _size = 0;  // bytes committed
+    size_t _file_offset = 0;  // bytes submitted, always aligned
+    size_t _tail = 0;  // bytes at the beginning of the current buffer that belong to the next block
+    size_t _current = 0;
+    bool _should_zero_buffer = false;
+    io_uring_queue _ring;
+    std::vector<aligned_buffer> _buffers;
+    std::vector<buffer_transfer> _transfers;
+
+    void write(size_t slot, size_t length) {
+        auto &t = _transfers[slot];
+        assert(!t.in_flight);
+        t.offset = _file_offset;
+        t.length = t.expected = length;
+        t.done = t.resumed = 0;
+        t.in_flight = true;
+        _ring.submit(IORING_OP_WRITE, _fd, _buffers[slot].get(), length, t.offset, slot);
+        _file_offset += length;
+    }
+
+    void wait_for(size_t slot) {
+        while (_transfers[slot].in_flight) {
+            complete(_ring.wait());
+        }
+    }
+
+    void complete(io_uring_queue::completion c) {
+        auto &t = _transfers[c.tag];
+        if (c.result < 0 || !t.complete(static_cast<size_t>(c.result))) {
+            t.in_flight = false;
+            throw io_error("io_uring write: "s + (c.result < 0 ? strerror(-c.result) : "no progress"));
+        }
+        if (t.done < t.expected) {
+            _ring.submit(IORING_OP_WRITE, _fd, _buffers[c.tag].get() + t.resumed, t.length - t.resumed,
+                    t.offset + t.resumed, c.tag);
+        } else {
+            t.in_flight = false;
+        }
+    }
+
+    void drain() noexcept {
+        for (auto &t : _transfers) {
+            while (t.in_flight) {
+                try {
+                    complete(_ring.wait());
+                } catch (...) {}
+            }
+        }
+    }
+};
+
+
+class direct_random_access_input final : public random_access_input {
+  public:
+    explicit direct_random_access_input(const std::string &file_name) {
+        _fd = open_direct(file_name, O_RDONLY);
+        try {
+            _size = file_size(_fd, file_name);
+        } catch (...) {
+            close(_fd);
+            throw;
+        }
+    }
+
+    direct_random_access_input(const direct_random_access_input &) = delete;
+    direct_random_access_input &operator=(const direct_random_access_input &) = delete;
+
+    ~direct_random_access_input() noexcept(false) override {
+        if (close(_fd) == -1) { throw io_error("close: input: "s + strerror(errno)); }
+    }
+
+    size_t size() const override { return _size; }
+
+    const void *read_at(size_t offset, size_t length) override {
+        if (offset > _size || length > _size - offset) { throw io_error("Read beyond the end of input"); }
+        const auto block_offset = align_down(offset);
+        const auto block_length = align_up(offset + length) - block_offset;
+        if (block_length > _capacity) {
+            _buffer = make_aligned_buffer(block_length);
+            _capacity = block_length;
+        }
+
+        const auto expected = std::min(block_length, _size - block_offset);
+        for (size_t done = 0; done < expected;) {
+            const auto n = pread(_fd, _buffer.get() + done, block_length - done,
+                    static_cast<off_t>(block_offset + done));
+            if (n == -1 && errno == EINTR) { continue; }
+            if (n == -1) { throw io_error("pread: "s + strerror(errno)); }
+            if (n == 0) { throw io_error("pread: input file was truncated while reading"); }
+            done += static_cast<size_t>(n);
+        }
+        return _buffer.get() + (offset - block_offset);
+    }
+
+  private:
+    int _fd;
+    size_t _size = 0;
+    aligned_buffer _buffer;
+    size_t _capacity = 0;
+};
+
+
+// Checked here rather than by the streams, which set up their io_uring instance before their constructor body runs
+io_uring_io_factory::io_uring_io_factory(unsigned queue_depth) : _queue_depth(queue_depth) {
+    if (queue_depth < 2) { throw std::invalid_argument{"io_uring I/O requires a queue depth of at least 2"}; }
+}
+
+std::unique_ptr<input_stream> io_uring_io_factory::create_input_stream(
+        const std::string &file_name, size_t chunk_length) const {
+    return std::make_unique<io_uring_input_stream>(file_name, chunk_length, _queue_depth);
+}
+
+std::unique_ptr<output_stream> io_uring_io_factory::create_output_stream(
+        const std::string &file_name, size_t max_chunk_length) const {
+    return std::make_unique<io_uring_output_stream>(file_name, max_chunk_length, _queue_depth);
+}
+
+std::unique_ptr<random_access_input> io_uring_io_factory::create_random_access_input(
+        const std::string &file_name) const {
+    return std::make_unique<direct_random_access_input>(file_name);
+}
+
+}  // namespace ndzip::detail
+
+#endif  // NDZIP_SUPPORT_IO_URING
@@ -0,0 +1,147 @@
+#include <ndzip/common.hh>
+#include <ndzip/mpi.hh>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace ndzip::mpi {
+namespace {
+
+// Header entries, laid out like the wide offsets of detail::stream
+using offset_type = uint64_t;
+
+// MPI counts are ints, so larger transfers are split into pieces of this size
+constexpr size_t max_transfer_bytes = size_t{1} << 30u;
+
+void check(int error, const char *function) {
+    if (error != MPI_SUCCESS) {
+        char message[MPI_MAX_ERROR_STRING];
+        int length = 0;
+        MPI_Error_string(error, message, &length);
+        throw std::runtime_error{std::string{"ndzip MPI: "} + function + " failed: " + std::string(message, length)};
+    }
+}
+
+int comm_rank(MPI_Comm comm) {
+    int rank;
+    check(MPI_Comm_rank(comm, &rank), "MPI_Comm_rank");
+    return rank;
+}
+
+int comm_size(MPI_Comm comm) {
+    int size;
+    check(MPI_Comm_size(comm, &size), "MPI_Comm_size");
+    return size;
+}
+
+// Invokes transfer(begin, count) for every piece of a transfer of `bytes` bytes. Collective MPI-IO calls must be
+// matched across all ranks, so ranks with fewer pieces than others issue empty transfers.
+template<typename F>
+void transfer_in_pieces(MPI_Comm comm, size_t bytes, F &&transfer) {
+    const uint64_t num_pieces = detail::div_ceil(bytes, max_transfer_bytes);
+    uint64_t max_num_pieces;
+    check(MPI_Allreduce(&num_pieces, &max_num_pieces, 1, MPI_UINT64_T, MPI_MAX, comm), "MPI_Allreduce");
+    for (uint64_t piece = 0; piece < max_num_pieces; ++piece) {
+        const auto begin = std::min(bytes, piece * max_transfer_bytes);
+        transfer(begin, static_cast<int>(std::min(bytes - begin, max_transfer_bytes)));
+    }
+}
+
+// The compressor may use any hypercube size
+template<typename T>
+size_t max_compressed_length(const extent &size) {
+    return std::max({compressed_length_bound<T>(size, hypercube_size::smaller),
+            compressed_length_bound<T>(size, hypercube_size::standard),
+            compressed_length_bound<T>(size, hypercube_size::larger)});
+}
+
+}  // namespace
+
+
+template<typename T>
+MPI_Offset write_compressed(MPI_Comm comm, MPI_File file, MPI_Offset offset, compressor<T> &compressor,
+        const T *local_data, const extent &local_size) {
+    using compressed_type = detail::bits_type<T>;
+
+    const auto rank = comm_rank(comm);
+    const auto header_bytes = static_cast<MPI_Offset>(comm_size(comm) * sizeof(offset_type));
+
+    std::vector<compressed_type> stream(max_compressed_length<T>(local_size));
+    const offset_type stream_length = compressor.compress(local_data, local_size, stream.data());
+
+    // MPI_Exscan leaves the result undefined on rank 0
+    offset_type stream_offset = 0;
+    check(MPI_Exscan(&stream_length, &stream_offset, 1, MPI_UINT64_T, MPI_SUM, comm), "MPI_Exscan");
+    if (rank == 0) { stream_offset = 0; }
+    offset_type total_length;
+    check(MPI_Allreduce(&stream_length, &total_length, 1, MPI_UINT64_T, MPI_SUM, comm), "MPI_Allreduce");
+
+    const offset_type offset_after = stream_offset + stream_length;
+    check(MPI_File_write_at_all(file, offset + static_cast<MPI_Offset>(rank * sizeof(offset_type)), &offset_after,
+                  sizeof offset_after, MPI_BYTE, MPI_STATUS_IGNORE),
+            "MPI_File_write_at_all");
+
+    const auto stream_position
+            = offset + header_bytes + static_cast<MPI_Offset>(stream_offset * sizeof(compressed_type));
+    const auto stream_bytes = reinterpret_cast<const std::byte *>(stream.data());
+    transfer_in_pieces(comm, stream_length * sizeof(compressed_type), [&](size_t begin, int count) {
+        check(MPI_File_write_at_all(file, stream_position + static_cast<MPI_Offset>(begin), stream_bytes + begin, count,
+                      MPI_BYTE, MPI_STATUS_IGNORE),
+                "MPI_File_write_at_all");
+    });
+
+    return header_bytes + static_cast<MPI_Offset>(total_length * sizeof(compressed_type));
+}
+
+
+template<typename T>
+MPI_Offset read_compressed(MPI_Comm comm, MPI_File file, MPI_Offset offset, decompressor<T> &decompressor,
+        T *local_data, const extent &local_size) {
+    using compressed_type = detail::bits_type<T>;
+
+    const auto rank = comm_rank(comm);
+    const auto num_ranks = comm_size(comm);
+    const auto header_bytes = static_cast<MPI_Offset>(num_ranks * sizeof(offset_type));
+
+    // Entries rank - 1 and rank delimit the stream of this rank, the stream of rank 0 begins right after the header
+    offset_type entries[2] = {0, 0};
+    const auto first_entry = std::max(0, rank - 1);
+    const auto num_entries = rank == 0 ? 1 : 2;
+    check(MPI_File_read_at_all(file, offset + static_cast<MPI_Offset>(first_entry * sizeof(offset_type)),
+                  entries + 2 - num_entries, num_entries * static_cast<int>(sizeof(offset_type)), MPI_BYTE,
+                  MPI_STATUS_IGNORE),
+            "MPI_File_read_at_all");
+    const auto [stream_offset, offset_after] = entries;
+    if (offset_after < stream_offset) { throw std::runtime_error{"ndzip MPI: corrupted header"}; }
+    const offset_type stream_length = offset_after - stream_offset;
+    offset_type total_length;
+    check(MPI_Allreduce(&offset_after, &total_length, 1, MPI_UINT64_T, MPI_MAX, comm), "MPI_Allreduce");
+
+    std::vector<compressed_type> stream(stream_length);
+    const auto stream_position
+            = offset + header_bytes + static_cast<MPI_Offset>(stream_offset * sizeof(compressed_type));
+    const auto stream_bytes = reinterpret_cast<std::byte *>(stream.data());
+    transfer_in_pieces(comm, stream_length * sizeof(compressed_type), [&](size_t begin, int count) {
+        check(MPI_File_read_at_all(file, stream_position + static_cast<MPI_Offset>(begin), stream_bytes + begin, count,
+                      MPI_BYTE, MPI_STATUS_IGNORE),
+                "MPI_File_read_at_all");
+    });
+
+    if (decompressor.decompress(stream.data(), local_data, local_size) != stream_length) {
+        throw std::runtime_error{"ndzip MPI: stream of rank " + std::to_string(rank) + " does not match its extent"};
+    }
+    return header_bytes + static_cast<MPI_Offset>(total_length * sizeof(compressed_type));
+}
+
+
+#define NDZIP_INSTANTIATE_MPI_IO(T) \
+    template MPI_Offset write_compressed<T>( \
+            MPI_Comm, MPI_File, MPI_Offset, compressor<T> &, const T *, const extent &); \
+    template MPI_Offset read_compressed<T>(MPI_Comm, MPI_File, MPI_Offset, decompressor<T> &, T *, const extent &);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MPI_IO)
+#undef NDZIP_INSTANTIATE_MPI_IO
+
+}  // namespace ndzip::mpi
@@ -2,6 +2,11 @@
 
 #include <ndzip/offload.hh>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 
 namespace ndzip {
 
@@ -15,6 +20,9 @@ void compressor_requirements::include(const extent &data_size) {
         }
     }
     _max_num_hypercubes = std::max(_max_num_hypercubes, detail::num_hypercubes(data_size));
+    if (std::find(_data_sizes.begin(), _data_sizes.end(), data_size) == _data_sizes.end()) {
+        _data_sizes.push_back(data_size);
+    }
 }
 
 compressor_requirements::compressor_requirements(const extent &single_data_size) {
@@ -28,30 +36,220 @@ compressor_requirements::compressor_requirements(std::initializer_list<extent> d
 }
 
 
-template<typename T, ndzip::dim_type Dims>
-static index_type compressed_length_bound(const detail::static_extent<Dims> &size) {
-    using profile = detail::profile<T, Dims>;
-    using bits_type = typename profile::bits_type;
+void *scratch_arena::allocate(size_t size) {
+    const auto address = reinterpret_cast<uintptr_t>(_memory + _used);
+    const auto padding = (alignment - address % alignment) % alignment;
+    // Rounding up the size keeps the next buffer aligned without further padding
+    const auto length = (size + alignment - 1) / alignment * alignment;
+    if (padding > _size - _used || length > _size - _used - padding) { throw std::bad_alloc{}; }
+    const auto buffer = _memory + _used + padding;
+    _used += padding + length;
+    return buffer;
+}
 
-    const auto num_hypercubes = detail::num_hypercubes(size);
-    const auto header_length
-            = detail::div_ceil(num_hypercubes, detail::bits_of<bits_type> / detail::bits_of<index_type>);
-    const auto compressed_length_bound = num_hypercubes * profile::compressed_block_length_bound;
-    const auto border_length = detail::border_element_count(size, profile::hypercube_side_length);
-    return header_length + compressed_length_bound + border_length;
+
+template<typename T, ndzip::dim_type Dims, index_type SideLength = detail::hypercube_side_length<Dims>>
+static size_t compressed_length_bound(const detail::static_extent<Dims> &size) {
+    using profile = detail::profile<T, Dims, SideLength>;
+
+    const auto num_hypercubes = detail::num_hypercubes(size, SideLength);
+    const auto header_length = detail::stream<profile>::header_length(num_hypercubes);
+    const auto hypercubes_length = size_t{num_hypercubes} * profile::compressed_block_length_bound;
+    const auto num_border_elements = detail::border_element_count(size, profile::hypercube_side_length);
+    if constexpr (!detail::has_border_stream<Dims>) {
+        return header_length + hypercubes_length + num_border_elements;
+    } else {
+        // The border is compressed as a one-dimensional array, see detail::border_extent
+        const auto border_length = compressed_length_bound<T, 1>(
+                detail::static_extent<1>{static_cast<index_type>(num_border_elements)});
+        return header_length + hypercubes_length + border_length;
+    }
+}
+
+template<typename T, hypercube_size Size>
+static size_t compressed_length_bound(const extent &size) {
+    using detail::hypercube_side_length_for;
+    switch (size.dimensions()) {
+        case 1:
+            return compressed_length_bound<T, 1, hypercube_side_length_for(1, Size)>(detail::static_extent<1>{size});
+        case 2:
+            return compressed_length_bound<T, 2, hypercube_side_length_for(2, Size)>(detail::static_extent<2>{size});
+        case 3:
+            return compressed_length_bound<T, 3, hypercube_side_length_for(3, Size)>(detail::static_extent<3>{size});
+        default: abort();
+    }
 }
 
 template<typename T>
-index_type compressed_length_bound(const extent &size) {
+size_t compressed_length_bound(const extent &size, hypercube_size hc_size) {
+    switch (hc_size) {
+        case hypercube_size::smaller: return compressed_length_bound<T, hypercube_size::smaller>(size);
+        case hypercube_size::larger: return compressed_length_bound<T, hypercube_size::larger>(size);
+        default: return compressed_length_bound<T, hypercube_size::standard>(size);
+    }
+}
+
+#define NDZIP_INSTANTIATE_COMPRESSED_LENGTH_BOUND(T) \
+    template size_t compressed_length_bound<T>(const extent &, hypercube_size);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_COMPRESSED_LENGTH_BOUND)
+#undef NDZIP_INSTANTIATE_COMPRESSED_LENGTH_BOUND
+
+
+index_type hypercube_count(const extent &data_size, hypercube_size size) {
+    using detail::hypercube_side_length_for;
+    switch (data_size.dimensions()) {
+        case 1: return detail::num_hypercubes(detail::static_extent<1>{data_size}, hypercube_side_length_for(1, size));
+        case 2: return detail::num_hypercubes(detail::static_extent<2>{data_size}, hypercube_side_length_for(2, size));
+        case 3: return detail::num_hypercubes(detail::static_extent<3>{data_size}, hypercube_side_length_for(3, size));
+        default: abort();
+    }
+}
+
+
+template<typename T, ndzip::dim_type Dims, index_type SideLength>
+static void summarize_hypercubes(
+        const T *data, const detail::static_extent<Dims> &size, hypercube_summary<T> *summaries) {
+    using profile = detail::profile<T, Dims, SideLength>;
+    using bits_type = typename profile::bits_type;
+
+    std::vector<bits_type> cube(detail::ipow(SideLength, Dims));
+    detail::for_each_hypercube<Dims, SideLength>(size, [&](auto hc_offset, auto hc_index) {
+        detail::for_each_hypercube_slice<profile>(
+                hc_offset, data, size, cube.data(), [](const T *src, bits_type *dest, size_t n_elems) {
+                    memcpy(dest, src, n_elems * sizeof(T));
+                });
+        detail::summary_accumulator<T> acc;
+        acc.add(cube.data(), cube.size());
+        summaries[hc_index] = acc.summary();
+    });
+}
+
+template<typename T, hypercube_size Size>
+static void summarize_hypercubes(const T *data, const extent &size, hypercube_summary<T> *summaries) {
+    using detail::hypercube_side_length_for;
     switch (size.dimensions()) {
-        case 1: return compressed_length_bound<T, 1>(detail::static_extent<1>{size});
-        case 2: return compressed_length_bound<T, 2>(detail::static_extent<2>{size});
-        case 3: return compressed_length_bound<T, 3>(detail::static_extent<3>{size});
+        case 1:
+            return summarize_hypercubes<T, 1, hypercube_side_length_for(1, Size)>(
+                    data, detail::static_extent<1>{size}, summaries);
+        case 2:
+            return summarize_hypercubes<T, 2, hypercube_side_length_for(2, Size)>(
+                    data, detail::static_extent<2>{size}, summaries);
+        case 3:
+            return summarize_hypercubes<T, 3, hypercube_side_length_for(3, Size)>(
+                    data, detail::static_extent<3>{size}, summaries);
         default: abort();
     }
 }
 
-template index_type compressed_length_bound<float>(const extent &);
-template index_type compressed_length_bound<double>(const extent &);
+template<typename T>
+void summarize_hypercubes(const T *data, const extent &data_size, hypercube_summary<T> *summaries,
+        hypercube_size size) {
+    switch (size) {
+        case hypercube_size::smaller:
+            return summarize_hypercubes<T, hypercube_size::smaller>(data, data_size, summaries);
+        case hypercube_size::larger: return summarize_hypercubes<T, hypercube_size::larger>(data, data_size, summaries);
+        default: return summarize_hypercubes<T, hypercube_size::standard>(data, data_size, summaries);
+    }
+}
+
+template<typename T>
+std::vector<index_type> hypercubes_in_range(
+        const hypercube_summary<T> *summaries, index_type num_hypercubes, T lower, T upper) {
+    using bits_type = detail::bits_type<T>;
+    std::vector<index_type> hc_indices;
+    const auto lower_bits = detail::bit_cast<bits_type>(lower);
+    const auto upper_bits = detail::bit_cast<bits_type>(upper);
+    if (detail::is_nan_bits<T>(lower_bits) || detail::is_nan_bits<T>(upper_bits)) { return hc_indices; }
+
+    const auto lower_key = detail::value_order_key<T>(lower_bits);
+    const auto upper_key = detail::value_order_key<T>(upper_bits);
+    for (index_type hc_index = 0; hc_index < num_hypercubes; ++hc_index) {
+        const auto min_key = detail::value_order_key<T>(detail::bit_cast<bits_type>(summaries[hc_index].min));
+        const auto max_key = detail::value_order_key<T>(detail::bit_cast<bits_type>(summaries[hc_index].max));
+        if (min_key <= upper_key && max_key >= lower_key) { hc_indices.push_back(hc_index); }
+    }
+    return hc_indices;
+}
+
+#define NDZIP_INSTANTIATE_HYPERCUBE_SUMMARIES(T) \
+    template void summarize_hypercubes<T>(const T *, const extent &, hypercube_summary<T> *, hypercube_size); \
+    template std::vector<index_type> hypercubes_in_range<T>(const hypercube_summary<T> *, index_type, T, T);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_HYPERCUBE_SUMMARIES)
+#undef NDZIP_INSTANTIATE_HYPERCUBE_SUMMARIES
 
 }  // namespace ndzip
+
+namespace ndzip::detail {
+
+template<dim_type Dims>
+static void include_in_scratch_extent(scratch_extent &max, const static_extent<Dims> &size, index_type side_length) {
+    max.num_hypercubes = std::max(max.num_hypercubes, num_hypercubes(size, side_length));
+    max.num_border_elements = std::max(max.num_border_elements, border_element_count(size, side_length));
+}
+
+scratch_extent get_scratch_extent(const compressor_requirements &req, index_type side_length) {
+    scratch_extent max;
+    for (auto &size : get_data_sizes(req)) {
+        switch (size.dimensions()) {
+            case 1: include_in_scratch_extent(max, static_extent<1>{size}, side_length); break;
+            case 2: include_in_scratch_extent(max, static_extent<2>{size}, side_length); break;
+            case 3: include_in_scratch_extent(max, static_extent<3>{size}, side_length); break;
+            default: abort();
+        }
+    }
+    return max;
+}
+
+struct offload_queue::state {
+    std::mutex mutex;
+    std::condition_variable submitted;
+    std::condition_variable completed;
+    std::deque<std::function<void()>> ops;
+    bool busy = false;
+    bool shutdown = false;
+    std::thread worker;
+
+    void run() {
+        std::unique_lock lock{mutex};
+        for (;;) {
+            submitted.wait(lock, [&] { return shutdown || !ops.empty(); });
+            if (ops.empty()) { return; }
+            auto op = std::move(ops.front());
+            ops.pop_front();
+            busy = true;
+            lock.unlock();
+            op();  // exceptions are captured by the packaged_task behind op
+            lock.lock();
+            busy = false;
+            completed.notify_all();
+        }
+    }
+};
+
+offload_queue::offload_queue() : _state{std::make_unique<state>()} {
+    _state->worker = std::thread{[s = _state.get()] { s->run(); }};
+}
+
+offload_queue::~offload_queue() {
+    {
+        std::lock_guard lock{_state->mutex};
+        _state->shutdown = true;
+    }
+    _state->submitted.notify_one();
+    _state->worker.join();
+}
+
+void offload_queue::submit(std::function<void()> op) {
+    {
+        std::lock_guard lock{_state->mutex};
+        _state->ops.push_back(std::move(op));
+    }
+    _state->submitted.notify_one();
+}
+
+void offload_queue::wait() {
+    std::unique_lock lock{_state->mutex};
+    _state->completed.wait(lock, [&] { return _state->ops.empty() && !_state->busy; });
+}
+
+}  // namespace ndzip::detail
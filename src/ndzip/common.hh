@@ -5,11 +5,14 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <limits>
 #include <optional>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <ndzip/ndzip.hh>
 
@@ -242,29 +245,34 @@ template<typename POD, typename Memory>
     }
 }
 
-template<dim_type Dims, typename Fn>
+// The dimension is a template parameter so that the recursion is bounded at compile time, otherwise GCC warns about
+// out-of-bounds accesses to static_extent in the (unreachable) instantiations beyond Dims
+template<dim_type D, dim_type Dims, typename Fn>
 void for_each_border_slice_recursive(const static_extent<Dims> &size, static_extent<Dims> pos, index_type side_length,
-        dim_type d, dim_type smallest_dim_with_border, const Fn &fn) {
-    auto border_begin = size[d] / side_length * side_length;
-    auto border_end = size[d];
-
-    if (d < smallest_dim_with_border) {
-        for (pos[d] = 0; pos[d] < border_begin; ++pos[d]) {
-            for_each_border_slice_recursive(size, pos, side_length, d + 1, smallest_dim_with_border, fn);
+        dim_type smallest_dim_with_border, const Fn &fn) {
+    auto border_begin = size[D] / side_length * side_length;
+    auto border_end = size[D];
+
+    if constexpr (D + 1 < Dims) {
+        if (D < smallest_dim_with_border) {
+            for (pos[D] = 0; pos[D] < border_begin; ++pos[D]) {
+                for_each_border_slice_recursive<D + 1>(size, pos, side_length, smallest_dim_with_border, fn);
+            }
         }
     }
 
     if (border_begin < border_end) {
         auto begin_pos = pos;
-        begin_pos[d] = border_begin;
+        begin_pos[D] = border_begin;
         auto end_pos = pos;
-        end_pos[d] = border_end;
+        end_pos[D] = border_end;
         auto offset = linear_index(size, begin_pos);
         auto count = linear_index(size, end_pos) - offset;
         fn(offset, count);
     }
 }
 
+// Invokes fn(offset, count) for every contiguous run of border elements, in ascending order of their linear index
 template<dim_type Dims, typename Fn>
 void for_each_border_slice(const static_extent<Dims> &size, index_type side_length, const Fn &fn) {
     std::optional<dim_type> smallest_dim_with_border;
@@ -277,16 +285,16 @@ void for_each_border_slice(const static_extent<Dims> &size, index_type side_leng
         if (size[d] % side_length != 0) { smallest_dim_with_border = static_cast<int>(d); }
     }
     if (smallest_dim_with_border) {
-        for_each_border_slice_recursive(size, static_extent<Dims>{}, side_length, 0, *smallest_dim_with_border, fn);
+        for_each_border_slice_recursive<0>(size, static_extent<Dims>{}, side_length, *smallest_dim_with_border, fn);
     }
 }
 
 template<typename DataType, dim_type Dims>
-[[gnu::noinline]] index_type pack_border(
+[[gnu::noinline]] size_t pack_border(
         compressed_type<DataType> *dest, DataType *src, const static_extent<Dims> &src_size, index_type side_length) {
     static_assert(std::is_trivially_copyable_v<DataType>);
-    index_type dest_offset = 0;
-    for_each_border_slice(src_size, side_length, [&](index_type src_offset, index_type count) {
+    size_t dest_offset = 0;
+    for_each_border_slice(src_size, side_length, [&](size_t src_offset, size_t count) {
         memcpy(dest + dest_offset, src + src_offset, count * sizeof(DataType));
         dest_offset += count;
     });
@@ -294,21 +302,114 @@ template<typename DataType, dim_type Dims>
 }
 
 template<typename DataType, dim_type Dims>
-[[gnu::noinline]] index_type unpack_border(DataType *dest, const static_extent<Dims> &dest_size,
+[[gnu::noinline]] size_t unpack_border(DataType *dest, const static_extent<Dims> &dest_size,
         const compressed_type<DataType> *src, index_type side_length) {
     static_assert(std::is_trivially_copyable_v<DataType>);
-    index_type src_offset = 0;
-    for_each_border_slice(dest_size, side_length, [&](index_type dest_offset, index_type count) {
+    size_t src_offset = 0;
+    for_each_border_slice(dest_size, side_length, [&](size_t dest_offset, size_t count) {
         memcpy(dest + dest_offset, src + src_offset, count * sizeof(DataType));
         src_offset += count;
     });
     return src_offset;
 }
 
+// The contiguous runs of border elements of an array (see for_each_border_slice) together with their position in the
+// packed border, so that packing and unpacking can be divided among threads by border element.
 template<dim_type Dims>
-index_type border_element_count(const static_extent<Dims> &e, dim_type side_length) {
-    index_type n_cube_elems = 1;
-    index_type n_all_elems = 1;
+class border_slices {
+  public:
+    border_slices() = default;
+
+    border_slices(const static_extent<Dims> &size, index_type side_length) : _size(size), _side_length(side_length) {
+        for_each_border_slice(size, side_length, [&](size_t array_offset, size_t count) {
+            _slices.push_back({array_offset, _num_elements, count});
+            _num_elements += count;
+        });
+    }
+
+    bool describes(const static_extent<Dims> &size, index_type side_length) const {
+        return _size == size && _side_length == side_length;
+    }
+
+    size_t num_elements() const { return _num_elements; }
+
+    // Invokes fn(array_offset, border_offset, count) for the parts of all runs that cover border elements [first, last)
+    template<typename Fn>
+    void for_each_in_range(size_t first, size_t last, const Fn &fn) const {
+        if (first >= last) { return; }
+        auto it = std::upper_bound(_slices.begin(), _slices.end(), first,
+                [](size_t offset, const slice &s) { return offset < s.border_offset; });
+        assert(it != _slices.begin());
+        for (--it; it != _slices.end() && it->border_offset < last; ++it) {
+            const auto begin = std::max(first, it->border_offset);
+            const auto end = std::min(last, it->border_offset + it->count);
+            fn(it->array_offset + (begin - it->border_offset), begin, end - begin);
+        }
+    }
+
+  private:
+    struct slice {
+        size_t array_offset;
+        size_t border_offset;
+        size_t count;
+    };
+
+    static_extent<Dims> _size;
+    index_type _side_length = 0;
+    std::vector<slice> _slices;
+    size_t _num_elements = 0;
+};
+
+// Invokes fn(border_offset, row_pos, count) for every run of border elements that is contiguous within a row of
+// the array, in the order they appear in the packed border.
+template<dim_type Dims, typename Fn>
+void for_each_border_row(const static_extent<Dims> &size, index_type side_length, const Fn &fn) {
+    size_t border_offset = 0;
+    for_each_border_slice(size, side_length, [&](size_t offset, size_t count) {
+        while (count > 0) {
+            const auto row_pos = extent_from_linear_id(offset, size);
+            const auto row_count = static_cast<index_type>(
+                    std::min(count, static_cast<size_t>(size[Dims - 1] - row_pos[Dims - 1])));
+            fn(border_offset, row_pos, row_count);
+            offset += row_count;
+            count -= row_count;
+            border_offset += row_count;
+        }
+    });
+}
+
+// Copies the intersection of two boxes between dense row-major arrays whose first elements are located at src_offset
+// and dest_offset within a common coordinate space.
+template<typename DestType, typename SrcType, dim_type Dims>
+void copy_box_intersection(DestType *dest, const static_extent<Dims> &dest_offset,
+        const static_extent<Dims> &dest_size, const SrcType *src, const static_extent<Dims> &src_offset,
+        const static_extent<Dims> &src_size) {
+    static_assert(sizeof(DestType) == sizeof(SrcType) && std::is_trivially_copyable_v<SrcType>);
+    static_extent<Dims> lo, hi;
+    for (dim_type d = 0; d < Dims; ++d) {
+        lo[d] = std::max(dest_offset[d], src_offset[d]);
+        hi[d] = std::min(dest_offset[d] + dest_size[d], src_offset[d] + src_size[d]);
+        if (lo[d] >= hi[d]) { return; }
+    }
+
+    const auto row_length = hi[Dims - 1] - lo[Dims - 1];
+    auto pos = lo;
+    for (;;) {
+        memcpy(dest + linear_index(dest_size, pos - dest_offset), src + linear_index(src_size, pos - src_offset),
+                row_length * sizeof(DestType));
+        for (dim_type d = Dims - 1;;) {
+            if (d == 0) { return; }
+            --d;
+            if (++pos[d] < hi[d]) { break; }
+            pos[d] = lo[d];
+        }
+    }
+}
+
+template<dim_type Dims>
+size_t border_element_count(const static_extent<Dims> &e, dim_type side_length) {
+    size_t n_cube_elems = 1;
+    size_t n_all_elems = 1;
     for (dim_type d = 0; d < Dims; ++d) {
         n_cube_elems *= e[d] / side_length * side_length;
         n_all_elems *= e[d];
@@ -316,6 +417,23 @@ index_type border_element_count(const static_extent<Dims> &e, dim_type side_leng
     return n_all_elems - n_cube_elems;
 }
 
+// From stream format version 2 on, the border of a multi-dimensional array is stored as the compressed stream of a
+// one-dimensional array holding the border elements in the order of pack_border, so that shapes which are not a
+// multiple of the hypercube side length compress about as well as aligned ones. The border of a one-dimensional array
+// is shorter than a hypercube, which makes its compressed stream the verbatim elements. Before version 2, every border
+// is stored as verbatim elements in the order of pack_border.
+template<dim_type Dims>
+inline constexpr bool has_border_stream = Dims > 1 && stream_format_version >= 2;
+
+template<dim_type Dims>
+extent border_extent(const static_extent<Dims> &e, dim_type side_length) {
+    const auto n = border_element_count(e, side_length);
+    if (n > std::numeric_limits<index_type>::max()) {
+        throw std::runtime_error{"array border of " + std::to_string(n) + " elements exceeds the 32-bit limit"};
+    }
+    return extent{static_cast<index_type>(n)};
+}
+
 inline dim_type get_dimensionality(const compressor_requirements &req) {
     if (req._dims == -1) { throw std::runtime_error{"Cannot construct a compressor with empty requirements"}; }
     return req._dims;
@@ -325,31 +443,81 @@ inline index_type get_num_hypercubes(const compressor_requirements &req) {
     return req._max_num_hypercubes;
 }
 
+inline const std::vector<extent> &get_data_sizes(const compressor_requirements &req) {
+    return req._data_sizes;
+}
+
+// Upper bounds over the arrays of a compressor_requirements, which size the buffers of a CPU codec on a scratch_arena
+struct scratch_extent {
+    index_type num_hypercubes = 0;
+    size_t num_border_elements = 0;
+};
+
+scratch_extent get_scratch_extent(const compressor_requirements &req, index_type side_length);
+
+// The header holds the offset after each hypercube, relative to the first hypercube and in units of bits_type. Entries
+// are 32 bits wide unless the hypercubes of the array might not fit into 2^32 words, in which case they are 64 bits
+// wide. The width is a function of the array size alone, so arrays below about 4 G elements are unaffected.
+// The hypercubes are followed by the border, see border_extent().
 template<typename Profile>
 struct stream {
     using bits_type = std::conditional_t<std::is_const_v<Profile>, const typename Profile::bits_type,
             typename Profile::bits_type>;
     using offset_type = std::conditional_t<std::is_const_v<Profile>, const index_type, index_type>;
+    using wide_offset_type = uint64_t;
     using byte_type = std::conditional_t<std::is_const_v<Profile>, const std::byte, std::byte>;
 
-    static_assert(sizeof(bits_type) >= sizeof(offset_type) && alignof(bits_type) >= alignof(offset_type));
-
     index_type num_hypercubes;
     bits_type *buffer;
+    bool wide_offsets;
+
+    NDZIP_UNIVERSAL stream(index_type num_hypercubes, bits_type *buffer)
+        : num_hypercubes(num_hypercubes), buffer(buffer), wide_offsets(needs_wide_offsets(num_hypercubes)) {}
 
-    NDZIP_UNIVERSAL offset_type *header() { return reinterpret_cast<offset_type *>(buffer); }
+    NDZIP_UNIVERSAL constexpr static bool needs_wide_offsets(index_type num_hypercubes) {
+        return uint64_t{num_hypercubes} * Profile::compressed_block_length_bound > uint64_t{~index_type{}};
+    }
+
+    NDZIP_UNIVERSAL constexpr static size_t header_length(index_type num_hypercubes) {
+        const size_t entry_bytes = needs_wide_offsets(num_hypercubes) ? sizeof(wide_offset_type) : sizeof(index_type);
+        return div_ceil(num_hypercubes * entry_bytes, sizeof(bits_type));
+    }
 
-    NDZIP_UNIVERSAL index_type offset_after(index_type hc_index) { return header()[hc_index]; }
+    // 32-bit header entries, requires !wide_offsets and a bits_type of at least 32 bits
+    NDZIP_UNIVERSAL offset_type *header() {
+        static_assert(sizeof(bits_type) >= sizeof(offset_type) && alignof(bits_type) >= alignof(offset_type));
+        return reinterpret_cast<offset_type *>(buffer);
+    }
 
-    NDZIP_UNIVERSAL void set_offset_after(index_type hc_index, index_type position) {
-        // TODO memcpy this, else potential aliasing UB!
-        header()[hc_index] = position;
+    // Entries of streams with 8- and 16-bit words are not aligned to their width
+    NDZIP_UNIVERSAL size_t offset_after(index_type hc_index) {
+        if (wide_offsets) {
+            return load_unaligned<wide_offset_type>(
+                    reinterpret_cast<byte_type *>(buffer) + size_t{hc_index} * sizeof(wide_offset_type));
+        } else if constexpr (sizeof(bits_type) < sizeof(index_type)) {
+            return load_unaligned<index_type>(
+                    reinterpret_cast<byte_type *>(buffer) + size_t{hc_index} * sizeof(index_type));
+        } else {
+            return header()[hc_index];
+        }
+    }
+
+    NDZIP_UNIVERSAL void set_offset_after(index_type hc_index, size_t position) {
+        if (wide_offsets) {
+            store_unaligned(reinterpret_cast<byte_type *>(buffer) + size_t{hc_index} * sizeof(wide_offset_type),
+                    static_cast<wide_offset_type>(position));
+        } else if constexpr (sizeof(bits_type) < sizeof(index_type)) {
+            store_unaligned(reinterpret_cast<byte_type *>(buffer) + size_t{hc_index} * sizeof(index_type),
+                    static_cast<index_type>(position));
+        } else {
+            // TODO memcpy this, else potential aliasing UB!
+            header()[hc_index] = static_cast<index_type>(position);
+        }
     }
 
     // requires header() to be initialized
     NDZIP_UNIVERSAL bits_type *hypercube(index_type hc_index) {
-        auto base_byte_offset = ceil(num_hypercubes * bytes_of<offset_type>, bytes_of<bits_type>);
-        auto *base = reinterpret_cast<bits_type *>(reinterpret_cast<byte_type *>(buffer) + base_byte_offset);
+        auto *base = buffer + header_length(num_hypercubes);
         if (hc_index == 0) {
             return base;
         } else {
@@ -358,7 +526,8 @@ struct stream {
     }
 
     NDZIP_UNIVERSAL index_type hypercube_size(index_type hc_index) {
-        return hc_index == 0 ? offset_after(0) : offset_after(hc_index) - offset_after(hc_index - 1);
+        return static_cast<index_type>(
+                hc_index == 0 ? offset_after(0) : offset_after(hc_index) - offset_after(hc_index - 1));
     }
 
     // requires header() to be initialized
@@ -380,25 +549,101 @@ struct hypercube_side_length_s<3> : public std::integral_constant<index_type, 16
 template<dim_type Dims>
 constexpr static index_type hypercube_side_length = hypercube_side_length_s<Dims>::value;
 
-template<typename T, dim_type Dims>
+// Side lengths selectable through hypercube_size. Every hypercube must hold a whole number of 64-element bit-planes.
+constexpr index_type hypercube_side_length_for(dim_type dims, hypercube_size size) {
+    if (dims < 1 || dims > 3) { throw std::runtime_error{"Invalid dimensionality"}; }
+    switch (size) {
+        case hypercube_size::smaller: return dims == 1 ? 1024 : dims == 2 ? 32 : 8;
+        case hypercube_size::larger: return dims == 1 ? 16384 : dims == 2 ? 128 : 32;
+        default: return dims == 1 ? 4096 : dims == 2 ? 64 : 16;
+    }
+}
+
+// Floating-point formats store sign and magnitude separately. The block transform rotates their bits left by one
+// to move the sign into the least significant bit, so that small values of either sign only occupy low bit-planes.
+// Integers are two's complement, where the difference of two nearby values is small without any rotation.
+template<typename T>
+constexpr inline bool is_sign_magnitude
+        = std::is_floating_point_v<T> || std::is_same_v<T, float16> || std::is_same_v<T, bfloat16>;
+
+// Signed integer arrays are compressed by the codec of the unsigned type of the same width, which operates on the same
+// two's complement bits and produces the same stream.
+template<typename T, typename Enable = void>
+struct codec_value_type_s {
+    using type = T;
+};
+
+template<typename T>
+struct codec_value_type_s<T, std::enable_if_t<std::is_integral_v<T> && std::is_signed_v<T>>> {
+    using type = std::make_unsigned_t<T>;
+};
+
+template<typename T>
+using codec_value_type = typename codec_value_type_s<T>::type;
+
+// Expand F(T) for every element type of the CPU codecs and for every type a codec is instantiated for, respectively
+#define NDZIP_FOR_EACH_CPU_VALUE_TYPE(F) \
+    F(float) F(double) F(::ndzip::float16) F(::ndzip::bfloat16) F(int8_t) F(uint8_t) F(int16_t) F(uint16_t) F(int32_t) \
+    F(uint32_t)
+#define NDZIP_FOR_EACH_CPU_CODEC_TYPE(F) \
+    F(float) F(double) F(::ndzip::float16) F(::ndzip::bfloat16) F(uint8_t) F(uint16_t) F(uint32_t)
+
+template<typename T, dim_type Dims, index_type SideLength = hypercube_side_length<Dims>>
 class profile {
   public:
     using value_type = T;
     using bits_type = detail::bits_type<T>;
 
+    constexpr static bool sign_magnitude = is_sign_magnitude<T>;
     constexpr static dim_type dimensions = Dims;
-    constexpr static index_type hypercube_side_length = detail::hypercube_side_length<dimensions>;
-    constexpr static size_t compressed_block_length_bound
-            = detail::ipow(hypercube_side_length, Dims) / bits_of<bits_type> * (bits_of<bits_type> + 1);
+    constexpr static index_type hypercube_side_length = SideLength;
+    // Incompressible hypercubes are stored verbatim from stream format version 3 on, see hypercube_encoding
+    constexpr static size_t compressed_block_length_bound = stream_format_version >= 3
+            ? detail::ipow(hypercube_side_length, Dims)
+            : detail::ipow(hypercube_side_length, Dims) / bits_of<bits_type> * (bits_of<bits_type> + 1);
 };
 
+// Every hypercube is stored in one of three encodings, which decoders tell apart by its length in the stream alone.
+// Before stream format version 3, every hypercube is zero_bits encoded regardless of its length.
+//  - constant: all elements are equal, stored as a single word holding their bit pattern.
+//  - zero_bits: the block-transformed, bit-transposed hypercube with zero words removed, which is at least one head
+//    word per group of bits_of<bits_type> elements long. Encoders only choose it if it is shorter than the hypercube.
+//  - raw: the hypercube stored verbatim, exactly one word per element.
+enum class hypercube_encoding { constant, zero_bits, raw };
+
+template<typename Profile>
+NDZIP_UNIVERSAL constexpr hypercube_encoding hypercube_encoding_for_length(size_t length) {
+    constexpr auto hc_size = ipow(Profile::hypercube_side_length, Profile::dimensions);
+    static_assert(hc_size / bits_of<typename Profile::bits_type> > 1);
+    if constexpr (stream_format_version < 3) {
+        return hypercube_encoding::zero_bits;
+    } else if (length == 1) {
+        return hypercube_encoding::constant;
+    } else if (length == hc_size) {
+        return hypercube_encoding::raw;
+    } else {
+        return hypercube_encoding::zero_bits;
+    }
+}
+
+template<typename T, dim_type Dims, hypercube_size Size>
+using sized_profile = profile<T, Dims, hypercube_side_length_for(Dims, Size)>;
+
+// Only float and double codecs are built for hypercube sizes other than the standard one
+template<typename T>
+constexpr inline bool has_sized_profiles = std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Hypercubes are numbered with index_type, see the limits in ndzip.hh
 template<dim_type Dims>
-index_type num_hypercubes(const static_extent<Dims> &array_size) {
-    index_type num = 1;
+index_type num_hypercubes(const static_extent<Dims> &array_size, index_type side_length = hypercube_side_length<Dims>) {
+    uint64_t num = 1;
     for (dim_type d = 0; d < Dims; ++d) {
-        num *= array_size[d] / hypercube_side_length<Dims>;
+        num *= array_size[d] / side_length;
+        if (num > std::numeric_limits<index_type>::max()) {
+            throw std::runtime_error{"array of more than 2^32 - 1 hypercubes exceeds the 32-bit limit"};
+        }
     }
-    return num;
+    return static_cast<index_type>(num);
 }
 
 inline index_type num_hypercubes(const extent &size) {
@@ -411,25 +656,40 @@ inline index_type num_hypercubes(const extent &size) {
     }
 }
 
-template<dim_type Dims, dim_type ThisDim, typename F>
+// Length of the compressed border (see border_extent) in bits_type words, requires its header to be initialized
+template<typename Profile>
+size_t border_stream_length(
+        const typename Profile::bits_type *border, const static_extent<Profile::dimensions> &data_size) {
+    const auto num_border_elements = border_element_count(data_size, Profile::hypercube_side_length);
+    if constexpr (!has_border_stream<Profile::dimensions>) {
+        return num_border_elements;
+    } else {
+        using border_profile = profile<typename Profile::value_type, 1>;
+        constexpr auto border_hc_size = border_profile::hypercube_side_length;
+        stream<const border_profile> border_stream{
+                static_cast<index_type>(num_border_elements / border_hc_size), border};
+        return static_cast<size_t>(border_stream.border() - border) + num_border_elements % border_hc_size;
+    }
+}
+
+template<dim_type Dims, index_type SideLength, dim_type ThisDim, typename F>
 [[gnu::always_inline]] void
 iter_hypercubes(const static_extent<Dims> &size, static_extent<Dims> &off, index_type &i, F &f) {
     if constexpr (ThisDim == Dims) {
         invoke_for_element(f, i, off);
         ++i;
     } else {
-        for (off[ThisDim] = 0; off[ThisDim] + hypercube_side_length<Dims> <= size[ThisDim];
-                off[ThisDim] += hypercube_side_length<Dims>) {
-            iter_hypercubes<Dims, ThisDim + 1>(size, off, i, f);
+        for (off[ThisDim] = 0; off[ThisDim] + SideLength <= size[ThisDim]; off[ThisDim] += SideLength) {
+            iter_hypercubes<Dims, SideLength, ThisDim + 1>(size, off, i, f);
         }
     }
 }
 
-template<dim_type Dims, typename Fn>
+template<dim_type Dims, index_type SideLength = hypercube_side_length<Dims>, typename Fn>
 void for_each_hypercube(const static_extent<Dims> &array_size, Fn &&f) {
     index_type i = 0;
     static_extent<Dims> off{};
-    iter_hypercubes<Dims, 0>(array_size, off, i, f);
+    iter_hypercubes<Dims, SideLength, 0>(array_size, off, i, f);
 }
 
 
@@ -443,9 +703,28 @@ NDZIP_UNIVERSAL T rotate_right_1(T v) {
     return (v >> 1u) | (v << (bits_of<T> - 1u));
 }
 
+// Rotation of the sign bit of floating-point values into the least significant bit, applied by the block transform
+template<bool SignMagnitude, typename T>
+NDZIP_UNIVERSAL T sign_to_lsb(T v) {
+    if constexpr (SignMagnitude) {
+        return rotate_left_1(v);
+    } else {
+        return v;
+    }
+}
+
+template<bool SignMagnitude, typename T>
+NDZIP_UNIVERSAL T sign_from_lsb(T v) {
+    if constexpr (SignMagnitude) {
+        return rotate_right_1(v);
+    } else {
+        return v;
+    }
+}
+
 template<typename T>
 NDZIP_UNIVERSAL T complement_negative(T v) {
-    return v >> (bits_of<T> - 1u) ? v ^ (~T{} >> 1u) : v;
+    return v >> (bits_of<T> - 1u) ? static_cast<T>(v ^ (static_cast<T>(~T{}) >> 1u)) : v;
 }
 
 template<typename T>
@@ -467,9 +746,11 @@ inline void inverse_block_transform_step(T *x, index_type n, index_type s) {
 }
 
 template<typename T>
-inline void block_transform(T *x, dim_type dims, index_type n) {
-    for (index_type i = 0; i < ipow(n, dims); ++i) {
-        x[i] = rotate_left_1(x[i]);
+inline void block_transform(T *x, dim_type dims, index_type n, bool sign_magnitude = true) {
+    if (sign_magnitude) {
+        for (index_type i = 0; i < ipow(n, dims); ++i) {
+            x[i] = rotate_left_1(x[i]);
+        }
     }
 
     if (dims == 1) {
@@ -501,7 +782,7 @@ inline void block_transform(T *x, dim_type dims, index_type n) {
 }
 
 template<typename T>
-inline void inverse_block_transform(T *x, dim_type dims, index_type n) {
+inline void inverse_block_transform(T *x, dim_type dims, index_type n, bool sign_magnitude = true) {
     for (index_type i = 0; i < ipow(n, dims); ++i) {
         x[i] = complement_negative(x[i]);
     }
@@ -529,8 +810,10 @@ inline void inverse_block_transform(T *x, dim_type dims, index_type n) {
         }
     }
 
-    for (index_type i = 0; i < ipow(n, dims); ++i) {
-        x[i] = rotate_right_1(x[i]);
+    if (sign_magnitude) {
+        for (index_type i = 0; i < ipow(n, dims); ++i) {
+            x[i] = rotate_right_1(x[i]);
+        }
     }
 }
 
@@ -551,7 +834,7 @@ template<typename Profile, typename SliceDataType, typename CubeDataType, typena
             cube_ptr += side_length;
         }
     } else if constexpr (Profile::dimensions == 3) {
-        const auto stride0 = data_size[1] * data_size[2];
+        const auto stride0 = size_t{data_size[1]} * data_size[2];
         const auto stride1 = data_size[2];
         for (index_type i = 0; i < side_length; ++i) {
             auto slice_ptr1 = slice_ptr;
@@ -567,8 +850,9 @@ template<typename Profile, typename SliceDataType, typename CubeDataType, typena
     }
 }
 
-template<dim_type Dims>
-NDZIP_UNIVERSAL static_extent<Dims> extent_from_linear_id(index_type linear_id, const static_extent<Dims> &size) {
+// Index is index_type for hypercube ids and 32-bit GPU arithmetic, and size_t for element offsets in large arrays
+template<typename Index, dim_type Dims>
+NDZIP_UNIVERSAL static_extent<Dims> extent_from_linear_id(Index linear_id, const static_extent<Dims> &size) {
     static_extent<Dims> ext;
     for (dim_type nd = 0; nd < Dims; ++nd) {
         auto d = Dims - 1 - nd;
@@ -633,6 +917,176 @@ template<typename U, typename T>
     return cast;
 }
 
+// Explicit mantissa bits and exponent bias of the floating-point element types
+template<typename T>
+struct floating_point_format {
+    constexpr static int mantissa_bits = std::numeric_limits<T>::digits - 1;
+    constexpr static int exponent_bias = std::numeric_limits<T>::max_exponent - 1;
+};
+
+template<>
+struct floating_point_format<float16> {
+    constexpr static int mantissa_bits = 10;
+    constexpr static int exponent_bias = 15;
+};
+
+template<>
+struct floating_point_format<bfloat16> {
+    constexpr static int mantissa_bits = 7;
+    constexpr static int exponent_bias = 127;
+};
+
+// Applies a lossy_precision to the bit representation of floating-point values of type T. Every value is split into the
+// bits that must be kept and a number of low mantissa bits that the compressor may replace by any pattern without
+// exceeding the requested error (see cpu::truncate_hypercube).
+template<typename T, bool = is_sign_magnitude<T>>
+class mantissa_truncation {
+  public:
+    using bits_type = detail::bits_type<T>;
+
+    constexpr static int mantissa_bits = floating_point_format<T>::mantissa_bits;
+    constexpr static int exponent_bias = floating_point_format<T>::exponent_bias;
+    constexpr static bits_type max_exponent = (bits_type{1} << (bits_of<T> - 1 - mantissa_bits)) - 1;
+    constexpr static bits_type sign_bit = bits_type{1} << (bits_of<T> - 1);
+
+    struct truncated {
+        bits_type bits;  // the value with its free bits cleared
+        int free_bits;   // number of low mantissa bits that may be replaced
+    };
+
+    mantissa_truncation() = default;
+
+    explicit mantissa_truncation(const lossy_precision &precision) {
+        if (const auto bound = precision.absolute_error_bound(); bound > 0) {
+            // Replacing the c low mantissa bits of a normal value with biased exponent e errs by less than
+            // 2^(e - bias - mantissa_bits + c), which does not exceed the bound as long as c <= _free_base - e
+            int bound_exponent;
+            std::frexp(bound, &bound_exponent);  // floor(log2(bound)) == bound_exponent - 1
+            _free_base = bound_exponent - 1 + exponent_bias + mantissa_bits;
+            _error_bounded = true;
+        } else if (precision.kept_mantissa_bits() < static_cast<unsigned>(mantissa_bits)) {
+            _fixed_free_bits = mantissa_bits - static_cast<int>(precision.kept_mantissa_bits());
+        }
+    }
+
+    bool is_lossless() const { return !_error_bounded && _fixed_free_bits == 0; }
+
+    NDZIP_UNIVERSAL truncated operator()(bits_type x) const {
+        const auto exponent = static_cast<int>((x >> mantissa_bits) & max_exponent);
+        if (exponent == static_cast<int>(max_exponent)) { return {x, 0}; }  // infinity or NaN
+        int free_bits = _fixed_free_bits;
+        if (_error_bounded) {
+            // Subnormals share the scale of the smallest normal exponent
+            free_bits = _free_base - (exponent > 0 ? exponent : 1);
+            if (free_bits <= 0) { return {x, 0}; }
+            // |x| < 2^(e - bias + 1) <= bound, and so is every subnormal the free bits of a zero can encode. Keeping the
+            // sign of x bounds the error by the larger of the two magnitudes rather than their sum.
+            if (free_bits > mantissa_bits) { return {static_cast<bits_type>(x & sign_bit), mantissa_bits}; }
+        }
+        return {static_cast<bits_type>(x & ~((bits_type{1} << free_bits) - 1)), free_bits};
+    }
+
+  private:
+    int _fixed_free_bits = 0;
+    bool _error_bounded = false;
+    int _free_base = 0;
+};
+
+// Integers have no mantissa to truncate and are always compressed losslessly
+template<typename T>
+class mantissa_truncation<T, false> {
+  public:
+    using bits_type = detail::bits_type<T>;
+
+    struct truncated {
+        bits_type bits;
+        int free_bits;
+    };
+
+    mantissa_truncation() = default;
+
+    explicit mantissa_truncation(const lossy_precision &precision) {
+        if (!precision.is_lossless()) {
+            throw std::runtime_error{"Lossy precision requires a floating-point element type"};
+        }
+    }
+
+    bool is_lossless() const { return true; }
+
+    NDZIP_UNIVERSAL truncated operator()(bits_type x) const { return {x, 0}; }
+};
+
+// Maps the bits of a value of type T to an unsigned integer of the same width that orders like the value itself, so
+// that hypercube summaries of every element type are computed with unsigned integer minima and maxima. Sign-magnitude
+// values are flipped entirely if negative and have their sign set otherwise, two's complement values have their sign
+// flipped. NaNs order beyond the infinity of their sign.
+template<typename T>
+NDZIP_UNIVERSAL bits_type<T> value_order_key(bits_type<T> bits) {
+    using bits_type = detail::bits_type<T>;
+    constexpr auto sign = static_cast<bits_type>(bits_type{1} << (bits_of<T> - 1));
+    if constexpr (is_sign_magnitude<T>) {
+        return bits & sign ? static_cast<bits_type>(~bits) : static_cast<bits_type>(bits | sign);
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<bits_type>(bits ^ sign);
+    } else {
+        return bits;
+    }
+}
+
+template<typename T>
+NDZIP_UNIVERSAL bits_type<T> value_from_order_key(bits_type<T> key) {
+    using bits_type = detail::bits_type<T>;
+    constexpr auto sign = static_cast<bits_type>(bits_type{1} << (bits_of<T> - 1));
+    if constexpr (is_sign_magnitude<T>) {
+        return key & sign ? static_cast<bits_type>(key ^ sign) : static_cast<bits_type>(~key);
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<bits_type>(key ^ sign);
+    } else {
+        return key;
+    }
+}
+
+template<typename T>
+NDZIP_UNIVERSAL bool is_nan_bits(bits_type<T> bits) {
+    if constexpr (is_sign_magnitude<T>) {
+        using bits_type = detail::bits_type<T>;
+        constexpr auto magnitude_mask = static_cast<bits_type>(~bits_type{0} >> 1u);
+        constexpr auto infinity = static_cast<bits_type>(magnitude_mask >> floating_point_format<T>::mantissa_bits
+                << floating_point_format<T>::mantissa_bits);
+        return (bits & magnitude_mask) > infinity;
+    } else {
+        return false;
+    }
+}
+
+// Accumulates the hypercube_summary of a sequence of values in the representation of value_order_key, leaving out
+// NaNs. The summary of no values at all has a minimum above its maximum and matches no range query.
+template<typename T>
+class summary_accumulator {
+  public:
+    using bits_type = detail::bits_type<T>;
+
+    void add(const bits_type *values, size_t n) {
+        auto lo = _min_key, hi = _max_key;
+        for (size_t i = 0; i < n; ++i) {
+            const auto key = value_order_key<T>(values[i]);
+            const bool nan = is_nan_bits<T>(values[i]);
+            lo = std::min(lo, nan ? static_cast<bits_type>(~bits_type{0}) : key);
+            hi = std::max(hi, nan ? bits_type{0} : key);
+        }
+        _min_key = lo;
+        _max_key = hi;
+    }
+
+    hypercube_summary<T> summary() const {
+        return {bit_cast<T>(value_from_order_key<T>(_min_key)), bit_cast<T>(value_from_order_key<T>(_max_key))};
+    }
+
+  private:
+    bits_type _min_key = static_cast<bits_type>(~bits_type{0});
+    bits_type _max_key = 0;
+};
+
 inline bool verbose() {
     auto env = getenv("NDZIP_VERBOSE");
     return env && *env;
@@ -1,31 +1,137 @@
 #pragma once
 
 #include "common.hh"
+#include "cpu_dispatch.hh"
 
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <ndzip/ndzip.hh>
 #include <ndzip/offload.hh>
 
-#ifdef __AVX2__
+// The library compiles this file once per ISA level with NDZIP_CPU_ISA set by the split configuration. The codec is
+// then generated for that level through a target pragma and placed in a namespace of the same name, so the variants
+// never share a symbol, and inline code from other headers is not compiled for an instruction set the host might
+// lack. Other includers get a "native" codec for the instruction sets enabled on their command line.
+#define NDZIP_CPU_ISA_ID_generic 1
+#define NDZIP_CPU_ISA_ID_avx2 2
+#define NDZIP_CPU_ISA_ID_avx512 3
+#define NDZIP_CPU_ISA_ID_avx512_gfni 4
+#define NDZIP_CPU_ISA_ID_neon 5
+#define NDZIP_CPU_ISA_ID_EXPAND(isa) NDZIP_CPU_ISA_ID_##isa
+#define NDZIP_CPU_ISA_ID(isa) NDZIP_CPU_ISA_ID_EXPAND(isa)
+
+#ifdef NDZIP_CPU_ISA
+#define NDZIP_CPU_ISA_NAMESPACE NDZIP_CPU_ISA
+#if NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx2
+#define NDZIP_CPU_TARGET "avx2,bmi2,fma"
+#elif NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx512
+#define NDZIP_CPU_TARGET "avx2,bmi2,fma,avx512f,avx512bw"
+#elif NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx512_gfni
+#define NDZIP_CPU_TARGET "avx2,bmi2,fma,avx512f,avx512bw,avx512vbmi,gfni"
+#endif
+#else
+#define NDZIP_CPU_ISA_NAMESPACE native
+#endif
+
+// The profile instantiated by this split configuration: cpu_encoder covers the standard hypercube size of every element
+// type, cpu_encoder_sized the other hypercube sizes of float and double (see detail::has_sized_profiles)
+#if defined(SPLIT_CONFIGURATION_cpu_encoder)
+#define NDZIP_CPU_SPLIT_PROFILE profile<DATA_TYPE, DIMENSIONS>
+#elif defined(SPLIT_CONFIGURATION_cpu_encoder_sized)
+#define NDZIP_CPU_SPLIT_PROFILE sized_profile<DATA_TYPE, DIMENSIONS, hypercube_size::HYPERCUBE_SIZE>
+#endif
+
+// The block transform and zero maps need AVX-512 F and BW, only the bit transposition needs VBMI and GFNI as well
+#if (defined(__AVX512F__) && defined(__AVX512BW__)) \
+        || (defined(NDZIP_CPU_ISA) \
+                && (NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx512 \
+                        || NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx512_gfni))
+#define NDZIP_CPU_AVX512 1
+#else
+#define NDZIP_CPU_AVX512 0
+#endif
+
+#if (defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VBMI__) && defined(__GFNI__)) \
+        || (defined(NDZIP_CPU_ISA) && NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx512_gfni)
+#define NDZIP_CPU_AVX512_GFNI 1
+#else
+#define NDZIP_CPU_AVX512_GFNI 0
+#endif
+
+#if defined(__AVX2__) || NDZIP_CPU_AVX512 \
+        || (defined(NDZIP_CPU_ISA) && NDZIP_CPU_ISA_ID(NDZIP_CPU_ISA) == NDZIP_CPU_ISA_ID_avx2)
+#define NDZIP_CPU_AVX2 1
+#else
+#define NDZIP_CPU_AVX2 0
+#endif
+
+#ifdef __ARM_NEON
+#define NDZIP_CPU_NEON 1
+#else
+#define NDZIP_CPU_NEON 0
+#endif
+
+#if NDZIP_CPU_AVX2
 #include <immintrin.h>
+#elif NDZIP_CPU_NEON
+#include <arm_neon.h>
 #endif
 
 #if NDZIP_OPENMP_SUPPORT
 #include <atomic>
 #include <omp.h>
-#include <queue>
 
 #include <boost/container/static_vector.hpp>
-#include <boost/lockfree/queue.hpp>
 #include <boost/thread/thread.hpp>
 #endif
 
+#ifdef NDZIP_CPU_TARGET
+#define NDZIP_CPU_PRAGMA_STRING(...) _Pragma(#__VA_ARGS__)
+#define NDZIP_CPU_PRAGMA(...) NDZIP_CPU_PRAGMA_STRING(__VA_ARGS__)
+#ifdef __clang__
+NDZIP_CPU_PRAGMA(clang attribute push(__attribute__((target(NDZIP_CPU_TARGET))), apply_to = function))
+#else
+#pragma GCC push_options
+NDZIP_CPU_PRAGMA(GCC target(NDZIP_CPU_TARGET))
+#endif
+#endif
+
+// GCC 12 defines _mm512_undefined_epi32() and its relatives, which most AVX-512 intrinsics pass for their masked-off
+// lanes, as self-initialized variables and reports them as uninitialized wherever such an intrinsic is inlined (GCC bug
+// 105593). The AVX-512 code brackets its use of these intrinsics with the following macros.
+#if defined(__GNUC__) && !defined(__clang__)
+#define NDZIP_CPU_IGNORE_UNINITIALIZED_BEGIN \
+    _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wuninitialized\"") \
+            _Pragma("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+#define NDZIP_CPU_IGNORE_UNINITIALIZED_END _Pragma("GCC diagnostic pop")
+#else
+#define NDZIP_CPU_IGNORE_UNINITIALIZED_BEGIN
+#define NDZIP_CPU_IGNORE_UNINITIALIZED_END
+#endif
+
 
 namespace ndzip::detail::cpu {
+namespace NDZIP_CPU_ISA_NAMESPACE {}
+using namespace NDZIP_CPU_ISA_NAMESPACE;
+}  // namespace ndzip::detail::cpu
 
+namespace ndzip::detail::cpu::NDZIP_CPU_ISA_NAMESPACE {
+
+#if NDZIP_CPU_AVX512 || defined(__ARM_FEATURE_SVE)
+// SVE vector length is implementation-defined, 64 bytes matches A64FX
+constexpr static const size_t simd_width_bytes = 64;
+#elif NDZIP_CPU_NEON
+constexpr static const size_t simd_width_bytes = 16;
+#else
 constexpr static const size_t simd_width_bytes = 32;
+#endif
 
 template<typename T>
 [[gnu::always_inline]] T *assume_simd_aligned(T *x) {
@@ -88,6 +194,91 @@ class simd_aligned_buffer {
     void *_memory = nullptr;
 };
 
+// A working buffer of a codec. Buffers are either carved from a scratch_arena once, at the construction of the codec,
+// or allocated on the heap by reserve() and grown on demand, which does not preserve their contents.
+template<typename T>
+class scratch_buffer {
+    static_assert(std::is_trivially_destructible_v<T> && scratch_arena::alignment % simd_width_bytes == 0);
+
+  public:
+    scratch_buffer() = default;
+
+    // Without an arena, the buffer remains empty until reserve() is called
+    scratch_buffer(scratch_arena *arena, size_t count) : _arena(arena) {
+        if (arena) {
+            _memory = static_cast<T *>(arena->allocate(count * sizeof(T)));
+            std::uninitialized_default_construct_n(_memory, count);
+            _capacity = count;
+        }
+    }
+
+    scratch_buffer(scratch_buffer &&other) noexcept { *this = std::move(other); }
+
+    scratch_buffer &operator=(scratch_buffer &&other) noexcept {
+        release();
+        _memory = std::exchange(other._memory, nullptr);
+        _capacity = std::exchange(other._capacity, 0);
+        _arena = std::exchange(other._arena, nullptr);
+        return *this;
+    }
+
+    ~scratch_buffer() { release(); }
+
+    void reserve(size_t count) {
+        if (count <= _capacity) { return; }
+        if (_arena) {
+            throw std::length_error{"array exceeds the compressor_requirements the codec's scratch_arena was sized for"};
+        }
+        release();
+        const auto bytes = detail::ceil(count * sizeof(T), scratch_arena::alignment);
+#ifdef _MSC_VER
+        _memory = static_cast<T *>(_aligned_malloc(bytes, scratch_arena::alignment));
+#else
+        _memory = static_cast<T *>(std::aligned_alloc(scratch_arena::alignment, bytes));
+#endif
+        if (!_memory) { throw std::bad_alloc(); }
+        std::uninitialized_default_construct_n(_memory, count);
+        _capacity = count;
+    }
+
+    size_t capacity() const { return _capacity; }
+
+    T *data() { return assume_simd_aligned(_memory); }
+
+    const T *data() const { return assume_simd_aligned(static_cast<const T *>(_memory)); }
+
+    T &operator[](size_t i) { return data()[i]; };
+
+    const T &operator[](size_t i) const { return data()[i]; };
+
+  private:
+    T *_memory = nullptr;
+    size_t _capacity = 0;
+    scratch_arena *_arena = nullptr;
+
+    void release() {
+        if (!_arena) {
+#ifdef _MSC_VER
+            _aligned_free(_memory);
+#else
+            std::free(_memory);
+#endif
+        }
+        _memory = nullptr;
+        _capacity = 0;
+    }
+};
+
+// Hypercube rows of 8- and 16-bit elements in three dimensions are shorter than a SIMD vector
+template<typename Profile, typename T>
+[[gnu::always_inline]] T *assume_hypercube_row_aligned(T *x) {
+    if constexpr (Profile::hypercube_side_length * sizeof(typename Profile::bits_type) % simd_width_bytes == 0) {
+        return assume_simd_aligned(x);
+    } else {
+        return x;
+    }
+}
+
 template<typename Profile>
 [[gnu::noinline]] void
 load_hypercube(const static_extent<Profile::dimensions> &hc_offset, const typename Profile::value_type *data,
@@ -97,10 +288,144 @@ load_hypercube(const static_extent<Profile::dimensions> &hc_offset, const typena
 
     for_each_hypercube_slice<Profile>(
             hc_offset, data, data_size, cube, [](const value_type *src, bits_type *dest, size_t n_elems) {
-                memcpy(assume_simd_aligned(dest), src, n_elems * sizeof(value_type));
+                memcpy(assume_hypercube_row_aligned<Profile>(dest), src, n_elems * sizeof(value_type));
             });
 }
 
+// Rows of a multi-dimensional hypercube are strided across as many pages as the cube has rows, which defeats the
+// hardware prefetcher. Issuing the loads for the next hypercube while the current one is transformed and encoded
+// hides that latency. One-dimensional hypercubes are contiguous and left to the hardware.
+template<typename Profile>
+[[gnu::always_inline]] inline void
+prefetch_hypercube(const static_extent<Profile::dimensions> &hc_offset, const typename Profile::value_type *data,
+        const static_extent<Profile::dimensions> &data_size) {
+    constexpr auto side_length = Profile::hypercube_side_length;
+    constexpr size_t row_bytes = side_length * sizeof(typename Profile::value_type);
+    constexpr size_t cache_line_bytes = 64;
+
+    const auto prefetch_row = [](const typename Profile::value_type *row) {
+        for (size_t offset = 0; offset < row_bytes; offset += cache_line_bytes) {
+            __builtin_prefetch(reinterpret_cast<const char *>(row) + offset, 0 /* read */, 3 /* all cache levels */);
+        }
+    };
+
+    if constexpr (Profile::dimensions == 2) {
+        const auto slice_ptr = &data[linear_index(data_size, hc_offset)];
+        for (index_type i = 0; i < side_length; ++i) {
+            prefetch_row(slice_ptr + i * size_t{data_size[1]});
+        }
+    } else if constexpr (Profile::dimensions == 3) {
+        const auto slice_ptr = &data[linear_index(data_size, hc_offset)];
+        const auto stride0 = size_t{data_size[1]} * data_size[2];
+        const auto stride1 = size_t{data_size[2]};
+        for (index_type i = 0; i < side_length; ++i) {
+            for (index_type j = 0; j < side_length; ++j) {
+                prefetch_row(slice_ptr + i * stride0 + j * stride1);
+            }
+        }
+    }
+}
+
+// Prefetches hypercube hc_index + 1 from a compression loop over the hypercubes before end_hc_index
+template<typename Profile>
+[[gnu::always_inline]] inline void prefetch_next_hypercube(index_type hc_index, index_type end_hc_index,
+        const typename Profile::value_type *data, const static_extent<Profile::dimensions> &data_size) {
+    constexpr auto side_length = Profile::hypercube_side_length;
+    if (hc_index + 1 < end_hc_index) {
+        prefetch_hypercube<Profile>(
+                detail::extent_from_linear_id(hc_index + 1, data_size / side_length) * side_length, data, data_size);
+    }
+}
+
+// Copies compressed chunks from thread-local scratch to the output stream. The stream is written exactly once and not
+// read again by the compressor, so on x86 the aligned bulk of the copy uses non-temporal stores that bypass the cache
+// instead of evicting the input that other threads are about to read. Small copies, which would mostly write partial
+// cache lines, fall back to memcpy.
+inline void copy_to_stream(void *dest, const void *src, size_t n_bytes) {
+#if NDZIP_CPU_AVX2
+    constexpr size_t non_temporal_threshold = 4096;
+    constexpr size_t vector_bytes = sizeof(__m256i);
+    if (n_bytes >= non_temporal_threshold) {
+        auto out = static_cast<std::byte *>(dest);
+        auto in = static_cast<const std::byte *>(src);
+        const auto head = (vector_bytes - reinterpret_cast<uintptr_t>(out) % vector_bytes) % vector_bytes;
+        memcpy(out, in, head);
+        out += head;
+        in += head;
+        n_bytes -= head;
+        for (; n_bytes >= vector_bytes; n_bytes -= vector_bytes) {
+            _mm256_stream_si256(reinterpret_cast<__m256i *>(out),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in)));
+            out += vector_bytes;
+            in += vector_bytes;
+        }
+        memcpy(out, in, n_bytes);
+        // Non-temporal stores are weakly ordered and must be visible before the stream is handed to another thread
+        _mm_sfence();
+        return;
+    }
+#endif
+    memcpy(dest, src, n_bytes);
+}
+
+// Lossy precision for a loaded hypercube, applied ahead of the block transform. Simply clearing the free low bits of
+// every value would not help compression, because the transform stores negative residuals complemented, which turns
+// their zero low bits into ones. Instead, the free bits of each value are chosen such that the low bits of its
+// residual - the difference to the prediction from its already-truncated lower neighbors that block_transform
+// computes - are all zero for a non-negative and all one for a negative residual. Both become zero bit-planes.
+template<typename Profile>
+[[gnu::noinline]] void truncate_hypercube(
+        typename Profile::bits_type *cube, const mantissa_truncation<typename Profile::value_type> &truncation) {
+    using bits_type = typename Profile::bits_type;
+    using signed_bits_type = std::make_signed_t<bits_type>;
+    constexpr auto dims = Profile::dimensions;
+    constexpr index_type n = Profile::hypercube_side_length;
+    constexpr auto hc_size = detail::ipow(n, dims);
+
+    const auto rotated = [&](size_t i) { return sign_to_lsb<Profile::sign_magnitude>(cube[i]); };
+    for (size_t i = 0; i < hc_size; ++i) {
+        const auto [truncated_bits, free_bits] = truncation(cube[i]);
+        if (free_bits == 0) {
+            cube[i] = truncated_bits;
+            continue;
+        }
+
+        // Lorenzo prediction, which is what the separable block transform subtracts
+        const auto x = i % n;
+        bits_type prediction = 0;
+        if constexpr (dims == 1) {
+            if (x > 0) { prediction = rotated(i - 1); }
+        } else if constexpr (dims == 2) {
+            const auto y = i / n;
+            if (x > 0) { prediction += rotated(i - 1); }
+            if (y > 0) { prediction += rotated(i - n); }
+            if (x > 0 && y > 0) { prediction -= rotated(i - n - 1); }
+        } else {
+            const auto y = i / n % n;
+            const auto z = i / (n * n);
+            if (x > 0) { prediction += rotated(i - 1); }
+            if (y > 0) { prediction += rotated(i - n); }
+            if (z > 0) { prediction += rotated(i - n * n); }
+            if (x > 0 && y > 0) { prediction -= rotated(i - n - 1); }
+            if (x > 0 && z > 0) { prediction -= rotated(i - n * n - 1); }
+            if (y > 0 && z > 0) { prediction -= rotated(i - n * n - n); }
+            if (x > 0 && y > 0 && z > 0) { prediction += rotated(i - n * n - n - 1); }
+        }
+
+        // The free mantissa bits are bits 1 to free_bits of the rotated value, and adding to them never carries
+        const auto value = sign_to_lsb<Profile::sign_magnitude>(truncated_bits);
+        const auto residual = static_cast<bits_type>(value - prediction);
+        const auto free_mask = static_cast<bits_type>((bits_type{1} << free_bits) - 1);
+        const auto residual_free_bits = static_cast<bits_type>(residual >> 1u) & free_mask;
+        auto fill = static_cast<bits_type>(-residual_free_bits) & free_mask;
+        if (static_cast<signed_bits_type>(residual + (fill << 1u)) < 0) {
+            const auto ones_fill = static_cast<bits_type>(free_mask - residual_free_bits) & free_mask;
+            if (static_cast<signed_bits_type>(residual + (ones_fill << 1u)) < 0) { fill = ones_fill; }
+        }
+        cube[i] = sign_from_lsb<Profile::sign_magnitude>(static_cast<bits_type>(value + (fill << 1u)));
+    }
+}
+
 template<typename Profile>
 [[gnu::noinline]] void
 store_hypercube(const static_extent<Profile::dimensions> &hc_offset, const typename Profile::bits_type *cube,
@@ -110,12 +435,40 @@ store_hypercube(const static_extent<Profile::dimensions> &hc_offset, const typen
 
     for_each_hypercube_slice<Profile>(
             hc_offset, data, data_size, cube, [](value_type *dest, const bits_type *src, size_t n_elems) {
-                memcpy(dest, assume_simd_aligned(src), n_elems * sizeof(value_type));
+                memcpy(dest, assume_hypercube_row_aligned<Profile>(src), n_elems * sizeof(value_type));
             });
 }
 
 
-#ifdef __AVX2__
+// The horizontal prefix sums of the inverse transform are inherently sequential and shared by all SIMD variants
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void inverse_block_transform_horizontal_sequential(Bits *x) {
+    for (size_t i = 1; i < SideLength; ++i) {
+        x[i] += x[i - 1];
+    }
+}
+
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void inverse_block_transform_horizontal_interleaved(Bits *x) {
+    constexpr auto interleave = 4;
+    Bits vec[interleave];
+    for (size_t i = 0; i < ipow(SideLength, 2); i += SideLength * interleave) {
+        for (size_t k = 0; k < interleave; ++k) {
+            vec[k] = x[i + k * SideLength];
+        }
+        for (size_t j = 1; j < SideLength; ++j) {
+            for (size_t k = 0; k < interleave; ++k) {
+                vec[k] += x[i + j + k * SideLength];
+            }
+            for (size_t k = 0; k < interleave; ++k) {
+                x[i + j + k * SideLength] = vec[k];
+            }
+        }
+    }
+}
+
+
+#if NDZIP_CPU_AVX2
 
 [[gnu::always_inline]] inline __m256i load_aligned_256(const void *p) {
     return _mm256_load_si256(static_cast<const __m256i *>(p));
@@ -149,8 +502,8 @@ template<typename Bits>
 
 template<index_type SideLength, typename Bits>
 [[gnu::always_inline]] void block_transform_horizontal_avx2(Bits *line) {
-    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / simd_width_bytes;
-    constexpr auto words_per_256bit_lane = simd_width_bytes / sizeof(Bits);
+    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / sizeof(__m256i);
+    constexpr auto words_per_256bit_lane = sizeof(__m256i) / sizeof(Bits);
 
     // TODO is there a better option than the setr sequence? vpmaskmov and overflowing vmovdqu +
     // blend are both slower.
@@ -175,7 +528,7 @@ template<index_type SideLength, typename Bits>
 [[gnu::always_inline]] inline void block_transform_vertical_avx2(Bits *x) {
     // TODO investigate whether SW pipelining leads to spilling / reloading for 2D double (2*64/4 =
     // 32 YMM registers)
-    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / simd_width_bytes;
+    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / sizeof(__m256i);
 
     __m256i lanes_a[n_256bit_lanes];
     __m256i lanes_b[n_256bit_lanes];
@@ -193,7 +546,7 @@ template<index_type SideLength, typename Bits>
 
 template<index_type SideLength, typename Bits>
 [[gnu::always_inline]] inline void block_transform_planes_avx2(Bits *x) {
-    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / simd_width_bytes;
+    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / sizeof(__m256i);
     constexpr auto n = SideLength;
 
     for (size_t i = 0; i < n * n; i += n) {
@@ -219,7 +572,7 @@ void block_transform_avx2(typename Profile::bits_type *x) {
     x = assume_simd_aligned(x);
 
     for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
-        x[i] = rotate_left_1(x[i]);
+        x[i] = sign_to_lsb<Profile::sign_magnitude>(x[i]);
     }
 
     if constexpr (dims == 1) {
@@ -244,36 +597,10 @@ void block_transform_avx2(typename Profile::bits_type *x) {
     }
 }
 
-template<index_type SideLength, typename Bits>
-[[gnu::always_inline]] inline void inverse_block_transform_horizontal_sequential(Bits *x) {
-    for (size_t i = 1; i < SideLength; ++i) {
-        x[i] += x[i - 1];
-    }
-}
-
-template<index_type SideLength, typename Bits>
-[[gnu::always_inline]] inline void inverse_block_transform_horizontal_interleaved(Bits *x) {
-    constexpr auto interleave = 4;
-    Bits vec[interleave];
-    for (size_t i = 0; i < ipow(SideLength, 2); i += SideLength * interleave) {
-        for (size_t k = 0; k < interleave; ++k) {
-            vec[k] = x[i + k * SideLength];
-        }
-        for (size_t j = 1; j < SideLength; ++j) {
-            for (size_t k = 0; k < interleave; ++k) {
-                vec[k] += x[i + j + k * SideLength];
-            }
-            for (size_t k = 0; k < interleave; ++k) {
-                x[i + j + k * SideLength] = vec[k];
-            }
-        }
-    }
-}
-
 template<index_type SideLength, typename Bits>
 [[gnu::always_inline]] inline void inverse_block_transform_vertical_avx2(Bits *x) {
-    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / simd_width_bytes;
-    constexpr auto words_per_256bit_lane = simd_width_bytes / sizeof(Bits);
+    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / sizeof(__m256i);
+    constexpr auto words_per_256bit_lane = sizeof(__m256i) / sizeof(Bits);
 
     __m256i lanes_a[n_256bit_lanes];
     __builtin_memcpy(lanes_a, assume_simd_aligned(x), sizeof lanes_a);
@@ -289,8 +616,8 @@ template<index_type SideLength, typename Bits>
 
 template<index_type SideLength, typename Bits>
 [[gnu::always_inline]] inline void inverse_block_transform_planes_avx2(Bits *x) {
-    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / simd_width_bytes;
-    constexpr auto words_per_256bit_lane = simd_width_bytes / sizeof(Bits);
+    constexpr auto n_256bit_lanes = sizeof(Bits) * SideLength / sizeof(__m256i);
+    constexpr auto words_per_256bit_lane = sizeof(__m256i) / sizeof(Bits);
     constexpr auto n = SideLength;
 
     for (size_t i = 0; i < n * n; i += n) {
@@ -333,127 +660,585 @@ void inverse_block_transform_avx2(typename Profile::bits_type *x) {
     }
 
     for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
-        x[i] = rotate_right_1(x[i]);
+        x[i] = sign_from_lsb<Profile::sign_magnitude>(x[i]);
     }
 }
 
-#endif  // __AVX2__
+#endif  // NDZIP_CPU_AVX2
 
-template<typename Profile>
-[[gnu::noinline]] void block_transform(typename Profile::bits_type *x) {
-#ifdef __AVX2__
-    block_transform_avx2<Profile>(x);
-#else
-    ndzip::detail::block_transform(x, Profile::dimensions, Profile::hypercube_side_length);
-#endif
+#if NDZIP_CPU_AVX512
+
+[[gnu::always_inline]] inline __m512i load_aligned_512(const void *p) {
+    return _mm512_load_si512(p);
 }
 
-template<typename Profile>
-[[gnu::noinline]] void inverse_block_transform(typename Profile::bits_type *x) {
-#ifdef __AVX2__
-    inverse_block_transform_avx2<Profile>(x);
-#else
-    ndzip::detail::inverse_block_transform(x, Profile::dimensions, Profile::hypercube_side_length);
-#endif
+[[gnu::always_inline]] inline __m512i load_unaligned_512(const void *p) {
+    return _mm512_loadu_si512(p);
 }
 
+[[gnu::always_inline]] inline void store_aligned_512(void *p, __m512i x) {
+    _mm512_store_si512(p, x);
+}
 
-template<typename T>
-T generate_zero_map(const T *u) {
-    u = assume_simd_aligned(u);
-    T zero_map = 0;
-    for (index_type j = 0; j < bits_of<T>; ++j) {
-        zero_map |= u[j];
+template<typename Bits>
+[[gnu::always_inline]] __m512i add_packed(__m512i a, __m512i b) {
+    if constexpr (bits_of<Bits> == 32) {
+        return _mm512_add_epi32(a, b);
+    } else {
+        return _mm512_add_epi64(a, b);
     }
-    return zero_map;
 }
 
-
-template<typename T>
-[[gnu::always_inline]] void transpose_bits_trivial(const T *__restrict vs, T *__restrict out) {
-    for (index_type i = 0; i < bits_of<T>; ++i) {
-        out[i] = 0;
-        for (index_type j = 0; j < bits_of<T>; ++j) {
-            out[i] |= ((vs[j] >> (bits_of<T> - 1 - i)) & 1u) << (bits_of<T> - 1 - j);
-        }
+template<typename Bits>
+[[gnu::always_inline]] __m512i subtract_packed(__m512i a, __m512i b) {
+    if constexpr (bits_of<Bits> == 32) {
+        return _mm512_sub_epi32(a, b);
+    } else {
+        return _mm512_sub_epi64(a, b);
     }
 }
 
-#ifdef __AVX2__
-
-[[gnu::always_inline]] inline void transpose_bits_avx2(const uint32_t *__restrict vs, uint32_t *__restrict out) {
-    __m256i unpck0[4];
-    __builtin_memcpy(unpck0, assume_simd_aligned(vs), sizeof unpck0);
-
-    // 1. In order to generate 32 transpositions using only 32 *movemask* instructions,
-    // first shuffle bytes so that the i-th 256-bit vector contains the i-th byte of
-    // each float
-
-    __m256i shuf[4];
-    {
-        // interpret each 128-bit lane as a 4x4 matrix and transpose it
-        // also correct endianess for later
-        // clang-format off
-        uint8_t idx8[] = {
-                12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3,
-                12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3,
-        };
-        // clang-format on
-        __m256i idx;
-        __builtin_memcpy(&idx, idx8, sizeof idx);
-        for (index_type i = 0; i < 4; ++i) {
-            shuf[i] = _mm256_shuffle_epi8(unpck0[i], idx);
-        }
+// Loads line[-1 .. words_per_lane - 2] with line[-1] reading as zero. Masked-out elements never fault, so this
+// replaces the setr sequence of the AVX2 variant.
+template<typename Bits>
+[[gnu::always_inline]] __m512i load_first_predecessors_512(const Bits *line) {
+    if constexpr (bits_of<Bits> == 32) {
+        return _mm512_maskz_loadu_epi32(__mmask16{0xfffe}, line - 1);
+    } else {
+        return _mm512_maskz_loadu_epi64(__mmask8{0xfe}, line - 1);
     }
+}
 
-    __m256i perm[4];
-    {
-        // interleave doublewords within each 256-bit vector
-        // quadword i will contain elements {i, i+4, i+8, ... i+28}
-        uint32_t idx32[] = {7, 3, 6, 2, 5, 1, 4, 0};
-        __m256i idx;
-        __builtin_memcpy(&idx, idx32, sizeof idx);
-        for (index_type i = 0; i < 4; ++i) {
-            perm[i] = _mm256_permutevar8x32_epi32(shuf[i], idx);
-        }
-    }
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] void block_transform_horizontal_avx512(Bits *line) {
+    constexpr auto n_512bit_lanes = sizeof(Bits) * SideLength / sizeof(__m512i);
+    constexpr auto words_per_512bit_lane = sizeof(__m512i) / sizeof(Bits);
 
-    __m256i unpck1[4];
-    for (index_type i = 0; i < 4; i += 2) {
-        // interleave quadwords of neighboring 256-bit vectors
-        // each double-quadword will contain elements with stride 4
-        unpck1[i + 1] = _mm256_unpackhi_epi64(perm[i + 1], perm[i + 0]);
-        unpck1[i + 0] = _mm256_unpacklo_epi64(perm[i + 1], perm[i + 0]);
+    __m512i top_n = load_first_predecessors_512(line);
+    for (index_type j = 0; j < n_512bit_lanes - 1; ++j) {
+        auto top = top_n;
+        top_n = load_unaligned_512(line + (j + 1) * words_per_512bit_lane - 1);
+        auto bottom = load_aligned_512(line + j * words_per_512bit_lane);
+        store_aligned_512(line + j * words_per_512bit_lane, subtract_packed<Bits>(bottom, top));
     }
+    auto bottom = load_aligned_512(line + (n_512bit_lanes - 1) * words_per_512bit_lane);
+    store_aligned_512(line + (n_512bit_lanes - 1) * words_per_512bit_lane, subtract_packed<Bits>(bottom, top_n));
+}
 
-    // is _mm256_inserti128_si256 faster here?
-    __m256i perm2[4] = {
-            // combine matching 128-bit lanes
-            _mm256_permute2x128_si256(unpck1[2], unpck1[0], 0x20),
-            _mm256_permute2x128_si256(unpck1[3], unpck1[1], 0x20),
-            _mm256_permute2x128_si256(unpck1[2], unpck1[0], 0x31),
-            _mm256_permute2x128_si256(unpck1[3], unpck1[1], 0x31),
-    };
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void block_transform_vertical_avx512(Bits *x) {
+    constexpr auto n_512bit_lanes = sizeof(Bits) * SideLength / sizeof(__m512i);
 
-    // 2. Transpose by extracting the 32 MSBs of each byte of each 256-byte vector
+    __m512i lanes_a[n_512bit_lanes];
+    __m512i lanes_b[n_512bit_lanes];
+    __builtin_memcpy(lanes_b, assume_simd_aligned(x), sizeof lanes_b);
 
-    for (index_type i = 0; i < 4; ++i) {
-        for (index_type j = 0; j < 8; ++j) {
-            out[i * 8 + j] = _mm256_movemask_epi8(perm2[i]);
-            perm2[i] = _mm256_slli_epi32(perm2[i], 1);
+    for (size_t i = 1; i < SideLength; ++i) {
+        __builtin_memcpy(lanes_a, lanes_b, sizeof lanes_b);
+        __builtin_memcpy(lanes_b, assume_simd_aligned(x + i * SideLength), sizeof lanes_b);
+        for (size_t j = 0; j < n_512bit_lanes; ++j) {
+            lanes_a[j] = subtract_packed<Bits>(lanes_b[j], lanes_a[j]);
         }
+        __builtin_memcpy(assume_simd_aligned(x + i * SideLength), lanes_a, sizeof lanes_a);
     }
 }
 
-[[gnu::always_inline]] inline void transpose_bits_avx2(const uint64_t *__restrict vs, uint64_t *__restrict out) {
-    __m256i in[16];
-    __builtin_memcpy(in, __builtin_assume_aligned(vs, 32), sizeof in);
-
-    // TODO Clang does a lot of spilling and reloading here because it's running out of YMM
-    // registers. GCC less so. Can this be improved, e.g. by merging operations that can operate on
-    // a subset of the 16 vectors?
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void block_transform_planes_avx512(Bits *x) {
+    constexpr auto n_512bit_lanes = sizeof(Bits) * SideLength / sizeof(__m512i);
+    constexpr auto n = SideLength;
 
-    __m256i unpck0[16];
+    for (size_t i = 0; i < n * n; i += n) {
+        __m512i lanes_a[n_512bit_lanes];
+        __m512i lanes_b[n_512bit_lanes];
+        __builtin_memcpy(lanes_b, assume_simd_aligned(x + i), sizeof lanes_b);
+        for (size_t j = n * n; j < n * n * n; j += n * n) {
+            __builtin_memcpy(lanes_a, lanes_b, sizeof lanes_b);
+            __builtin_memcpy(lanes_b, assume_simd_aligned(x + i + j), sizeof lanes_b);
+            for (size_t k = 0; k < n_512bit_lanes; ++k) {
+                lanes_a[k] = subtract_packed<Bits>(lanes_b[k], lanes_a[k]);
+            }
+            __builtin_memcpy(assume_simd_aligned(x + i + j), lanes_a, sizeof lanes_a);
+        }
+    }
+}
+
+template<typename Profile>
+void block_transform_avx512(typename Profile::bits_type *x) {
+    constexpr size_t dims = Profile::dimensions;
+    constexpr size_t side_length = Profile::hypercube_side_length;
+
+    x = assume_simd_aligned(x);
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = sign_to_lsb<Profile::sign_magnitude>(x[i]);
+    }
+
+    if constexpr (dims == 1) {
+        block_transform_horizontal_avx512<side_length>(x);
+    } else if constexpr (dims == 2) {
+        for (size_t i = 0; i < side_length; ++i) {
+            block_transform_horizontal_avx512<side_length>(x + i * side_length);
+        }
+        block_transform_vertical_avx512<side_length>(x);
+    } else if constexpr (dims == 3) {
+        for (size_t i = 0; i < side_length * side_length * side_length; i += side_length) {
+            block_transform_horizontal_avx512<side_length>(x + i);
+        }
+        for (size_t i = 0; i < side_length * side_length * side_length; i += side_length * side_length) {
+            block_transform_vertical_avx512<side_length>(x + i);
+        }
+        block_transform_planes_avx512<side_length>(x);
+    }
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = complement_negative(x[i]);
+    }
+}
+
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void inverse_block_transform_vertical_avx512(Bits *x) {
+    constexpr auto n_512bit_lanes = sizeof(Bits) * SideLength / sizeof(__m512i);
+    constexpr auto words_per_512bit_lane = sizeof(__m512i) / sizeof(Bits);
+
+    __m512i lanes_a[n_512bit_lanes];
+    __builtin_memcpy(lanes_a, assume_simd_aligned(x), sizeof lanes_a);
+
+    for (size_t i = 1; i < SideLength; ++i) {
+        for (size_t j = 0; j < n_512bit_lanes; ++j) {
+            __m512i b = load_aligned_512(x + i * SideLength + j * words_per_512bit_lane);
+            lanes_a[j] = add_packed<Bits>(lanes_a[j], b);
+        }
+        __builtin_memcpy(assume_simd_aligned(x + i * SideLength), lanes_a, sizeof lanes_a);
+    }
+}
+
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void inverse_block_transform_planes_avx512(Bits *x) {
+    constexpr auto n_512bit_lanes = sizeof(Bits) * SideLength / sizeof(__m512i);
+    constexpr auto words_per_512bit_lane = sizeof(__m512i) / sizeof(Bits);
+    constexpr auto n = SideLength;
+
+    for (size_t i = 0; i < n * n; i += n) {
+        __m512i lanes_a[n_512bit_lanes];
+        __builtin_memcpy(lanes_a, assume_simd_aligned(x + i), sizeof lanes_a);
+        for (size_t j = n * n; j < n * n * n; j += n * n) {
+            for (size_t k = 0; k < n_512bit_lanes; ++k) {
+                __m512i b = load_aligned_512(x + i + j + k * words_per_512bit_lane);
+                lanes_a[k] = add_packed<Bits>(lanes_a[k], b);
+            }
+            __builtin_memcpy(assume_simd_aligned(x + i + j), lanes_a, sizeof lanes_a);
+        }
+    }
+}
+
+template<typename Profile>
+void inverse_block_transform_avx512(typename Profile::bits_type *x) {
+    constexpr size_t dims = Profile::dimensions;
+    constexpr size_t side_length = Profile::hypercube_side_length;
+
+    x = assume_simd_aligned(x);
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = complement_negative(x[i]);
+    }
+
+    if constexpr (dims == 1) {
+        inverse_block_transform_horizontal_sequential<side_length>(x);
+    } else if constexpr (dims == 2) {
+        inverse_block_transform_horizontal_interleaved<side_length>(x);
+        inverse_block_transform_vertical_avx512<side_length>(x);
+    } else if constexpr (dims == 3) {
+        for (size_t i = 0; i < ipow(side_length, 3); i += ipow(side_length, 2)) {
+            inverse_block_transform_horizontal_interleaved<side_length>(x + i);
+        }
+        for (size_t i = 0; i < ipow(side_length, 3); i += ipow(side_length, 2)) {
+            inverse_block_transform_vertical_avx512<side_length>(x + i);
+        }
+        inverse_block_transform_planes_avx512<side_length>(x);
+    }
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = sign_from_lsb<Profile::sign_magnitude>(x[i]);
+    }
+}
+
+#endif  // NDZIP_CPU_AVX512
+
+#if NDZIP_CPU_NEON
+
+[[gnu::always_inline]] inline uint32x4_t load_neon(const uint32_t *p) {
+    return vld1q_u32(p);
+}
+
+[[gnu::always_inline]] inline uint64x2_t load_neon(const uint64_t *p) {
+    return vld1q_u64(p);
+}
+
+[[gnu::always_inline]] inline void store_neon(uint32_t *p, uint32x4_t x) {
+    vst1q_u32(p, x);
+}
+
+[[gnu::always_inline]] inline void store_neon(uint64_t *p, uint64x2_t x) {
+    vst1q_u64(p, x);
+}
+
+[[gnu::always_inline]] inline uint32x4_t add_packed(uint32x4_t a, uint32x4_t b) {
+    return vaddq_u32(a, b);
+}
+
+[[gnu::always_inline]] inline uint64x2_t add_packed(uint64x2_t a, uint64x2_t b) {
+    return vaddq_u64(a, b);
+}
+
+[[gnu::always_inline]] inline uint32x4_t subtract_packed(uint32x4_t a, uint32x4_t b) {
+    return vsubq_u32(a, b);
+}
+
+[[gnu::always_inline]] inline uint64x2_t subtract_packed(uint64x2_t a, uint64x2_t b) {
+    return vsubq_u64(a, b);
+}
+
+[[gnu::always_inline]] inline uint32x4_t or_packed(uint32x4_t a, uint32x4_t b) {
+    return vorrq_u32(a, b);
+}
+
+[[gnu::always_inline]] inline uint64x2_t or_packed(uint64x2_t a, uint64x2_t b) {
+    return vorrq_u64(a, b);
+}
+
+[[gnu::always_inline]] inline uint32_t or_reduce_neon(uint32x4_t x) {
+    const auto halves = vorr_u32(vget_low_u32(x), vget_high_u32(x));
+    return vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1);
+}
+
+[[gnu::always_inline]] inline uint64_t or_reduce_neon(uint64x2_t x) {
+    return vgetq_lane_u64(x, 0) | vgetq_lane_u64(x, 1);
+}
+
+// {0, x[0], x[1], ...}, i.e. the predecessors of the first vector in a row
+[[gnu::always_inline]] inline uint32x4_t first_predecessors_neon(uint32x4_t x) {
+    return vextq_u32(vdupq_n_u32(0), x, 3);
+}
+
+[[gnu::always_inline]] inline uint64x2_t first_predecessors_neon(uint64x2_t x) {
+    return vextq_u64(vdupq_n_u64(0), x, 1);
+}
+
+template<typename Bits>
+constexpr index_type words_per_neon_vector = 16 / sizeof(Bits);
+
+template<index_type SideLength, typename Bits>
+[[gnu::always_inline]] inline void block_transform_horizontal_neon(Bits *line) {
+    constexpr auto words_per_vector = words_per_neon_vector<Bits>;
+
+    // Walking backwards, the (unaligned) predecessors of each vector have not been overwritten yet
+    for (index_type j = SideLength - words_per_vector; j > 0; j -= words_per_vector) {
+        store_neon(line + j, subtract_packed(load_neon(line + j), load_neon(line + j - 1)));
+    }
+    const auto first = load_neon(line);
+    store_neon(line, subtract_packed(first, first_predecessors_neon(first)));
+}
+
+// x[i * Stride + k] -= x[(i - 1) * Stride + k] for all i > 0 and k < SideLength
+template<index_type SideLength, index_type Stride, typename Bits>
+[[gnu::always_inline]] inline void block_transform_strided_neon(Bits *x) {
+    constexpr auto words_per_vector = words_per_neon_vector<Bits>;
+
+    for (index_type i = SideLength - 1; i > 0; --i) {
+        for (index_type k = 0; k < SideLength; k += words_per_vector) {
+            const auto pred = load_neon(x + (i - 1) * Stride + k);
+            store_neon(x + i * Stride + k, subtract_packed(load_neon(x + i * Stride + k), pred));
+        }
+    }
+}
+
+// x[i * Stride + k] += x[(i - 1) * Stride + k] for all i > 0 and k < SideLength
+template<index_type SideLength, index_type Stride, typename Bits>
+[[gnu::always_inline]] inline void inverse_block_transform_strided_neon(Bits *x) {
+    constexpr auto words_per_vector = words_per_neon_vector<Bits>;
+
+    for (index_type i = 1; i < SideLength; ++i) {
+        for (index_type k = 0; k < SideLength; k += words_per_vector) {
+            const auto pred = load_neon(x + (i - 1) * Stride + k);
+            store_neon(x + i * Stride + k, add_packed(load_neon(x + i * Stride + k), pred));
+        }
+    }
+}
+
+template<typename Profile>
+void block_transform_neon(typename Profile::bits_type *x) {
+    constexpr index_type dims = Profile::dimensions;
+    constexpr index_type side_length = Profile::hypercube_side_length;
+
+    x = assume_simd_aligned(x);
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = sign_to_lsb<Profile::sign_magnitude>(x[i]);
+    }
+
+    if constexpr (dims == 1) {
+        block_transform_horizontal_neon<side_length>(x);
+    } else if constexpr (dims == 2) {
+        for (size_t i = 0; i < side_length; ++i) {
+            block_transform_horizontal_neon<side_length>(x + i * side_length);
+        }
+        block_transform_strided_neon<side_length, side_length>(x);
+    } else if constexpr (dims == 3) {
+        for (size_t i = 0; i < ipow(side_length, 3); i += side_length) {
+            block_transform_horizontal_neon<side_length>(x + i);
+        }
+        for (size_t i = 0; i < ipow(side_length, 3); i += ipow(side_length, 2)) {
+            block_transform_strided_neon<side_length, side_length>(x + i);
+        }
+        for (size_t i = 0; i < ipow(side_length, 2); i += side_length) {
+            block_transform_strided_neon<side_length, ipow(side_length, 2)>(x + i);
+        }
+    }
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = complement_negative(x[i]);
+    }
+}
+
+template<typename Profile>
+void inverse_block_transform_neon(typename Profile::bits_type *x) {
+    constexpr index_type dims = Profile::dimensions;
+    constexpr index_type side_length = Profile::hypercube_side_length;
+
+    x = assume_simd_aligned(x);
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = complement_negative(x[i]);
+    }
+
+    if constexpr (dims == 1) {
+        inverse_block_transform_horizontal_sequential<side_length>(x);
+    } else if constexpr (dims == 2) {
+        inverse_block_transform_horizontal_interleaved<side_length>(x);
+        inverse_block_transform_strided_neon<side_length, side_length>(x);
+    } else if constexpr (dims == 3) {
+        for (size_t i = 0; i < ipow(side_length, 3); i += ipow(side_length, 2)) {
+            inverse_block_transform_horizontal_interleaved<side_length>(x + i);
+        }
+        for (size_t i = 0; i < ipow(side_length, 3); i += ipow(side_length, 2)) {
+            inverse_block_transform_strided_neon<side_length, side_length>(x + i);
+        }
+        for (size_t i = 0; i < ipow(side_length, 2); i += side_length) {
+            inverse_block_transform_strided_neon<side_length, ipow(side_length, 2)>(x + i);
+        }
+    }
+
+    for (size_t i = 0; i < ipow(side_length, Profile::dimensions); ++i) {
+        x[i] = sign_from_lsb<Profile::sign_magnitude>(x[i]);
+    }
+}
+
+#endif  // NDZIP_CPU_NEON
+
+// The SIMD transforms operate on 32- and 64-bit lanes and hypercube rows of whole vectors. 8- and 16-bit elements and
+// the rows of smaller hypercubes use the portable transform, which the compiler vectorizes well enough given how few
+// bits there are to move.
+template<typename Profile>
+constexpr inline bool has_simd_block_transform = bits_of<typename Profile::bits_type> >= 32
+        && Profile::hypercube_side_length * sizeof(typename Profile::bits_type) % simd_width_bytes == 0;
+
+template<typename Profile>
+[[gnu::noinline]] void block_transform(typename Profile::bits_type *x) {
+    if constexpr (!has_simd_block_transform<Profile>) {
+        ndzip::detail::block_transform(
+                x, Profile::dimensions, Profile::hypercube_side_length, Profile::sign_magnitude);
+    } else {
+#if NDZIP_CPU_AVX512
+        block_transform_avx512<Profile>(x);
+#elif NDZIP_CPU_AVX2
+        block_transform_avx2<Profile>(x);
+#elif NDZIP_CPU_NEON
+        block_transform_neon<Profile>(x);
+#else
+        ndzip::detail::block_transform(
+                x, Profile::dimensions, Profile::hypercube_side_length, Profile::sign_magnitude);
+#endif
+    }
+}
+
+template<typename Profile>
+[[gnu::noinline]] void inverse_block_transform(typename Profile::bits_type *x) {
+    if constexpr (!has_simd_block_transform<Profile>) {
+        ndzip::detail::inverse_block_transform(
+                x, Profile::dimensions, Profile::hypercube_side_length, Profile::sign_magnitude);
+    } else {
+#if NDZIP_CPU_AVX512
+        inverse_block_transform_avx512<Profile>(x);
+#elif NDZIP_CPU_AVX2
+        inverse_block_transform_avx2<Profile>(x);
+#elif NDZIP_CPU_NEON
+        inverse_block_transform_neon<Profile>(x);
+#else
+        ndzip::detail::inverse_block_transform(
+                x, Profile::dimensions, Profile::hypercube_side_length, Profile::sign_magnitude);
+#endif
+    }
+}
+
+
+template<typename T>
+T generate_zero_map(const T *u) {
+    // Groups of 8- and 16-bit words span at most 32 bytes and are not necessarily aligned to the SIMD width
+    if constexpr (bits_of<T> >= 32) {
+        u = assume_simd_aligned(u);
+#if NDZIP_CPU_AVX512
+        constexpr auto n_512bit_lanes = sizeof(T) * bits_of<T> / sizeof(__m512i);
+        __m512i acc = load_aligned_512(u);
+        for (index_type j = 1; j < n_512bit_lanes; ++j) {
+            acc = _mm512_or_si512(acc, load_aligned_512(u + j * (sizeof(__m512i) / sizeof(T))));
+        }
+        NDZIP_CPU_IGNORE_UNINITIALIZED_BEGIN
+        if constexpr (bits_of<T> == 32) {
+            return static_cast<T>(_mm512_reduce_or_epi32(acc));
+        } else {
+            return static_cast<T>(_mm512_reduce_or_epi64(acc));
+        }
+        NDZIP_CPU_IGNORE_UNINITIALIZED_END
+#elif NDZIP_CPU_NEON
+        auto acc = load_neon(u);
+        for (index_type j = words_per_neon_vector<T>; j < bits_of<T>; j += words_per_neon_vector<T>) {
+            acc = or_packed(acc, load_neon(u + j));
+        }
+        return or_reduce_neon(acc);
+#endif
+    }
+    T zero_map = 0;
+    for (index_type j = 0; j < bits_of<T>; ++j) {
+        zero_map |= u[j];
+    }
+    return zero_map;
+}
+
+
+template<typename T>
+[[gnu::always_inline]] void transpose_bits_trivial(const T *__restrict vs, T *__restrict out) {
+    for (index_type i = 0; i < bits_of<T>; ++i) {
+        out[i] = 0;
+        for (index_type j = 0; j < bits_of<T>; ++j) {
+            out[i] |= ((vs[j] >> (bits_of<T> - 1 - i)) & 1u) << (bits_of<T> - 1 - j);
+        }
+    }
+}
+
+// Recursive exchange of off-diagonal blocks (Hacker's Delight, section 7-3) in n log n word operations instead of the
+// n^2 bit operations of transpose_bits_trivial. Used for 8- and 16-bit words, which the SIMD variants below do not cover.
+template<typename T>
+[[gnu::always_inline]] void transpose_bits_blockwise(const T *__restrict vs, T *__restrict out) {
+    constexpr index_type n = bits_of<T>;
+    for (index_type i = 0; i < n; ++i) {
+        out[i] = vs[i];
+    }
+    auto mask = static_cast<T>(static_cast<T>(~T{}) >> (n / 2));
+    for (index_type j = n / 2; j != 0; j >>= 1u, mask ^= static_cast<T>(mask << j)) {
+        for (index_type k = 0; k < n; k = (k + j + 1) & ~j) {
+            const auto t = static_cast<T>((out[k] ^ (out[k + j] >> j)) & mask);
+            out[k] ^= t;
+            out[k + j] ^= static_cast<T>(t << j);
+        }
+    }
+}
+
+#if NDZIP_CPU_AVX2
+
+// The 16 words of a 16-bit group fill exactly one 256-bit vector. After moving the high bytes of all words, in reverse
+// order, into the lower and the low bytes into the upper 128-bit lane, each movemask yields two of the transposed
+// words, and adding every byte to itself shifts in the next bit column.
+[[gnu::always_inline]] inline void transpose_bits_avx2(const uint16_t *__restrict vs, uint16_t *__restrict out) {
+    // clang-format off
+    const auto split_bytes = _mm256_setr_epi8(
+            15, 13, 11, 9, 7, 5, 3, 1, 14, 12, 10, 8, 6, 4, 2, 0,
+            15, 13, 11, 9, 7, 5, 3, 1, 14, 12, 10, 8, 6, 4, 2, 0);
+    // clang-format on
+    auto bytes = _mm256_shuffle_epi8(load_unaligned_256(vs), split_bytes);
+    // quadwords: high bytes of words 15..8, 7..0, low bytes of words 15..8, 7..0
+    bytes = _mm256_permute4x64_epi64(bytes, 0b01'11'00'10);
+    for (index_type i = 0; i < 8; ++i) {
+        const auto columns = static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+        out[i] = static_cast<uint16_t>(columns);
+        out[i + 8] = static_cast<uint16_t>(columns >> 16u);
+        bytes = _mm256_add_epi8(bytes, bytes);
+    }
+}
+
+[[gnu::always_inline]] inline void transpose_bits_avx2(const uint32_t *__restrict vs, uint32_t *__restrict out) {
+    __m256i unpck0[4];
+    __builtin_memcpy(unpck0, assume_simd_aligned(vs), sizeof unpck0);
+
+    // 1. In order to generate 32 transpositions using only 32 *movemask* instructions,
+    // first shuffle bytes so that the i-th 256-bit vector contains the i-th byte of
+    // each float
+
+    __m256i shuf[4];
+    {
+        // interpret each 128-bit lane as a 4x4 matrix and transpose it
+        // also correct endianess for later
+        // clang-format off
+        uint8_t idx8[] = {
+                12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3,
+                12, 8, 4, 0, 13, 9, 5, 1, 14, 10, 6, 2, 15, 11, 7, 3,
+        };
+        // clang-format on
+        __m256i idx;
+        __builtin_memcpy(&idx, idx8, sizeof idx);
+        for (index_type i = 0; i < 4; ++i) {
+            shuf[i] = _mm256_shuffle_epi8(unpck0[i], idx);
+        }
+    }
+
+    __m256i perm[4];
+    {
+        // interleave doublewords within each 256-bit vector
+        // quadword i will contain elements {i, i+4, i+8, ... i+28}
+        uint32_t idx32[] = {7, 3, 6, 2, 5, 1, 4, 0};
+        __m256i idx;
+        __builtin_memcpy(&idx, idx32, sizeof idx);
+        for (index_type i = 0; i < 4; ++i) {
+            perm[i] = _mm256_permutevar8x32_epi32(shuf[i], idx);
+        }
+    }
+
+    __m256i unpck1[4];
+    for (index_type i = 0; i < 4; i += 2) {
+        // interleave quadwords of neighboring 256-bit vectors
+        // each double-quadword will contain elements with stride 4
+        unpck1[i + 1] = _mm256_unpackhi_epi64(perm[i + 1], perm[i + 0]);
+        unpck1[i + 0] = _mm256_unpacklo_epi64(perm[i + 1], perm[i + 0]);
+    }
+
+    // is _mm256_inserti128_si256 faster here?
+    __m256i perm2[4] = {
+            // combine matching 128-bit lanes
+            _mm256_permute2x128_si256(unpck1[2], unpck1[0], 0x20),
+            _mm256_permute2x128_si256(unpck1[3], unpck1[1], 0x20),
+            _mm256_permute2x128_si256(unpck1[2], unpck1[0], 0x31),
+            _mm256_permute2x128_si256(unpck1[3], unpck1[1], 0x31),
+    };
+
+    // 2. Transpose by extracting the 32 MSBs of each byte of each 256-byte vector
+
+    for (index_type i = 0; i < 4; ++i) {
+        for (index_type j = 0; j < 8; ++j) {
+            out[i * 8 + j] = _mm256_movemask_epi8(perm2[i]);
+            perm2[i] = _mm256_slli_epi32(perm2[i], 1);
+        }
+    }
+}
+
+[[gnu::always_inline]] inline void transpose_bits_avx2(const uint64_t *__restrict vs, uint64_t *__restrict out) {
+    __m256i in[16];
+    __builtin_memcpy(in, __builtin_assume_aligned(vs, 32), sizeof in);
+
+    // TODO Clang does a lot of spilling and reloading here because it's running out of YMM
+    // registers. GCC less so. Can this be improved, e.g. by merging operations that can operate on
+    // a subset of the 16 vectors?
+
+    __m256i unpck0[16];
     for (index_type i = 0; i < 16; i += 2) {
         unpck0[i + 1] = _mm256_unpackhi_epi8(in[i + 0], in[i + 1]);
         unpck0[i + 0] = _mm256_unpacklo_epi8(in[i + 0], in[i + 1]);
@@ -517,15 +1302,242 @@ template<typename T>
     }
 }
 
-#endif  // __AVX2__
+#endif  // NDZIP_CPU_AVX2
+
+#if NDZIP_CPU_AVX512_GFNI
+
+NDZIP_CPU_IGNORE_UNINITIALIZED_BEGIN
+
+// The AVX-512 bit transposition splits the N x N bit matrix into 8 x 8 bit blocks. Each block is gathered into one
+// qword, transposed in place by GF2P8AFFINEQB, and scattered to its mirrored position in the output. Rows are
+// numbered from the first word and columns from the most significant bit, matching transpose_bits_trivial.
+using byte_permutation_512 = std::array<uint8_t, sizeof(__m512i)>;
+
+// Multiplying by this matrix transposes the 8x8 bit matrix held in the other operand's qword, with
+// byte r, bit i of the result taken from byte 7 - i, bit r of the input.
+inline constexpr uint64_t gf2p8_transpose_matrix = 0x80'40'20'10'08'04'02'01;
+
+// 32 x 32: a register holds 16 rows, i.e. two block-rows J of four blocks (one per byte b of the word). Qword
+// 4J + b collects byte b of rows 8J .. 8J+7.
+constexpr byte_permutation_512 transpose_bits_avx512_gather_32() {
+    byte_permutation_512 perm{};
+    for (unsigned j = 0; j < 2; ++j) {
+        for (unsigned b = 0; b < 4; ++b) {
+            for (unsigned p = 0; p < 8; ++p) {
+                perm[8 * (4 * j + b) + p] = static_cast<uint8_t>(32 * j + 4 * p + b);
+            }
+        }
+    }
+    return perm;
+}
+
+// After the block transpose, byte r of qword 4J + b belongs to byte 3 - J of output word 31 - 8b - r. Indices
+// select from the 128 bytes of both transposed registers.
+constexpr byte_permutation_512 transpose_bits_avx512_scatter_32(unsigned half) {
+    byte_permutation_512 perm{};
+    for (unsigned o = 0; o < 64; ++o) {
+        const unsigned word = 16 * half + o / 4;
+        const unsigned j = 3 - o % 4;
+        const unsigned b = (31 - word) / 8;
+        const unsigned r = (31 - word) % 8;
+        perm[o] = static_cast<uint8_t>(8 * (4 * j + b) + r);
+    }
+    return perm;
+}
+
+// 64 x 64: register J holds the eight rows of block-row J, and qword 7 - b collects byte b of those rows.
+constexpr byte_permutation_512 transpose_bits_avx512_gather_64() {
+    byte_permutation_512 perm{};
+    for (unsigned b = 0; b < 8; ++b) {
+        for (unsigned p = 0; p < 8; ++p) {
+            perm[8 * (7 - b) + p] = static_cast<uint8_t>(8 * p + b);
+        }
+    }
+    return perm;
+}
+
+// After the block transpose and the qword transpose across registers, register K holds block (J, 7 - K) in qword
+// J. Byte r of that block belongs to byte 7 - J of output word 8K + 7 - r.
+constexpr byte_permutation_512 transpose_bits_avx512_scatter_64() {
+    byte_permutation_512 perm{};
+    for (unsigned w = 0; w < 8; ++w) {
+        for (unsigned b = 0; b < 8; ++b) {
+            perm[8 * w + b] = static_cast<uint8_t>(8 * (7 - b) + (7 - w));
+        }
+    }
+    return perm;
+}
+
+[[gnu::always_inline]] inline void transpose_bits_avx512(const uint32_t *__restrict vs, uint32_t *__restrict out) {
+    constexpr static byte_permutation_512 gather = transpose_bits_avx512_gather_32();
+    constexpr static byte_permutation_512 scatter[2]
+            = {transpose_bits_avx512_scatter_32(0), transpose_bits_avx512_scatter_32(1)};
+
+    const auto gather_idx = _mm512_loadu_si512(gather.data());
+    const auto matrix = _mm512_set1_epi64(static_cast<int64_t>(gf2p8_transpose_matrix));
+
+    __m512i blocks[2];
+    for (unsigned i = 0; i < 2; ++i) {
+        blocks[i] = _mm512_permutexvar_epi8(gather_idx, _mm512_loadu_si512(vs + 16 * i));
+        blocks[i] = _mm512_gf2p8affine_epi64_epi8(matrix, blocks[i], 0);
+    }
+    for (unsigned i = 0; i < 2; ++i) {
+        _mm512_storeu_si512(out + 16 * i,
+                _mm512_permutex2var_epi8(blocks[0], _mm512_loadu_si512(scatter[i].data()), blocks[1]));
+    }
+}
+
+[[gnu::always_inline]] inline void transpose_bits_avx512(const uint64_t *__restrict vs, uint64_t *__restrict out) {
+    constexpr static byte_permutation_512 gather = transpose_bits_avx512_gather_64();
+    constexpr static byte_permutation_512 scatter = transpose_bits_avx512_scatter_64();
+
+    const auto gather_idx = _mm512_loadu_si512(gather.data());
+    const auto matrix = _mm512_set1_epi64(static_cast<int64_t>(gf2p8_transpose_matrix));
+
+    __m512i blocks[8];
+    for (unsigned i = 0; i < 8; ++i) {
+        blocks[i] = _mm512_permutexvar_epi8(gather_idx, _mm512_loadu_si512(vs + 8 * i));
+        blocks[i] = _mm512_gf2p8affine_epi64_epi8(matrix, blocks[i], 0);
+    }
+
+    // 8x8 qword transpose across registers: 2x2 within 128-bit lanes, then twice across lanes
+    __m512i unpck[8];
+    for (unsigned i = 0; i < 8; i += 2) {
+        unpck[i + 0] = _mm512_unpacklo_epi64(blocks[i], blocks[i + 1]);
+        unpck[i + 1] = _mm512_unpackhi_epi64(blocks[i], blocks[i + 1]);
+    }
+    __m512i shuf[8];
+    for (unsigned i = 0; i < 8; i += 4) {
+        shuf[i + 0] = _mm512_shuffle_i64x2(unpck[i + 0], unpck[i + 2], 0x88);
+        shuf[i + 1] = _mm512_shuffle_i64x2(unpck[i + 1], unpck[i + 3], 0x88);
+        shuf[i + 2] = _mm512_shuffle_i64x2(unpck[i + 0], unpck[i + 2], 0xdd);
+        shuf[i + 3] = _mm512_shuffle_i64x2(unpck[i + 1], unpck[i + 3], 0xdd);
+    }
+    __m512i rows[8];
+    for (unsigned i = 0; i < 4; ++i) {
+        rows[i + 0] = _mm512_shuffle_i64x2(shuf[i], shuf[i + 4], 0x88);
+        rows[i + 4] = _mm512_shuffle_i64x2(shuf[i], shuf[i + 4], 0xdd);
+    }
+
+    const auto scatter_idx = _mm512_loadu_si512(scatter.data());
+    for (unsigned i = 0; i < 8; ++i) {
+        _mm512_storeu_si512(out + 8 * i, _mm512_permutexvar_epi8(scatter_idx, rows[i]));
+    }
+}
+
+NDZIP_CPU_IGNORE_UNINITIALIZED_END
+
+#endif  // NDZIP_CPU_AVX512_GFNI
+
+#if NDZIP_CPU_NEON
+
+[[gnu::always_inline]] inline uint32x4_t broadcast_neon(uint32_t x) {
+    return vdupq_n_u32(x);
+}
+
+[[gnu::always_inline]] inline uint64x2_t broadcast_neon(uint64_t x) {
+    return vdupq_n_u64(x);
+}
+
+// Exchanges the bits selected by mask in a with the bits shift positions to their right in b
+[[gnu::always_inline]] inline void swap_bit_blocks_neon(uint32x4_t &a, uint32x4_t &b, int shift, uint32x4_t mask) {
+    const auto t = vandq_u32(veorq_u32(a, vshlq_u32(b, vdupq_n_s32(-shift))), mask);
+    a = veorq_u32(a, t);
+    b = veorq_u32(b, vshlq_u32(t, vdupq_n_s32(shift)));
+}
+
+[[gnu::always_inline]] inline void swap_bit_blocks_neon(uint64x2_t &a, uint64x2_t &b, int shift, uint64x2_t mask) {
+    const auto t = vandq_u64(veorq_u64(a, vshlq_u64(b, vdupq_n_s64(-shift))), mask);
+    a = veorq_u64(a, t);
+    b = veorq_u64(b, vshlq_u64(t, vdupq_n_s64(shift)));
+}
+
+// Regroups two vectors of consecutive rows so that rows `distance` apart end up in the same lane of v0 and v1. The
+// permutation is its own inverse.
+[[gnu::always_inline]] inline void pair_rows_neon(uint32x4_t &v0, uint32x4_t &v1, index_type distance) {
+    uint32x4_t a, b;
+    if (distance == 2) {
+        a = vreinterpretq_u32_u64(vtrn1q_u64(vreinterpretq_u64_u32(v0), vreinterpretq_u64_u32(v1)));
+        b = vreinterpretq_u32_u64(vtrn2q_u64(vreinterpretq_u64_u32(v0), vreinterpretq_u64_u32(v1)));
+    } else {
+        a = vtrn1q_u32(v0, v1);
+        b = vtrn2q_u32(v0, v1);
+    }
+    v0 = a;
+    v1 = b;
+}
+
+[[gnu::always_inline]] inline void pair_rows_neon(uint64x2_t &v0, uint64x2_t &v1, index_type /* distance == 1 */) {
+    const auto a = vtrn1q_u64(v0, v1);
+    const auto b = vtrn2q_u64(v0, v1);
+    v0 = a;
+    v1 = b;
+}
+
+// Recursive block-swap transposition (Hacker's Delight, section 7-3) in log2(bits) stages. Stage j exchanges
+// j x j sub-blocks between rows k and k + j.
+template<typename Bits>
+[[gnu::always_inline]] inline void transpose_bits_neon(const Bits *__restrict vs, Bits *__restrict out) {
+    constexpr index_type n = bits_of<Bits>;
+    constexpr auto words_per_vector = words_per_neon_vector<Bits>;
+
+    const Bits *in = vs;
+    index_type j = n / 2;
+    auto mask = static_cast<Bits>(~Bits{0} >> (n / 2));
+
+    // Rows k and k + j lie in different vectors
+    for (; j >= words_per_vector; j /= 2, mask ^= static_cast<Bits>(mask << j)) {
+        const auto m = broadcast_neon(mask);
+        for (index_type k = 0; k < n; k += 2 * j) {
+            for (index_type i = k; i < k + j; i += words_per_vector) {
+                auto a = load_neon(in + i);
+                auto b = load_neon(in + i + j);
+                swap_bit_blocks_neon(a, b, static_cast<int>(j), m);
+                store_neon(out + i, a);
+                store_neon(out + i + j, b);
+            }
+        }
+        in = out;
+    }
+
+    // Rows k and k + j lie in the same vector
+    for (; j > 0; j /= 2, mask ^= static_cast<Bits>(mask << j)) {
+        const auto m = broadcast_neon(mask);
+        for (index_type i = 0; i < n; i += 2 * words_per_vector) {
+            auto a = load_neon(out + i);
+            auto b = load_neon(out + i + words_per_vector);
+            pair_rows_neon(a, b, j);
+            swap_bit_blocks_neon(a, b, static_cast<int>(j), m);
+            pair_rows_neon(a, b, j);
+            store_neon(out + i, a);
+            store_neon(out + i + words_per_vector, b);
+        }
+    }
+}
+
+#endif  // NDZIP_CPU_NEON
 
 template<typename T>
 [[gnu::noinline]] void transpose_bits(const T *__restrict in, T *__restrict out) {
-#ifdef __AVX2__
-    return transpose_bits_avx2(in, out);
+    if constexpr (bits_of<T> == 8) {
+        return transpose_bits_blockwise(in, out);
+    } else if constexpr (bits_of<T> == 16) {
+#if NDZIP_CPU_AVX2
+        return transpose_bits_avx2(in, out);
+#else
+        return transpose_bits_blockwise(in, out);
+#endif
+    } else {
+#if NDZIP_CPU_AVX512_GFNI
+        return transpose_bits_avx512(in, out);
+#elif NDZIP_CPU_AVX2
+        return transpose_bits_avx2(in, out);
+#elif NDZIP_CPU_NEON
+        return transpose_bits_neon(in, out);
 #else
-    return transpose_bits_trivial(in, out);
+        return transpose_bits_trivial(in, out);
 #endif
+    }
 }
 
 template<typename T>
@@ -551,26 +1563,41 @@ template<typename T>
             shifted[i] = 0;
         }
     }
-    return in - in0;
-}
+    return in - in0;
+}
+
+
+// Returns the length of the encoding in bytes. If it would not be shorter than limit_bytes, only the head words are
+// written and 0 is returned, so that at most limit_bytes are ever written to stream.
+template<typename Bits>
+[[gnu::noinline]] size_t
+zero_bit_encode(const Bits *cube, std::byte *stream, size_t hc_size, size_t limit_bytes = SIZE_MAX) {
+    using popcount_type = std::conditional_t<(sizeof(Bits) < sizeof(unsigned)), unsigned, Bits>;
+
+    // The length of every group is known from its head, so the heads are generated first
+    size_t head_pos = 0;
+    size_t length = hc_size / detail::bits_of<Bits> * sizeof(Bits);
+    for (size_t offset = 0; offset < hc_size; offset += detail::bits_of<Bits>) {
+        const auto zero_map = generate_zero_map(cube + offset);
+        store_aligned(stream + head_pos, zero_map);
+        head_pos += sizeof(Bits);
+        length += detail::popcount(static_cast<popcount_type>(zero_map)) * sizeof(Bits);
+    }
+    if (length >= limit_bytes) { return 0; }
 
-
-template<typename Bits>
-[[gnu::noinline]] size_t zero_bit_encode(const Bits *cube, std::byte *stream, size_t hc_size) {
-    size_t head_pos = 0;
+    head_pos = 0;
     size_t body_pos = hc_size / detail::bits_of<Bits> * sizeof(Bits);
     for (size_t offset = 0; offset < hc_size; offset += detail::bits_of<Bits>) {
-        auto in = cube + offset;
-        auto zero_map = generate_zero_map(in);
-        store_aligned(stream + head_pos, zero_map);
+        const auto zero_map = load_aligned<Bits>(stream + head_pos);
         head_pos += sizeof(Bits);
         // all-zero is relatively common, transpose+compact is expensive
         if (zero_map != 0) {
             alignas(simd_width_bytes) Bits transposed[detail::bits_of<Bits>];
-            detail::cpu::transpose_bits(in, transposed);
+            detail::cpu::transpose_bits(cube + offset, transposed);
             body_pos += detail::cpu::compact_zero_words(transposed, stream + body_pos);
         }
     }
+    assert(body_pos == length);
 
     return body_pos;
 }
@@ -594,6 +1621,306 @@ template<typename Bits>
     return body_pos;
 }
 
+// The one-dimensional codec for the border of a multi-dimensional array (see detail::border_extent) is of the same
+// kind as the one for its hypercubes, so that the border is compressed in parallel if the hypercubes are.
+template<typename Base, template<typename> typename Codec, typename Profile, typename... Args>
+std::unique_ptr<Base> make_border_codec(Args... args) {
+    if constexpr (!detail::has_border_stream<Profile::dimensions>) {
+        return nullptr;
+    } else {
+        return std::make_unique<Codec<profile<typename Profile::value_type, 1>>>(args...);
+    }
+}
+
+// Stages of the CPU codecs, in the order they are applied to each hypercube during compression. Decompression runs
+// them in reverse (zero_bit_decode, inverse_block_transform, store_hypercube) and has no output_assembly stage.
+enum class codec_stage { hypercube_memory, block_transform, zero_bit_coding, output_assembly, border };
+inline constexpr size_t num_codec_stages = 5;
+
+// Accumulates the time one thread of a CPU codec spends in each stage. Timing is opt-in: a disabled timer never reads
+// the clock. lap() attributes the time since the previous lap (or since construction) to a stage, so instrumenting the
+// hypercube loop costs one clock read per stage and hypercube.
+class stage_timer {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit stage_timer(bool enabled = false) : _enabled(enabled) {
+        if (_enabled) { _last = clock::now(); }
+    }
+
+    bool enabled() const { return _enabled; }
+
+    void lap(codec_stage stage) {
+        if (_enabled) {
+            const auto now = clock::now();
+            _durations[static_cast<size_t>(stage)] += std::chrono::duration_cast<kernel_duration>(now - _last);
+            _last = now;
+        }
+    }
+
+    kernel_duration operator[](codec_stage stage) const { return _durations[static_cast<size_t>(stage)]; }
+
+    stage_timer &operator+=(const stage_timer &other) {
+        for (size_t s = 0; s < num_codec_stages; ++s) {
+            _durations[s] += other._durations[s];
+        }
+        return *this;
+    }
+
+    kernel_duration total() const {
+        return std::accumulate(_durations.begin(), _durations.end(), kernel_duration{});
+    }
+
+  private:
+    bool _enabled;
+    clock::time_point _last{};
+    std::array<kernel_duration, num_codec_stages> _durations{};
+};
+
+// One line per thread, in the format of the imbalance report of openmp_decompressor
+inline void print_stage_durations(const char *codec, bool compression, const std::vector<stage_timer> &timers) {
+    constexpr const char *compression_stages[]
+            = {"load_hypercube", "block_transform", "zero_bit_encode", "output_assembly", "pack_border"};
+    constexpr const char *decompression_stages[]
+            = {"store_hypercube", "inverse_block_transform", "zero_bit_decode", nullptr, "unpack_border"};
+    const auto &stage_names = compression ? compression_stages : decompression_stages;
+    for (size_t tid = 0; tid < timers.size(); ++tid) {
+        printf("%s: thread %zu:", codec, tid);
+        for (size_t s = 0; s < num_codec_stages; ++s) {
+            if (!stage_names[s]) { continue; }
+            printf(" %s %.3f ms%s", stage_names[s],
+                    std::chrono::duration<double, std::milli>(timers[tid][static_cast<codec_stage>(s)]).count(),
+                    s + 1 < num_codec_stages ? "," : "\n");
+        }
+    }
+}
+
+template<typename Profile>
+bool is_constant_hypercube(const typename Profile::bits_type *cube) {
+    constexpr auto hc_size = detail::ipow(Profile::hypercube_side_length, Profile::dimensions);
+    return std::all_of(cube + 1, cube + hc_size, [first = cube[0]](auto word) { return word == first; });
+}
+
+// Summarizes a loaded hypercube while it is still in L1, see compressor::compress_summarized
+template<typename Profile>
+void summarize_hypercube(const typename Profile::bits_type *cube,
+        hypercube_summary<typename Profile::value_type> *summaries, index_type hc_index) {
+    if (summaries) {
+        constexpr auto hc_size = detail::ipow(Profile::hypercube_side_length, Profile::dimensions);
+        summary_accumulator<typename Profile::value_type> acc;
+        acc.add(cube, hc_size);
+        summaries[hc_index] = acc.summary();
+    }
+}
+
+// Encodes a loaded hypercube into stream and returns its length in words, see detail::hypercube_encoding. The cube is
+// block-transformed in place, unless it is constant. At most compressed_block_length_bound words are written to stream.
+template<typename Profile>
+size_t encode_hypercube(typename Profile::bits_type *cube, typename Profile::bits_type *stream, stage_timer &timer) {
+    using bits_type = typename Profile::bits_type;
+    constexpr auto hc_size = detail::ipow(Profile::hypercube_side_length, Profile::dimensions);
+
+    if constexpr (stream_format_version < 3) {
+        detail::cpu::block_transform<Profile>(cube);
+        timer.lap(codec_stage::block_transform);
+        const auto length_bytes
+                = detail::cpu::zero_bit_encode<bits_type>(cube, reinterpret_cast<std::byte *>(stream), hc_size);
+        timer.lap(codec_stage::zero_bit_coding);
+        return length_bytes / sizeof(bits_type);
+    }
+
+    if (is_constant_hypercube<Profile>(cube)) {
+        stream[0] = cube[0];
+        timer.lap(codec_stage::zero_bit_coding);
+        return 1;
+    }
+
+    detail::cpu::block_transform<Profile>(cube);
+    timer.lap(codec_stage::block_transform);
+    const auto length_bytes = detail::cpu::zero_bit_encode<bits_type>(
+            cube, reinterpret_cast<std::byte *>(stream), hc_size, hc_size * sizeof(bits_type));
+    if (length_bytes != 0) {
+        timer.lap(codec_stage::zero_bit_coding);
+        return length_bytes / sizeof(bits_type);
+    }
+
+    // Incompressible, which is rare enough for undoing the transform to be cheaper than keeping a copy of the cube
+    detail::cpu::inverse_block_transform<Profile>(cube);
+    memcpy(stream, cube, hc_size * sizeof(bits_type));
+    timer.lap(codec_stage::zero_bit_coding);
+    return hc_size;
+}
+
+// Decodes a hypercube of the given length in words, see encode_hypercube. Constant and raw hypercubes skip both the
+// zero-word expansion and the inverse block transform.
+template<typename Profile>
+void decode_hypercube(const typename Profile::bits_type *stream, size_t length, typename Profile::bits_type *cube,
+        stage_timer &timer) {
+    using bits_type = typename Profile::bits_type;
+    constexpr auto hc_size = detail::ipow(Profile::hypercube_side_length, Profile::dimensions);
+
+    switch (detail::hypercube_encoding_for_length<Profile>(length)) {
+        case detail::hypercube_encoding::constant: std::fill_n(cube, hc_size, stream[0]); break;
+        case detail::hypercube_encoding::raw: memcpy(cube, stream, hc_size * sizeof(bits_type)); break;
+        case detail::hypercube_encoding::zero_bits:
+            detail::cpu::zero_bit_decode<bits_type>(reinterpret_cast<const std::byte *>(stream), cube, hc_size);
+            timer.lap(codec_stage::zero_bit_coding);
+            detail::cpu::inverse_block_transform<Profile>(cube);
+            timer.lap(codec_stage::block_transform);
+            return;
+    }
+    timer.lap(codec_stage::zero_bit_coding);
+}
+
+// Gathers and scatters the border elements of a multi-dimensional array on the calling thread
+struct serial_border_copy {
+    template<typename DataType, dim_type Dims>
+    void pack(compressed_type<DataType> *dest, const DataType *src, const static_extent<Dims> &src_size,
+            index_type side_length) {
+        detail::pack_border(dest, src, src_size, side_length);
+    }
+
+    template<typename DataType, dim_type Dims>
+    void unpack(DataType *dest, const static_extent<Dims> &dest_size, const compressed_type<DataType> *src,
+            index_type side_length) {
+        detail::unpack_border(dest, dest_size, src, side_length);
+    }
+};
+
+// The border compressor of a multi-dimensional array applies the same truncation to the border elements
+template<typename Profile, typename BorderCopy = serial_border_copy>
+size_t compress_border(const typename Profile::value_type *data, const static_extent<Profile::dimensions> &data_size,
+        typename Profile::bits_type *border, compressor<typename Profile::value_type> *border_compressor,
+        scratch_buffer<typename Profile::value_type> &border_elements,
+        const mantissa_truncation<typename Profile::value_type> &truncation, BorderCopy &&copy = {}) {
+    using bits_type = typename Profile::bits_type;
+    if constexpr (!detail::has_border_stream<Profile::dimensions>) {
+        copy.pack(border, data, data_size, Profile::hypercube_side_length);
+        const auto border_length = detail::border_element_count(data_size, Profile::hypercube_side_length);
+        // A verbatim border has its free bits simply cleared
+        if (!truncation.is_lossless()) {
+            for (size_t i = 0; i < border_length; ++i) {
+                border[i] = truncation(border[i]).bits;
+            }
+        }
+        return border_length;
+    } else {
+        const auto border_size = detail::border_extent(data_size, Profile::hypercube_side_length);
+        border_elements.reserve(border_size[0]);
+        copy.pack(reinterpret_cast<bits_type *>(border_elements.data()), data, data_size,
+                Profile::hypercube_side_length);
+        return border_compressor->compress(border_elements.data(), border_size, border);
+    }
+}
+
+// Returns the border elements in the order of pack_border
+template<typename Profile>
+const typename Profile::bits_type *decode_border(const typename Profile::bits_type *border,
+        const static_extent<Profile::dimensions> &data_size,
+        decompressor<typename Profile::value_type> *border_decompressor,
+        scratch_buffer<typename Profile::value_type> &border_elements) {
+    if constexpr (!detail::has_border_stream<Profile::dimensions>) {
+        return border;
+    } else {
+        const auto border_size = detail::border_extent(data_size, Profile::hypercube_side_length);
+        border_elements.reserve(border_size[0]);
+        border_decompressor->decompress(border, border_elements.data(), border_size);
+        return reinterpret_cast<const typename Profile::bits_type *>(border_elements.data());
+    }
+}
+
+template<typename Profile, typename BorderCopy = serial_border_copy>
+size_t decompress_border(const typename Profile::bits_type *border, typename Profile::value_type *data,
+        const static_extent<Profile::dimensions> &data_size,
+        decompressor<typename Profile::value_type> *border_decompressor,
+        scratch_buffer<typename Profile::value_type> &border_elements, BorderCopy &&copy = {}) {
+    if constexpr (!detail::has_border_stream<Profile::dimensions>) {
+        copy.unpack(data, data_size, border, Profile::hypercube_side_length);
+        return detail::border_element_count(data_size, Profile::hypercube_side_length);
+    } else {
+        const auto border_size = detail::border_extent(data_size, Profile::hypercube_side_length);
+        border_elements.reserve(border_size[0]);
+        const auto border_length = border_decompressor->decompress(border, border_elements.data(), border_size);
+        copy.unpack(data, data_size, reinterpret_cast<const typename Profile::bits_type *>(border_elements.data()),
+                Profile::hypercube_side_length);
+        return border_length;
+    }
+}
+
+// Rejects the hypercube indices passed to decompress_hypercubes that lie beyond the hypercubes of the array
+inline void check_hypercube_indices(const index_type *hc_indices, index_type num_indices, index_type num_hcs) {
+    for (index_type i = 0; i < num_indices; ++i) {
+        if (hc_indices[i] >= num_hcs) {
+            throw std::runtime_error{"hypercube index exceeds the hypercubes of the array"};
+        }
+    }
+}
+
+// The hypercubes and border elements of an array that overlap a box-shaped region of interest
+template<typename Profile>
+class region_query {
+  public:
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+
+    constexpr static auto dimensions = Profile::dimensions;
+    constexpr static auto side_length = Profile::hypercube_side_length;
+
+    region_query(const extent &data_size, const extent &region_offset, const extent &region_size) {
+        if (data_size.dimensions() != dimensions || region_offset.dimensions() != dimensions
+                || region_size.dimensions() != dimensions) {
+            throw std::runtime_error{"region dimensionality does not match decompressor dimensionality"};
+        }
+
+        _data_size = static_extent<dimensions>{data_size};
+        _region_offset = static_extent<dimensions>{region_offset};
+        _region_size = static_extent<dimensions>{region_size};
+        for (dim_type d = 0; d < dimensions; ++d) {
+            if (_region_offset[d] > _data_size[d] || _region_size[d] > _data_size[d] - _region_offset[d]) {
+                throw std::runtime_error{"region exceeds the bounds of the array"};
+            }
+            _hc_grid_size[d] = _data_size[d] / side_length;
+            _first_hc[d] = std::min(_region_offset[d] / side_length, _hc_grid_size[d]);
+            const auto end_hc
+                    = std::min(div_ceil(_region_offset[d] + _region_size[d], side_length), _hc_grid_size[d]);
+            _hc_count[d] = end_hc > _first_hc[d] ? end_hc - _first_hc[d] : 0;
+        }
+    }
+
+    const static_extent<dimensions> &data_size() const { return _data_size; }
+
+    index_type num_hypercubes() const { return num_elements(_hc_count); }
+
+    // hc_index and element offset of the i-th hypercube overlapping the region
+    std::pair<index_type, static_extent<dimensions>> hypercube(index_type i) const {
+        const auto grid_pos = _first_hc + extent_from_linear_id(i, _hc_count);
+        return {linear_index(_hc_grid_size, grid_pos), grid_pos * side_length};
+    }
+
+    void store_hypercube(
+            const static_extent<dimensions> &hc_offset, const bits_type *cube, value_type *region) const {
+        copy_box_intersection(region, _region_offset, _region_size, cube, hc_offset,
+                static_extent<dimensions>::broadcast(side_length));
+    }
+
+    // border holds the decoded border elements, see decode_border()
+    void unpack_border(const bits_type *border, value_type *region) const {
+        auto row_size = static_extent<dimensions>::broadcast(1);
+        for_each_border_row(_data_size, side_length, [&](size_t border_offset, auto row_pos, index_type count) {
+            row_size[dimensions - 1] = count;
+            copy_box_intersection(region, _region_offset, _region_size, border + border_offset, row_pos, row_size);
+        });
+    }
+
+  private:
+    static_extent<dimensions> _data_size;
+    static_extent<dimensions> _region_offset;
+    static_extent<dimensions> _region_size;
+    static_extent<dimensions> _hc_grid_size;
+    static_extent<dimensions> _first_hc;
+    static_extent<dimensions> _hc_count;
+};
+
 template<typename Profile>
 class serial_compressor : public compressor<typename Profile::value_type> {
   public:
@@ -605,33 +1932,60 @@ class serial_compressor : public compressor<typename Profile::value_type> {
     constexpr static auto side_length = Profile::hypercube_side_length;
     constexpr static auto hc_size = detail::ipow(side_length, dimensions);
 
-    detail::cpu::simd_aligned_buffer<bits_type> cube{hc_size};
+    const lossy_precision precision;
+    const mantissa_truncation<value_type> truncation{precision};
+    scratch_buffer<bits_type> cube;
+    std::unique_ptr<compressor<value_type>> border_compressor;
+    scratch_buffer<value_type> border_elements;
 
   public:
-    index_type compress(const value_type *data, const extent &data_size, bits_type *raw_stream) override;
+    // The buffer layout is mirrored by serial_codec_scratch_bytes()
+    explicit serial_compressor(const lossy_precision &precision = {}, scratch_arena *arena = nullptr,
+            const scratch_extent &max_extent = {})
+        : precision(precision)
+        , cube(arena, hc_size)
+        , border_compressor(make_border_codec<compressor<value_type>, serial_compressor, Profile>(
+                  precision, arena, border_scratch_extent(max_extent)))
+        , border_elements(arena, detail::has_border_stream<dimensions> ? max_extent.num_border_elements : 0) {
+        cube.reserve(hc_size);
+    }
+
+    size_t compress(const value_type *data, const extent &data_size, bits_type *raw_stream) override {
+        return compress_summarized(data, data_size, raw_stream, nullptr);
+    }
+
+    size_t compress_summarized(const value_type *data, const extent &data_size, bits_type *raw_stream,
+            hypercube_summary<value_type> *summaries) override;
 };
 
 template<typename Profile>
-index_type
-serial_compressor<Profile>::compress(const value_type *data, const extent &data_size, bits_type *raw_stream) {
+size_t serial_compressor<Profile>::compress_summarized(const value_type *data, const extent &data_size,
+        bits_type *raw_stream, hypercube_summary<value_type> *summaries) {
     if (data_size.dimensions() != dimensions) {
         throw std::runtime_error{"data dimensionality does not match compressor dimensionality"};
     }
 
     const auto static_size = detail::static_extent<dimensions>{data_size};
-    detail::stream<Profile> stream{num_hypercubes(static_size), raw_stream};
+    detail::stream<Profile> stream{num_hypercubes(static_size, side_length), raw_stream};
 
-    index_type offset = 0;
-    for_each_hypercube(static_size, [&](auto hc_offset, auto hc_index) {
+    stage_timer timer{verbose()};
+    const bool truncate = !truncation.is_lossless();
+    size_t offset = 0;
+    for_each_hypercube<dimensions, side_length>(static_size, [&](auto hc_offset, auto hc_index) {
         detail::cpu::load_hypercube<Profile>(hc_offset, data, static_size, cube.data());
-        detail::cpu::block_transform<Profile>(cube.data());
-        offset += detail::cpu::zero_bit_encode<bits_type>(
-                          cube.data(), reinterpret_cast<std::byte *>(stream.hypercube(hc_index)) /* TODO */, hc_size)
-                / sizeof(bits_type);
+        detail::cpu::prefetch_next_hypercube<Profile>(hc_index, stream.num_hypercubes, data, static_size);
+        if (truncate) { truncate_hypercube<Profile>(cube.data(), truncation); }
+        summarize_hypercube<Profile>(cube.data(), summaries, hc_index);
+        timer.lap(codec_stage::hypercube_memory);
+        offset += encode_hypercube<Profile>(cube.data(), stream.hypercube(hc_index), timer);
         stream.set_offset_after(hc_index, offset);
     });
 
-    const auto border_length = detail::pack_border(stream.border(), data, static_size, Profile::hypercube_side_length);
+    const auto border_length
+            = compress_border<Profile>(
+                    data, static_size, stream.border(), border_compressor.get(), border_elements, truncation);
+    timer.lap(codec_stage::border);
+    if (timer.enabled()) { print_stage_durations("serial_compressor", true, {timer}); }
     return (stream.border() - stream.buffer) + border_length;
 }
 
@@ -648,72 +2002,200 @@ class serial_decompressor : public decompressor<typename Profile::value_type> {
     constexpr static auto side_length = Profile::hypercube_side_length;
     constexpr static auto hc_size = detail::ipow(side_length, dimensions);
 
-    detail::cpu::simd_aligned_buffer<bits_type> cube{hc_size};
+    scratch_buffer<bits_type> cube;
+    std::unique_ptr<decompressor<value_type>> border_decompressor;
+    scratch_buffer<value_type> border_elements;
 
   public:
-    ndzip::index_type decompress(const bits_type *raw_stream, value_type *data, const extent &data_size) override;
+    // The buffer layout is mirrored by serial_codec_scratch_bytes()
+    explicit serial_decompressor(scratch_arena *arena = nullptr, const scratch_extent &max_extent = {})
+        : cube(arena, hc_size)
+        , border_decompressor(make_border_codec<decompressor<value_type>, serial_decompressor, Profile>(
+                  arena, border_scratch_extent(max_extent)))
+        , border_elements(arena, detail::has_border_stream<dimensions> ? max_extent.num_border_elements : 0) {
+        cube.reserve(hc_size);
+    }
+
+    size_t decompress(const bits_type *raw_stream, value_type *data, const extent &data_size) override;
+
+    void decompress_region(const bits_type *raw_stream, const extent &data_size, const extent &region_offset,
+            const extent &region_size, value_type *region) override;
+
+    void decompress_hypercubes(const bits_type *raw_stream, value_type *data, const extent &data_size,
+            const index_type *hc_indices, index_type num_indices) override;
 };
 
 template<typename Profile>
-index_type
+size_t
 serial_decompressor<Profile>::decompress(const bits_type *raw_stream, value_type *data, const extent &data_size) {
     if (data_size.dimensions() != dimensions) {
         throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
     }
 
     const auto static_size = detail::static_extent<dimensions>(data_size);
-    detail::stream<const Profile> stream{num_hypercubes(static_size), raw_stream};
+    detail::stream<const Profile> stream{num_hypercubes(static_size, side_length), raw_stream};
 
-    for_each_hypercube(static_size, [&](auto hc_offset, auto hc_index) {
-        detail::cpu::zero_bit_decode<bits_type>(
-                reinterpret_cast<const std::byte *>(stream.hypercube(hc_index)), cube.data(), hc_size);
-        detail::cpu::inverse_block_transform<Profile>(cube.data());
+    stage_timer timer{verbose()};
+    for_each_hypercube<dimensions, side_length>(static_size, [&](auto hc_offset, auto hc_index) {
+        decode_hypercube<Profile>(stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube.data(), timer);
         detail::cpu::store_hypercube<Profile>(hc_offset, cube.data(), data, static_size);
+        timer.lap(codec_stage::hypercube_memory);
     });
-    const auto border_length
-            = detail::unpack_border(data, static_size, stream.border(), Profile::hypercube_side_length);
+    const auto border_length = decompress_border<Profile>(
+            stream.border(), data, static_size, border_decompressor.get(), border_elements);
+    timer.lap(codec_stage::border);
+    if (timer.enabled()) { print_stage_durations("serial_decompressor", false, {timer}); }
     return (stream.border() - stream.buffer) + border_length;
 }
 
-extern template class serial_compressor<profile<float, 1>>;
-extern template class serial_compressor<profile<float, 2>>;
-extern template class serial_compressor<profile<float, 3>>;
-extern template class serial_compressor<profile<double, 1>>;
-extern template class serial_compressor<profile<double, 2>>;
-extern template class serial_compressor<profile<double, 3>>;
+template<typename Profile>
+void serial_decompressor<Profile>::decompress_region(const bits_type *raw_stream, const extent &data_size,
+        const extent &region_offset, const extent &region_size, value_type *region) {
+    const region_query<Profile> query{data_size, region_offset, region_size};
+    detail::stream<const Profile> stream{num_hypercubes(query.data_size(), side_length), raw_stream};
+
+    stage_timer timer;
+    for (index_type i = 0; i < query.num_hypercubes(); ++i) {
+        const auto [hc_index, hc_offset] = query.hypercube(i);
+        decode_hypercube<Profile>(stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube.data(), timer);
+        query.store_hypercube(hc_offset, cube.data(), region);
+    }
+    query.unpack_border(decode_border<Profile>(stream.border(), query.data_size(), border_decompressor.get(),
+                                border_elements),
+            region);
+}
+
+template<typename Profile>
+void serial_decompressor<Profile>::decompress_hypercubes(const bits_type *raw_stream, value_type *data,
+        const extent &data_size, const index_type *hc_indices, index_type num_indices) {
+    if (data_size.dimensions() != dimensions) {
+        throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
+    }
 
-extern template class serial_decompressor<profile<float, 1>>;
-extern template class serial_decompressor<profile<float, 2>>;
-extern template class serial_decompressor<profile<float, 3>>;
-extern template class serial_decompressor<profile<double, 1>>;
-extern template class serial_decompressor<profile<double, 2>>;
-extern template class serial_decompressor<profile<double, 3>>;
+    const auto static_size = detail::static_extent<dimensions>(data_size);
+    const auto num_hcs = num_hypercubes(static_size, side_length);
+    check_hypercube_indices(hc_indices, num_indices, num_hcs);
+    detail::stream<const Profile> stream{num_hcs, raw_stream};
+
+    stage_timer timer;
+    for (index_type i = 0; i < num_indices; ++i) {
+        const auto hc_index = hc_indices[i];
+        const auto hc_offset = detail::extent_from_linear_id(hc_index, static_size / side_length) * side_length;
+        decode_hypercube<Profile>(stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube.data(), timer);
+        detail::cpu::store_hypercube<Profile>(hc_offset, cube.data(), data, static_size);
+    }
+    decompress_border<Profile>(stream.border(), data, static_size, border_decompressor.get(), border_elements);
+}
 
-#ifdef SPLIT_CONFIGURATION_cpu_encoder
-template class serial_compressor<profile<DATA_TYPE, DIMENSIONS>>;
-template class serial_decompressor<profile<DATA_TYPE, DIMENSIONS>>;
+#define NDZIP_EXTERN_SERIAL_CODECS(T) \
+    extern template class serial_compressor<profile<T, 1>>; \
+    extern template class serial_compressor<profile<T, 2>>; \
+    extern template class serial_compressor<profile<T, 3>>; \
+    extern template class serial_decompressor<profile<T, 1>>; \
+    extern template class serial_decompressor<profile<T, 2>>; \
+    extern template class serial_decompressor<profile<T, 3>>;
+NDZIP_FOR_EACH_CPU_CODEC_TYPE(NDZIP_EXTERN_SERIAL_CODECS)
+#undef NDZIP_EXTERN_SERIAL_CODECS
+
+#ifdef NDZIP_CPU_SPLIT_PROFILE
+template class serial_compressor<NDZIP_CPU_SPLIT_PROFILE>;
+template class serial_decompressor<NDZIP_CPU_SPLIT_PROFILE>;
 #endif
 
 #if NDZIP_OPENMP_SUPPORT
 
-template<typename Profile>
-struct cube_buffer {
-    using value_type = typename Profile::value_type;
-    using bits_type = typename Profile::bits_type;
+// Runs body(tid, team_size) on a team of up to num_threads threads. With thread_placement::numa, the team is bound to
+// the OpenMP places (OMP_PLACES, e.g. "cores" or "sockets") with a spread policy, so that neighboring thread ids - and
+// with them the neighboring hypercube ranges they are assigned - run on the same NUMA node. Without OMP_PLACES, the
+// runtime has no places to bind to and threads stay unpinned.
+template<typename F>
+void parallel_region(unsigned num_threads, thread_placement placement, F &&body) {
+    if (placement == thread_placement::numa) {
+#pragma omp parallel num_threads(num_threads) proc_bind(spread)
+        body(static_cast<unsigned>(omp_get_thread_num()), static_cast<unsigned>(omp_get_num_threads()));
+    } else {
+#pragma omp parallel num_threads(num_threads)
+        body(static_cast<unsigned>(omp_get_thread_num()), static_cast<unsigned>(omp_get_num_threads()));
+    }
+}
 
-    constexpr static auto dimensions = Profile::dimensions;
-    constexpr static auto side_length = Profile::hypercube_side_length;
-    constexpr static auto hc_size = detail::ipow(side_length, dimensions);
-    // constexpr static index_type num_hcs_per_chunk = 64 / sizeof(value_type);
-    // constexpr static index_type num_write_buffers = 30;
+// Per-thread scratch memory is carved from the arena up front if there is one. Otherwise, it is allocated lazily by the
+// thread that uses it, so that the first touch places its pages on that thread's NUMA node.
+template<typename T>
+std::vector<scratch_buffer<T>> per_thread_scratch(unsigned num_threads, scratch_arena *arena, size_t count) {
+    std::vector<scratch_buffer<T>> scratch(num_threads);
+    if (arena) {
+        for (auto &buffer : scratch) {
+            buffer = scratch_buffer<T>{arena, count};
+        }
+    }
+    return scratch;
+}
+
+template<typename T>
+T *thread_local_scratch(std::vector<scratch_buffer<T>> &scratch, unsigned tid, size_t count) {
+    scratch[tid].reserve(count);
+    return scratch[tid].data();
+}
 
-    alignas(detail::cpu::simd_width_bytes) std::array<bits_type, hc_size> cube;
+// Gathers and scatters the border elements of a multi-dimensional array on a team of threads, each copying an equal
+// share of border elements. Shapes that are not a multiple of the hypercube side length in their fastest dimensions
+// have a border made up of many short runs, which would otherwise be copied serially after the hypercubes. The runs are
+// enumerated once per array extent.
+template<dim_type Dims>
+class parallel_border_copy {
+  public:
+    parallel_border_copy(unsigned num_threads, thread_placement placement)
+        : _num_threads(num_threads), _placement(placement) {}
+
+    template<typename DataType>
+    void pack(compressed_type<DataType> *dest, const DataType *src, const static_extent<Dims> &src_size,
+            index_type side_length) {
+        for_each_share(src_size, side_length, [&](size_t array_offset, size_t border_offset, size_t count) {
+            memcpy(dest + border_offset, src + array_offset, count * sizeof(DataType));
+        });
+    }
 
-    bits_type *data() { return detail::cpu::assume_simd_aligned(cube.data()); }
+    template<typename DataType>
+    void unpack(DataType *dest, const static_extent<Dims> &dest_size, const compressed_type<DataType> *src,
+            index_type side_length) {
+        for_each_share(dest_size, side_length, [&](size_t array_offset, size_t border_offset, size_t count) {
+            memcpy(dest + array_offset, src + border_offset, count * sizeof(DataType));
+        });
+    }
 
-    const bits_type *data() const { return detail::cpu::assume_simd_aligned(cube.data()); }
+  private:
+    // Below this, starting a parallel region costs more than the copy
+    constexpr static size_t min_parallel_elements = 1u << 16;
+
+    unsigned _num_threads;
+    thread_placement _placement;
+    detail::border_slices<Dims> _slices;
+
+    template<typename Fn>
+    void for_each_share(const static_extent<Dims> &size, index_type side_length, const Fn &fn) {
+        if (!_slices.describes(size, side_length)) { _slices = detail::border_slices<Dims>{size, side_length}; }
+        const auto num_elements = _slices.num_elements();
+        if (_num_threads <= 1 || num_elements < min_parallel_elements) {
+            _slices.for_each_in_range(0, num_elements, fn);
+        } else {
+            parallel_region(_num_threads, _placement, [&](unsigned tid, unsigned team_size) {
+                _slices.for_each_in_range(
+                        num_elements * tid / team_size, num_elements * (tid + 1) / team_size, fn);
+            });
+        }
+    }
 };
 
+// Hypercubes are compressed in chunks, each by a single thread into its own scratch buffer. The stream position of a
+// chunk is found by a decoupled look-back over the chunk_status array (Merrill & Garland, "Single-pass Parallel
+// Prefix Scan with Decoupled Look-back"): every chunk first publishes its compressed size, and then accumulates sizes
+// of its predecessors until it reaches one whose inclusive prefix is already known. No thread ever holds a lock while
+// writing its chunk, and a thread only waits if the chunk immediately before its own is still being compressed.
+//
+// With thread_placement::numa, chunks are not handed out dynamically. Instead, every thread compresses one contiguous
+// range of hypercubes - reading the input pages that it (or its node) first-touched - into a thread-local stream, and
+// copies it to its final position once the sizes of all lower ranges are known.
 template<typename Profile>
 class openmp_compressor : public compressor<typename Profile::value_type> {
   public:
@@ -725,51 +2207,65 @@ class openmp_compressor : public compressor<typename Profile::value_type> {
     constexpr static auto dimensions = Profile::dimensions;
     constexpr static auto side_length = Profile::hypercube_side_length;
     constexpr static auto hc_size = detail::ipow(side_length, dimensions);
-    constexpr static index_type num_hcs_per_chunk = 64 / sizeof(value_type);
-    constexpr static index_type num_write_buffers = 30;
+    constexpr static index_type num_hcs_per_chunk = openmp_hypercubes_per_chunk<value_type>;
+    constexpr static size_t write_buffer_length = Profile::compressed_block_length_bound * num_hcs_per_chunk;
 
-    struct write_buffer {
-        size_t first_hc_index = SIZE_MAX;
-        std::array<bits_type, Profile::compressed_block_length_bound * num_hcs_per_chunk> stream;
-        boost::container::static_vector<uint32_t, num_hcs_per_chunk> offsets_after_hcs;
-
-        size_t num_hypercubes() const { return offsets_after_hcs.size(); }
-
-        size_t compressed_size() const { return offsets_after_hcs.back(); }
-    };
-
-    struct hc_index_order {
-        bool operator()(write_buffer *left, write_buffer *right) const {
-            return left->first_hc_index > right->first_hc_index;  // >: priority_queue is a max-heap
-        }
-    };
+    // chunk_status entries hold a flag in the upper bits and a length in stream words in the lower bits
+    constexpr static uint64_t chunk_status_mask = (uint64_t{1} << 62) - 1;
+    constexpr static uint64_t chunk_size_available = uint64_t{1} << 62;
+    constexpr static uint64_t chunk_prefix_available = uint64_t{2} << 62;
 
     const unsigned num_threads;
-    std::vector<cube_buffer<Profile>> thread_cubes{num_threads};
-    std::vector<write_buffer> write_buffers{num_write_buffers};
-    std::priority_queue<write_buffer *, std::vector<write_buffer *>, hc_index_order> write_task_queue;
-    boost::lockfree::queue<write_buffer *, boost::lockfree::capacity<num_write_buffers>> free_write_buffers;
+    const thread_placement placement;
+    const lossy_precision precision;
+    const mantissa_truncation<value_type> truncation{precision};
+    std::unique_ptr<compressor<value_type>> border_compressor;
+    scratch_buffer<value_type> border_elements;
+    std::vector<scratch_buffer<bits_type>> thread_cubes;
+    std::vector<scratch_buffer<bits_type>> thread_write_buffers;
+    parallel_border_copy<dimensions> border_copy{num_threads, placement};
+    // With thread_placement::numa, every thread stages its range of hypercubes at the position in this buffer where
+    // their compressed_block_length_bound would begin. Only the writing thread touches the pages of its range.
+    scratch_buffer<bits_type> range_streams;
+    scratch_buffer<std::atomic<uint64_t>> chunk_status;
+    std::atomic<index_type> next_chunk;
+    std::vector<uint64_t> thread_stream_lengths;
+
+    std::vector<stage_timer> thread_timers;
+
+    void compress_chunks(const value_type *data, const static_extent<dimensions> &data_size,
+            detail::stream<Profile> &stream, hypercube_summary<value_type> *summaries, unsigned tid,
+            stage_timer &timer);
+
+    void compress_contiguous(const value_type *data, const static_extent<dimensions> &data_size,
+            detail::stream<Profile> &stream, hypercube_summary<value_type> *summaries, unsigned tid,
+            unsigned team_size, stage_timer &timer);
 
   public:
-    explicit openmp_compressor(unsigned num_threads) : num_threads(num_threads) {
-        // priority_queue does not expose vector::reserve, push nonsense instead which will be
-        // cleared by prepare()
-        for (auto &wb : write_buffers) {
-            write_task_queue.push(&wb);
-        }
-    }
-
-    void prepare() {
-        while (!write_task_queue.empty()) {
-            write_task_queue.pop();
-        }
-        free_write_buffers.consume_all([](auto) {});
-        for (auto &b : write_buffers) {
-            free_write_buffers.push(&b);
-        }
+    // The buffer layout is mirrored by openmp_compressor_scratch_bytes()
+    explicit openmp_compressor(unsigned num_threads, thread_placement placement = thread_placement::any,
+            const lossy_precision &precision = {}, scratch_arena *arena = nullptr,
+            const scratch_extent &max_extent = {})
+        : num_threads(num_threads)
+        , placement(placement)
+        , precision(precision)
+        , border_compressor(make_border_codec<compressor<value_type>, openmp_compressor, Profile>(
+                  num_threads, placement, precision, arena, border_scratch_extent(max_extent)))
+        , border_elements(arena, detail::has_border_stream<dimensions> ? max_extent.num_border_elements : 0)
+        , thread_cubes(per_thread_scratch<bits_type>(num_threads, arena, hc_size))
+        , thread_write_buffers(per_thread_scratch<bits_type>(
+                  num_threads, placement == thread_placement::numa ? nullptr : arena, write_buffer_length))
+        , range_streams(placement == thread_placement::numa ? arena : nullptr,
+                  size_t{max_extent.num_hypercubes} * Profile::compressed_block_length_bound)
+        , chunk_status(placement == thread_placement::numa ? nullptr : arena,
+                  div_ceil(max_extent.num_hypercubes, num_hcs_per_chunk)) {}
+
+    size_t compress(const value_type *data, const extent &data_size, bits_type *stream) override {
+        return compress_summarized(data, data_size, stream, nullptr);
     }
 
-    index_type compress(const value_type *data, const extent &data_size, bits_type *stream) override;
+    size_t compress_summarized(const value_type *data, const extent &data_size, bits_type *stream,
+            hypercube_summary<value_type> *summaries) override;
 };
 
 template<typename Profile>
@@ -785,127 +2281,199 @@ class openmp_decompressor : public decompressor<typename Profile::value_type> {
     constexpr static auto hc_size = detail::ipow(side_length, dimensions);
 
     const unsigned num_threads;
-    std::vector<cube_buffer<Profile>> thread_cubes{num_threads};
+    const thread_placement placement;
+    std::unique_ptr<decompressor<value_type>> border_decompressor;
+    scratch_buffer<value_type> border_elements;
+    std::vector<scratch_buffer<bits_type>> thread_cubes;
+    parallel_border_copy<dimensions> border_copy{num_threads, placement};
 
   public:
-    explicit openmp_decompressor(unsigned num_threads) : num_threads(num_threads) {}
-
-    index_type decompress(const bits_type *stream, value_type *data, const extent &data_size) override;
+    // The buffer layout is mirrored by openmp_decompressor_scratch_bytes()
+    explicit openmp_decompressor(unsigned num_threads, thread_placement placement = thread_placement::any,
+            scratch_arena *arena = nullptr, const scratch_extent &max_extent = {})
+        : num_threads(num_threads)
+        , placement(placement)
+        , border_decompressor(make_border_codec<decompressor<value_type>, openmp_decompressor, Profile>(
+                  num_threads, placement, arena, border_scratch_extent(max_extent)))
+        , border_elements(arena, detail::has_border_stream<dimensions> ? max_extent.num_border_elements : 0)
+        , thread_cubes(per_thread_scratch<bits_type>(num_threads, arena, hc_size)) {}
+
+    size_t decompress(const bits_type *stream, value_type *data, const extent &data_size) override;
+
+    void decompress_region(const bits_type *raw_stream, const extent &data_size, const extent &region_offset,
+            const extent &region_size, value_type *region) override;
+
+    void decompress_hypercubes(const bits_type *raw_stream, value_type *data, const extent &data_size,
+            const index_type *hc_indices, index_type num_indices) override;
 };
 
 
+[[gnu::always_inline]] inline void spin_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+template<typename Profile>
+void openmp_compressor<Profile>::compress_chunks(const value_type *data, const static_extent<dimensions> &data_size,
+        detail::stream<Profile> &stream, hypercube_summary<value_type> *summaries, unsigned tid, stage_timer &timer) {
+    const auto num_hypercubes = stream.num_hypercubes;
+    const auto num_chunks = div_ceil(num_hypercubes, num_hcs_per_chunk);
+    const auto cube = thread_local_scratch(thread_cubes, tid, hc_size);
+    const auto write_buffer = thread_local_scratch(thread_write_buffers, tid, write_buffer_length);
+    boost::container::static_vector<uint32_t, num_hcs_per_chunk> offsets_after_hcs;
+
+    // memory_order_relaxed: chunks are handed out in order, but their data is only passed on through chunk_status
+    for (index_type chunk; (chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < num_chunks;) {
+        const auto first_hc_index = chunk * num_hcs_per_chunk;
+        const auto chunk_num_hcs = std::min(num_hcs_per_chunk, num_hypercubes - first_hc_index);
+
+        offsets_after_hcs.clear();
+        size_t chunk_offset = 0;
+        for (index_type task_hc_index = 0; task_hc_index < chunk_num_hcs; ++task_hc_index) {
+            auto hc_offset = detail::extent_from_linear_id(first_hc_index + task_hc_index, data_size / side_length)
+                    * side_length;
+            detail::cpu::load_hypercube<Profile>(hc_offset, data, data_size, cube);
+            // The next chunk may be handed to a different thread
+            detail::cpu::prefetch_next_hypercube<Profile>(
+                    first_hc_index + task_hc_index, first_hc_index + chunk_num_hcs, data, data_size);
+            if (!truncation.is_lossless()) { truncate_hypercube<Profile>(cube, truncation); }
+            summarize_hypercube<Profile>(cube, summaries, first_hc_index + task_hc_index);
+            timer.lap(codec_stage::hypercube_memory);
+            chunk_offset += encode_hypercube<Profile>(cube, write_buffer + chunk_offset, timer);
+            offsets_after_hcs.push_back(chunk_offset);
+        }
+
+        // Chunks write disjoint parts of the stream, so chunk_status is the only state shared between threads
+        uint64_t chunk_stream_offset = 0;
+        if (chunk == 0) {
+            chunk_status[0].store(chunk_prefix_available | chunk_offset, std::memory_order_release);
+        } else {
+            chunk_status[chunk].store(chunk_size_available | chunk_offset, std::memory_order_release);
+            for (auto predecessor = chunk - 1;;) {
+                const auto status = chunk_status[predecessor].load(std::memory_order_acquire);
+                if (status & chunk_prefix_available) {
+                    chunk_stream_offset += status & chunk_status_mask;
+                    break;
+                } else if (status & chunk_size_available) {
+                    chunk_stream_offset += status & chunk_status_mask;
+                    --predecessor;
+                } else {
+                    spin_pause();
+                }
+            }
+            chunk_status[chunk].store(
+                    chunk_prefix_available | (chunk_stream_offset + chunk_offset), std::memory_order_release);
+        }
+
+        for (index_type task_hc_index = 0; task_hc_index < chunk_num_hcs; ++task_hc_index) {
+            stream.set_offset_after(
+                    first_hc_index + task_hc_index, chunk_stream_offset + offsets_after_hcs[task_hc_index]);
+        }
+        // stream.hypercube(first_hc_index) would read a header entry written by the predecessor chunk
+        detail::cpu::copy_to_stream(
+                stream.hypercube(0) + chunk_stream_offset, write_buffer, chunk_offset * sizeof(bits_type));
+        // includes spinning on the predecessor chunk
+        timer.lap(codec_stage::output_assembly);
+    }
+}
+
+template<typename Profile>
+void openmp_compressor<Profile>::compress_contiguous(const value_type *data,
+        const static_extent<dimensions> &data_size, detail::stream<Profile> &stream,
+        hypercube_summary<value_type> *summaries, unsigned tid, unsigned team_size, stage_timer &timer) {
+    const auto num_hypercubes = stream.num_hypercubes;
+    const auto first_hc_index = static_cast<index_type>(uint64_t{num_hypercubes} * tid / team_size);
+    const auto end_hc_index = static_cast<index_type>(uint64_t{num_hypercubes} * (tid + 1) / team_size);
+    const auto cube = thread_local_scratch(thread_cubes, tid, hc_size);
+    const auto thread_stream = range_streams.data() + size_t{first_hc_index} * Profile::compressed_block_length_bound;
+
+    // Header entries are written relative to the beginning of the thread's range first and shifted once the length
+    // of all lower ranges is known
+    uint64_t range_offset = 0;
+    for (auto hc_index = first_hc_index; hc_index < end_hc_index; ++hc_index) {
+        auto hc_offset = detail::extent_from_linear_id(hc_index, data_size / side_length) * side_length;
+        detail::cpu::load_hypercube<Profile>(hc_offset, data, data_size, cube);
+        detail::cpu::prefetch_next_hypercube<Profile>(hc_index, end_hc_index, data, data_size);
+        if (!truncation.is_lossless()) { truncate_hypercube<Profile>(cube, truncation); }
+        summarize_hypercube<Profile>(cube, summaries, hc_index);
+        timer.lap(codec_stage::hypercube_memory);
+        range_offset += encode_hypercube<Profile>(cube, thread_stream + range_offset, timer);
+        stream.set_offset_after(hc_index, range_offset);
+    }
+    thread_stream_lengths[tid] = range_offset;
+
+#pragma omp barrier
+
+    const auto range_stream_offset = std::accumulate(
+            thread_stream_lengths.begin(), thread_stream_lengths.begin() + tid, uint64_t{0});
+    for (auto hc_index = first_hc_index; hc_index < end_hc_index; ++hc_index) {
+        stream.set_offset_after(hc_index, range_stream_offset + stream.offset_after(hc_index));
+    }
+    detail::cpu::copy_to_stream(
+            stream.hypercube(0) + range_stream_offset, thread_stream, range_offset * sizeof(bits_type));
+    // includes waiting for the slowest thread at the barrier
+    timer.lap(codec_stage::output_assembly);
+}
+
 template<typename Profile>
-index_type
-openmp_compressor<Profile>::compress(const value_type *data, const extent &data_size, bits_type *raw_stream) {
+size_t openmp_compressor<Profile>::compress_summarized(const value_type *data, const extent &data_size,
+        bits_type *raw_stream, hypercube_summary<value_type> *summaries) {
     if (data_size.dimensions() != dimensions) {
         throw std::runtime_error{"data dimensionality does not match compressor dimensionality"};
     }
 
-    prepare();
-
     const auto static_size = detail::static_extent<dimensions>{data_size};
-    const auto num_hypercubes = detail::num_hypercubes(static_size);
+    const auto num_hypercubes = detail::num_hypercubes(static_size, side_length);
 
     detail::stream<Profile> stream{num_hypercubes, raw_stream};
 
-    std::atomic<size_t> next_hc_index_to_read = 0;
-    std::atomic<size_t> next_hc_index_to_write = 0;
-    std::atomic<size_t> next_available_write_task_hc_index = SIZE_MAX;
-    index_type stream_offset = 0;
-
-#pragma omp parallel num_threads(num_threads)
-#pragma omp single nowait
-    for (size_t tid = 0; tid < num_threads; ++tid)
-#pragma omp task firstprivate(tid)
-    {
-        auto &cube = thread_cubes[tid];
-
-        // memory_order_relaxed: we only depend on next_hc_index_to_write for correctness and modify
-        // it inside a critical section; outside, we can tolerate missed updates (the loop can
-        // produce no-op iterations, the conditional around the critical section is just an
-        // optimization to reduce contention)
-        while (next_hc_index_to_write.load(std::memory_order_relaxed) < num_hypercubes) {
-            write_buffer *write_task = nullptr;
-            size_t task_stream_offset = 0;
-
-            if (next_available_write_task_hc_index.load(std::memory_order_relaxed)
-                    == next_hc_index_to_write.load(std::memory_order_relaxed))  // reduce contention of critical section
-#pragma omp critical(queue)
-            {
-                if (!write_task_queue.empty()
-                        && write_task_queue.top()->first_hc_index
-                                == next_hc_index_to_write.load(std::memory_order_relaxed)) {
-                    write_task = write_task_queue.top();
-                    write_task_queue.pop();
-                    next_available_write_task_hc_index.store(
-                            write_task_queue.empty() ? SIZE_MAX : write_task_queue.top()->first_hc_index,
-                            std::memory_order_relaxed);
-                    next_hc_index_to_write.fetch_add(write_task->num_hypercubes(), std::memory_order_relaxed);
-                    task_stream_offset = stream_offset;
-                    stream_offset += write_task->compressed_size();
-                }
-            }
+    // Every thread times itself on a timer of its own and publishes it once done, which avoids false sharing
+    const bool profile_stages = verbose();
+    thread_timers.assign(profile_stages ? num_threads : 0, stage_timer{});
+    const auto publish_timer = [&](unsigned tid, const stage_timer &timer) {
+        if (profile_stages) { thread_timers[tid] = timer; }
+    };
 
-            if (write_task) {
-                auto task_file_offset = task_stream_offset;
-                for (size_t task_hc_index = 0; task_hc_index < write_task->num_hypercubes(); ++task_hc_index) {
-                    auto hc_index = write_task->first_hc_index + task_hc_index;
-                    task_file_offset = task_stream_offset + write_task->offsets_after_hcs[task_hc_index];
-                    stream.set_offset_after(hc_index, task_file_offset);
-                }
-                memcpy(stream.hypercube(write_task->first_hc_index), write_task->stream.data(),
-                        write_task->compressed_size() * sizeof(bits_type));
-                free_write_buffers.push(write_task);
-            }  //
-            else  // compression task
-            {
-                if (free_write_buffers.pop(write_task)) {
-                    // memory_order_relaxed: There is no synchronization involved, only atomicity is
-                    // required. The ordering of the following operations is determined by the
-                    // returned value.
-                    auto first_hc_index = next_hc_index_to_read.fetch_add(num_hcs_per_chunk, std::memory_order_relaxed);
-
-                    if (first_hc_index < num_hypercubes) {
-                        write_task->first_hc_index = first_hc_index;
-                        write_task->offsets_after_hcs.clear();
-                        for (size_t task_hc_index = 0;
-                                task_hc_index + first_hc_index < num_hypercubes && task_hc_index < num_hcs_per_chunk;
-                                ++task_hc_index) {
-                            auto hc_index = first_hc_index + task_hc_index;
-                            auto hc_offset
-                                    = detail::extent_from_linear_id(hc_index, static_size / side_length) * side_length;
-                            detail::cpu::load_hypercube<Profile>(hc_offset, data, static_size, cube.data());
-                            detail::cpu::block_transform<Profile>(cube.data());
-
-                            task_stream_offset += detail::cpu::zero_bit_encode<bits_type>(cube.data(),
-                                                          reinterpret_cast<std::byte *>(write_task->stream.data())
-                                                                  + task_stream_offset * sizeof(bits_type),
-                                                          hc_size)
-                                    / sizeof(bits_type);
-                            write_task->offsets_after_hcs.push_back(task_stream_offset);
-                        }
-
-#pragma omp critical(queue)
-                        {
-                            write_task_queue.push(write_task);
-                            next_available_write_task_hc_index.store(
-                                    write_task_queue.top()->first_hc_index, std::memory_order_relaxed);
-                        }
-                    } else {
-                        free_write_buffers.push(write_task);
-                    }
-                }
-            }
+    if (placement == thread_placement::numa) {
+        thread_stream_lengths.assign(num_threads, 0);
+        range_streams.reserve(size_t{num_hypercubes} * Profile::compressed_block_length_bound);
+        parallel_region(num_threads, placement, [&](unsigned tid, unsigned team_size) {
+            stage_timer timer{profile_stages};
+            compress_contiguous(data, static_size, stream, summaries, tid, team_size, timer);
+            publish_timer(tid, timer);
+        });
+    } else {
+        const auto num_chunks = div_ceil(num_hypercubes, num_hcs_per_chunk);
+        chunk_status.reserve(num_chunks);
+        for (index_type i = 0; i < num_chunks; ++i) {
+            chunk_status[i].store(0, std::memory_order_relaxed);
         }
+        next_chunk.store(0, std::memory_order_relaxed);
+        parallel_region(num_threads, placement, [&](unsigned tid, unsigned /* team_size */) {
+            stage_timer timer{profile_stages};
+            compress_chunks(data, static_size, stream, summaries, tid, timer);
+            publish_timer(tid, timer);
+        });
     }
 
-    const auto border_length = detail::pack_border(stream.border(), data, static_size, side_length);
+    // The border is gathered and compressed by a team of its own, timed on the calling thread
+    stage_timer border_timer{profile_stages};
+    const auto border_length = compress_border<Profile>(
+            data, static_size, stream.border(), border_compressor.get(), border_elements, truncation, border_copy);
+    border_timer.lap(codec_stage::border);
+    if (profile_stages) {
+        thread_timers[0] += border_timer;
+        print_stage_durations("openmp_compressor", true, thread_timers);
+    }
     return (stream.border() - stream.buffer) + border_length;
 }
 
 
 template<typename Profile>
-index_type
+size_t
 openmp_decompressor<Profile>::decompress(const bits_type *raw_stream, value_type *data, const extent &data_size) {
     if (data_size.dimensions() != dimensions) {
         throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
@@ -914,50 +2482,201 @@ openmp_decompressor<Profile>::decompress(const bits_type *raw_stream, value_type
     constexpr static auto side_length = Profile::hypercube_side_length;
 
     const auto static_size = detail::static_extent<dimensions>{data_size};
-    const auto num_hypercubes = detail::num_hypercubes(static_size);
+    const auto num_hypercubes = detail::num_hypercubes(static_size, side_length);
 
     detail::stream<const Profile> stream{num_hypercubes, raw_stream};
 
-#pragma omp parallel num_threads(num_threads)
-    {
-        auto tid = omp_get_thread_num();
-        auto &cube = thread_cubes[tid];
+    // Decoding cost varies widely between hypercubes, since all-zero words are skipped by zero_bit_decode while dense
+    // hypercubes pay for expand_zero_words and the transposition. Instead of a fixed number of hypercubes, every
+    // thread receives an equal share of the estimated cost, which is read from the stream header: all hypercubes pay
+    // the same inverse transform and store (fixed_hc_cost), plus an amount proportional to their compressed length.
+    // This overestimates raw hypercubes, which are only copied, but those are rare in compressible data.
+    constexpr static uint64_t fixed_hc_cost = hc_size / 2;
+    const auto cost_before = [&](index_type hc_index) {
+        return uint64_t{hc_index} * fixed_hc_cost + (hc_index > 0 ? stream.offset_after(hc_index - 1) : 0);
+    };
+    const auto total_cost = cost_before(num_hypercubes);
+
+    const bool report_imbalance = verbose();
+    std::vector<stage_timer> thread_timers(report_imbalance ? num_threads : 0);
+
+    // The cost-weighted ranges are contiguous already, so thread_placement::numa only needs to pin the team
+    parallel_region(num_threads, placement, [&](unsigned tid, unsigned team_size) {
+        const auto cube = thread_local_scratch(thread_cubes, tid, hc_size);
+
+        const auto first_hc_with_cost = [&](uint64_t cost) {
+            index_type lo = 0, hi = num_hypercubes;
+            while (lo < hi) {
+                const auto mid = lo + (hi - lo) / 2;
+                if (cost_before(mid) < cost) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        };
+        const auto first_hc_index = first_hc_with_cost(total_cost * tid / team_size);
+        const auto end_hc_index = first_hc_with_cost(total_cost * (tid + 1) / team_size);
 
-#pragma omp for schedule(static) nowait
-        for (size_t hc_index = 0; hc_index < num_hypercubes; ++hc_index) {
+        stage_timer timer{report_imbalance};
+        for (index_type hc_index = first_hc_index; hc_index < end_hc_index; ++hc_index) {
             auto hc_offset = detail::extent_from_linear_id(hc_index, static_size / side_length) * side_length;
 
-            detail::cpu::zero_bit_decode<bits_type>(
-                    reinterpret_cast<const std::byte *>(stream.hypercube(hc_index)), cube.data(), hc_size);
-            detail::cpu::inverse_block_transform<Profile>(cube.data());
-            detail::cpu::store_hypercube<Profile>(hc_offset, cube.data(), data, static_size);
+            decode_hypercube<Profile>(
+                    stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube, timer);
+            detail::cpu::store_hypercube<Profile>(hc_offset, cube, data, static_size);
+            timer.lap(codec_stage::hypercube_memory);
         }
+        if (report_imbalance) { thread_timers[tid] = timer; }
+    });
+
+    // The border is decompressed and scattered by a team of its own, timed on the calling thread
+    stage_timer border_timer{report_imbalance};
+    const auto border_length = decompress_border<Profile>(
+            stream.border(), data, static_size, border_decompressor.get(), border_elements, border_copy);
+    border_timer.lap(codec_stage::border);
+
+    if (report_imbalance && !thread_timers.empty()) {
+        std::vector<double> thread_seconds(thread_timers.size());
+        std::transform(thread_timers.begin(), thread_timers.end(), thread_seconds.begin(),
+                [](const stage_timer &timer) { return std::chrono::duration<double>(timer.total()).count(); });
+        const auto [min, max] = std::minmax_element(thread_seconds.begin(), thread_seconds.end());
+        const auto mean = std::accumulate(thread_seconds.begin(), thread_seconds.end(), 0.0) / thread_seconds.size();
+        printf("openmp_decompressor: %u hypercubes on %u threads, thread time min %.3f ms, mean %.3f ms, max %.3f ms, "
+               "imbalance (max / mean) %.3f\n",
+                num_hypercubes, num_threads, *min * 1e3, mean * 1e3, *max * 1e3, mean > 0 ? *max / mean : 1.0);
+        thread_timers[0] += border_timer;
+        print_stage_durations("openmp_decompressor", false, thread_timers);
     }
 
-    const auto border_length
-            = detail::unpack_border(data, static_size, stream.border(), Profile::hypercube_side_length);
     return (stream.border() - stream.buffer) + border_length;
 }
 
-extern template class openmp_compressor<profile<float, 1>>;
-extern template class openmp_compressor<profile<float, 2>>;
-extern template class openmp_compressor<profile<float, 3>>;
-extern template class openmp_compressor<profile<double, 1>>;
-extern template class openmp_compressor<profile<double, 2>>;
-extern template class openmp_compressor<profile<double, 3>>;
+template<typename Profile>
+void openmp_decompressor<Profile>::decompress_region(const bits_type *raw_stream, const extent &data_size,
+        const extent &region_offset, const extent &region_size, value_type *region) {
+    const region_query<Profile> query{data_size, region_offset, region_size};
+    const auto num_region_hypercubes = query.num_hypercubes();
+    detail::stream<const Profile> stream{num_hypercubes(query.data_size(), side_length), raw_stream};
+
+    parallel_region(num_threads, placement, [&](unsigned tid, unsigned /* team_size */) {
+        const auto cube = thread_local_scratch(thread_cubes, tid, hc_size);
+        stage_timer timer;
+
+#pragma omp for schedule(static) nowait
+        for (index_type i = 0; i < num_region_hypercubes; ++i) {
+            const auto [hc_index, hc_offset] = query.hypercube(i);
+            decode_hypercube<Profile>(
+                    stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube, timer);
+            query.store_hypercube(hc_offset, cube, region);
+        }
+    });
+
+    query.unpack_border(decode_border<Profile>(stream.border(), query.data_size(), border_decompressor.get(),
+                                border_elements),
+            region);
+}
+
+template<typename Profile>
+void openmp_decompressor<Profile>::decompress_hypercubes(const bits_type *raw_stream, value_type *data,
+        const extent &data_size, const index_type *hc_indices, index_type num_indices) {
+    if (data_size.dimensions() != dimensions) {
+        throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
+    }
+
+    const auto static_size = detail::static_extent<dimensions>{data_size};
+    const auto num_hcs = num_hypercubes(static_size, side_length);
+    check_hypercube_indices(hc_indices, num_indices, num_hcs);
+    detail::stream<const Profile> stream{num_hcs, raw_stream};
+
+    parallel_region(num_threads, placement, [&](unsigned tid, unsigned /* team_size */) {
+        const auto cube = thread_local_scratch(thread_cubes, tid, hc_size);
+        stage_timer timer;
 
-extern template class openmp_decompressor<profile<float, 1>>;
-extern template class openmp_decompressor<profile<float, 2>>;
-extern template class openmp_decompressor<profile<float, 3>>;
-extern template class openmp_decompressor<profile<double, 1>>;
-extern template class openmp_decompressor<profile<double, 2>>;
-extern template class openmp_decompressor<profile<double, 3>>;
+#pragma omp for schedule(static) nowait
+        for (index_type i = 0; i < num_indices; ++i) {
+            const auto hc_index = hc_indices[i];
+            const auto hc_offset = detail::extent_from_linear_id(hc_index, static_size / side_length) * side_length;
+            decode_hypercube<Profile>(
+                    stream.hypercube(hc_index), stream.hypercube_size(hc_index), cube, timer);
+            detail::cpu::store_hypercube<Profile>(hc_offset, cube, data, static_size);
+        }
+    });
+
+    decompress_border<Profile>(
+            stream.border(), data, static_size, border_decompressor.get(), border_elements, border_copy);
+}
 
-#ifdef SPLIT_CONFIGURATION_cpu_encoder
-template class openmp_compressor<profile<DATA_TYPE, DIMENSIONS>>;
-template class openmp_decompressor<profile<DATA_TYPE, DIMENSIONS>>;
+#define NDZIP_EXTERN_OPENMP_CODECS(T) \
+    extern template class openmp_compressor<profile<T, 1>>; \
+    extern template class openmp_compressor<profile<T, 2>>; \
+    extern template class openmp_compressor<profile<T, 3>>; \
+    extern template class openmp_decompressor<profile<T, 1>>; \
+    extern template class openmp_decompressor<profile<T, 2>>; \
+    extern template class openmp_decompressor<profile<T, 3>>;
+NDZIP_FOR_EACH_CPU_CODEC_TYPE(NDZIP_EXTERN_OPENMP_CODECS)
+#undef NDZIP_EXTERN_OPENMP_CODECS
+
+#ifdef NDZIP_CPU_SPLIT_PROFILE
+template class openmp_compressor<NDZIP_CPU_SPLIT_PROFILE>;
+template class openmp_decompressor<NDZIP_CPU_SPLIT_PROFILE>;
 #endif
 
 #endif  // NDZIP_OPENMP_SUPPORT
 
+}  // namespace ndzip::detail::cpu::NDZIP_CPU_ISA_NAMESPACE
+
+#ifdef NDZIP_CPU_ISA
+
+namespace ndzip::detail::cpu {
+
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::NDZIP_CPU_ISA>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent) {
+    if (num_threads == 1) {
+        return std::make_unique<serial_compressor<Profile>>(precision, arena, max_extent);
+    } else {
+#if NDZIP_OPENMP_SUPPORT
+        return std::make_unique<openmp_compressor<Profile>>(num_threads, placement, precision, arena, max_extent);
+#else
+        abort();  // unreachable
+#endif
+    }
+}
+
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::NDZIP_CPU_ISA>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent) {
+    if (num_threads == 1) {
+        return std::make_unique<serial_decompressor<Profile>>(arena, max_extent);
+    } else {
+#if NDZIP_OPENMP_SUPPORT
+        return std::make_unique<openmp_decompressor<Profile>>(num_threads, placement, arena, max_extent);
+#else
+        abort();  // unreachable
+#endif
+    }
+}
+
+#ifdef NDZIP_CPU_SPLIT_PROFILE
+template std::unique_ptr<compressor<DATA_TYPE>> make_profile_compressor<NDZIP_CPU_SPLIT_PROFILE>(
+        isa_constant<isa::NDZIP_CPU_ISA>, unsigned, thread_placement, const lossy_precision &, scratch_arena *,
+        const scratch_extent &);
+template std::unique_ptr<decompressor<DATA_TYPE>> make_profile_decompressor<NDZIP_CPU_SPLIT_PROFILE>(
+        isa_constant<isa::NDZIP_CPU_ISA>, unsigned, thread_placement, scratch_arena *, const scratch_extent &);
+#endif
+
 }  // namespace ndzip::detail::cpu
+
+#endif  // NDZIP_CPU_ISA
+
+#ifdef NDZIP_CPU_TARGET
+#ifdef __clang__
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
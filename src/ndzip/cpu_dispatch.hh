@@ -0,0 +1,160 @@
+#pragma once
+
+#include "common.hh"
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+
+namespace ndzip::detail::cpu {
+
+// Instruction set levels the CPU codec can be compiled for. The library builds cpu_codec.inl once for every level in
+// NDZIP_CPU_ISAS (see CMakeLists.txt) and picks the fastest one supported by the host when a compressor or
+// decompressor is created, so a single binary runs at full speed on any node of a heterogeneous cluster.
+enum class isa {
+    generic,
+    avx2,         // AVX2, BMI2, FMA (Haswell, Zen)
+    avx512,       // AVX-512 F and BW for the block transform and zero maps (Skylake-X)
+    avx512_gfni,  // additionally AVX-512 VBMI and GFNI for the bit transposition (Ice Lake, Zen 4)
+    neon,
+};
+
+template<isa Isa>
+using isa_constant = std::integral_constant<isa, Isa>;
+
+inline const char *to_string(isa i) {
+    switch (i) {
+        case isa::generic: return "generic";
+        case isa::avx2: return "avx2";
+        case isa::avx512: return "avx512";
+        case isa::avx512_gfni: return "avx512_gfni";
+        case isa::neon: return "neon";
+    }
+    return "unknown";
+}
+
+// ISA levels that were built into the library and are supported by the host CPU, fastest first
+std::vector<isa> supported_isas();
+
+// With an arena, buffers are carved from it for the arrays described by requirements, which must then be non-null
+template<typename T>
+std::unique_ptr<compressor<T>>
+make_compressor(isa target_isa, dim_type dims, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision = {}, hypercube_size size = hypercube_size::standard,
+        scratch_arena *arena = nullptr, const compressor_requirements *requirements = nullptr);
+
+template<typename T>
+std::unique_ptr<decompressor<T>> make_decompressor(isa target_isa, dim_type dims, unsigned num_threads,
+        thread_placement placement, hypercube_size size = hypercube_size::standard, scratch_arena *arena = nullptr,
+        const compressor_requirements *requirements = nullptr);
+
+// Defined and instantiated by the ISA-specific translation units of cpu_codec.inl
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::generic>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::avx2>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::avx512>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::avx512_gfni>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<compressor<typename Profile::value_type>>
+make_profile_compressor(isa_constant<isa::neon>, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, scratch_arena *arena, const scratch_extent &max_extent);
+
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::generic>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::avx2>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::avx512>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::avx512_gfni>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent);
+template<typename Profile>
+std::unique_ptr<decompressor<typename Profile::value_type>>
+make_profile_decompressor(isa_constant<isa::neon>, unsigned num_threads, thread_placement placement,
+        scratch_arena *arena, const scratch_extent &max_extent);
+
+// Bytes that a buffer of `count` elements takes up in a scratch_arena
+template<typename T>
+constexpr size_t scratch_bytes(size_t count) {
+    return detail::ceil(count * sizeof(T), scratch_arena::alignment);
+}
+
+// Number of hypercubes that a thread of openmp_compressor encodes into its write buffer before moving them into place
+template<typename T>
+constexpr index_type openmp_hypercubes_per_chunk = 64 / sizeof(T);
+
+// The border of a multi-dimensional array is compressed as a one-dimensional array by a codec of its own if the stream
+// format has border streams, see has_border_stream and make_border_codec in cpu_codec.inl
+inline scratch_extent border_scratch_extent(const scratch_extent &max_extent) {
+    return {static_cast<index_type>(max_extent.num_border_elements / hypercube_side_length<1>), 0};
+}
+
+// Arena bytes carved by the constructors of the codecs in cpu_codec.inl. serial_compressor and serial_decompressor
+// share a layout.
+template<typename Profile>
+size_t serial_codec_scratch_bytes(const scratch_extent &max_extent) {
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+    auto bytes = scratch_bytes<bits_type>(ipow(Profile::hypercube_side_length, Profile::dimensions));
+    if constexpr (has_border_stream<Profile::dimensions>) {
+        bytes += scratch_bytes<value_type>(max_extent.num_border_elements)
+                + serial_codec_scratch_bytes<profile<value_type, 1>>(border_scratch_extent(max_extent));
+    }
+    return bytes;
+}
+
+template<typename Profile>
+size_t openmp_compressor_scratch_bytes(
+        unsigned num_threads, thread_placement placement, const scratch_extent &max_extent) {
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+    constexpr auto hcs_per_chunk = openmp_hypercubes_per_chunk<value_type>;
+    auto bytes = num_threads * scratch_bytes<bits_type>(ipow(Profile::hypercube_side_length, Profile::dimensions));
+    if (placement == thread_placement::numa) {
+        bytes += scratch_bytes<bits_type>(size_t{max_extent.num_hypercubes} * Profile::compressed_block_length_bound);
+    } else {
+        bytes += num_threads * scratch_bytes<bits_type>(Profile::compressed_block_length_bound * hcs_per_chunk)
+                + scratch_bytes<std::atomic<uint64_t>>(div_ceil(max_extent.num_hypercubes, hcs_per_chunk));
+    }
+    if constexpr (has_border_stream<Profile::dimensions>) {
+        bytes += scratch_bytes<value_type>(max_extent.num_border_elements)
+                + openmp_compressor_scratch_bytes<profile<value_type, 1>>(
+                        num_threads, placement, border_scratch_extent(max_extent));
+    }
+    return bytes;
+}
+
+template<typename Profile>
+size_t openmp_decompressor_scratch_bytes(unsigned num_threads, const scratch_extent &max_extent) {
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+    auto bytes = num_threads * scratch_bytes<bits_type>(ipow(Profile::hypercube_side_length, Profile::dimensions));
+    if constexpr (has_border_stream<Profile::dimensions>) {
+        bytes += scratch_bytes<value_type>(max_extent.num_border_elements)
+                + openmp_decompressor_scratch_bytes<profile<value_type, 1>>(
+                        num_threads, border_scratch_extent(max_extent));
+    }
+    return bytes;
+}
+
+}  // namespace ndzip::detail::cpu
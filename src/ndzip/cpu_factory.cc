@@ -1,4 +1,12 @@
-#include "cpu_codec.inl"
+#include "cpu_dispatch.hh"
+
+#include <chrono>
+
+#include <ndzip/offload.hh>
+
+#if NDZIP_OPENMP_SUPPORT
+#include <boost/thread/thread.hpp>
+#endif
 
 
 namespace ndzip::detail::cpu {
@@ -18,38 +26,284 @@ inline unsigned get_final_num_threads(const unsigned user_preference) {
 #endif
 }
 
-}  // namespace ndzip::detail::cpu
+inline bool host_supports(isa isa_level) {
+    switch (isa_level) {
+        case isa::generic: return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case isa::avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("fma");
+        case isa::avx512:
+            return host_supports(isa::avx2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        case isa::avx512_gfni:
+            return host_supports(isa::avx512) && __builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("gfni");
+#endif
+#ifdef __ARM_NEON
+        case isa::neon: return true;
+#endif
+        default: return false;
+    }
+}
 
-namespace ndzip {
+std::vector<isa> supported_isas() {
+    // NDZIP_CPU_ISA_*_SUPPORT are defined by CMake depending on NDZIP_CPU_ISAS
+    constexpr std::pair<isa, bool> built[] = {
+            {isa::avx512_gfni, NDZIP_CPU_ISA_AVX512_GFNI_SUPPORT},
+            {isa::avx512, NDZIP_CPU_ISA_AVX512_SUPPORT},
+            {isa::avx2, NDZIP_CPU_ISA_AVX2_SUPPORT},
+            {isa::neon, NDZIP_CPU_ISA_NEON_SUPPORT},
+            {isa::generic, NDZIP_CPU_ISA_GENERIC_SUPPORT},
+    };
+    std::vector<isa> isas;
+    for (auto [isa_level, is_built] : built) {
+        if (is_built && host_supports(isa_level)) {
+            isas.push_back(isa_level);
+        }
+    }
+    return isas;
+}
+
+inline isa preferred_isa() {
+    static const isa preferred = [] {
+        const auto isas = supported_isas();
+        if (isas.empty()) {
+            throw std::runtime_error{"ndzip was not built for any instruction set supported by this CPU"};
+        }
+        return isas.front();
+    }();
+    return preferred;
+}
+
+// Hypercube sizes other than the standard one are built for NDZIP_CPU_SIZED_ISA only (see CMakeLists.txt), which is
+// used whatever ISA level was requested
+template<typename T, dim_type Dims, typename IsaTag, typename MakeForProfile>
+auto make_for_hypercube_size(IsaTag isa_tag, hypercube_size size, MakeForProfile &make) {
+    if constexpr (has_sized_profiles<T>) {
+        if (size != hypercube_size::standard && !host_supports(isa::NDZIP_CPU_SIZED_ISA)) {
+            throw std::runtime_error{std::string{"ndzip was built with hypercube sizes other than the standard one "
+                                                 "for ISA "} + to_string(isa::NDZIP_CPU_SIZED_ISA) + " only"};
+        }
+        const auto sized_isa_tag = isa_constant<isa::NDZIP_CPU_SIZED_ISA>{};
+        switch (size) {
+            case hypercube_size::smaller: return make(sized_isa_tag, sized_profile<T, Dims, hypercube_size::smaller>{});
+            case hypercube_size::larger: return make(sized_isa_tag, sized_profile<T, Dims, hypercube_size::larger>{});
+            default: break;
+        }
+    } else if (size != hypercube_size::standard) {
+        throw std::runtime_error{"ndzip was built with hypercube sizes other than the standard one for float and "
+                                 "double only"};
+    }
+    return make(isa_tag, profile<T, Dims>{});
+}
+
+template<typename T, typename MakeForProfile>
+auto make_for_isa_and_profile(isa isa_level, dim_type dims, hypercube_size size, MakeForProfile &&make) {
+    const auto with_profile = [&](auto isa_tag) {
+        switch (dims) {
+            case 1: return make_for_hypercube_size<T, 1>(isa_tag, size, make);
+            case 2: return make_for_hypercube_size<T, 2>(isa_tag, size, make);
+            case 3: return make_for_hypercube_size<T, 3>(isa_tag, size, make);
+            default: throw std::runtime_error{"Invalid dimensionality"};
+        }
+    };
+    switch (isa_level) {
+#if NDZIP_CPU_ISA_GENERIC_SUPPORT
+        case isa::generic: return with_profile(isa_constant<isa::generic>{});
+#endif
+#if NDZIP_CPU_ISA_AVX2_SUPPORT
+        case isa::avx2: return with_profile(isa_constant<isa::avx2>{});
+#endif
+#if NDZIP_CPU_ISA_AVX512_SUPPORT
+        case isa::avx512: return with_profile(isa_constant<isa::avx512>{});
+#endif
+#if NDZIP_CPU_ISA_AVX512_GFNI_SUPPORT
+        case isa::avx512_gfni: return with_profile(isa_constant<isa::avx512_gfni>{});
+#endif
+#if NDZIP_CPU_ISA_NEON_SUPPORT
+        case isa::neon: return with_profile(isa_constant<isa::neon>{});
+#endif
+        default: throw std::runtime_error{std::string{"ndzip was not built for ISA "} + to_string(isa_level)};
+    }
+}
 
+// Forwards arrays of signed integers to the codec of their codec_value_type, which is compiled for unsigned types only.
+// Both share a compressed_type, so streams pass through unchanged.
 template<typename T>
-std::unique_ptr<compressor<T>> make_compressor(dim_type dims, unsigned num_threads) {
-    num_threads = detail::cpu::get_final_num_threads(num_threads);
-    if (num_threads == 1) {
-        return detail::make_with_profile<compressor, detail::cpu::serial_compressor, T>(dims);
+class codec_value_compressor final : public compressor<T> {
+  public:
+    using value_type = T;
+    using compressed_type = detail::bits_type<T>;
+    using codec_type = codec_value_type<T>;
+
+    explicit codec_value_compressor(std::unique_ptr<compressor<codec_type>> codec, hypercube_size size)
+        : _codec(std::move(codec)), _size(size) {}
+
+    size_t compress(const value_type *data, const extent &data_size, compressed_type *stream) override {
+        return _codec->compress(reinterpret_cast<const codec_type *>(data), data_size, stream);
+    }
+
+    // The codec orders values as unsigned integers, so signed summaries are computed in a pass of their own
+    size_t compress_summarized(const value_type *data, const extent &data_size, compressed_type *stream,
+            hypercube_summary<value_type> *summaries) override {
+        const auto length = compress(data, data_size, stream);
+        summarize_hypercubes(data, data_size, summaries, _size);
+        return length;
+    }
+
+  private:
+    std::unique_ptr<compressor<codec_type>> _codec;
+    hypercube_size _size;
+};
+
+template<typename T>
+class codec_value_decompressor final : public decompressor<T> {
+  public:
+    using value_type = T;
+    using compressed_type = detail::bits_type<T>;
+    using codec_type = codec_value_type<T>;
+
+    explicit codec_value_decompressor(std::unique_ptr<decompressor<codec_type>> codec) : _codec(std::move(codec)) {}
+
+    size_t decompress(const compressed_type *stream, value_type *data, const extent &data_size) override {
+        return _codec->decompress(stream, reinterpret_cast<codec_type *>(data), data_size);
+    }
+
+    void decompress_region(const compressed_type *stream, const extent &data_size, const extent &region_offset,
+            const extent &region_size, value_type *region) override {
+        _codec->decompress_region(
+                stream, data_size, region_offset, region_size, reinterpret_cast<codec_type *>(region));
+    }
+
+    void decompress_hypercubes(const compressed_type *stream, value_type *data, const extent &data_size,
+            const index_type *hc_indices, index_type num_indices) override {
+        _codec->decompress_hypercubes(
+                stream, reinterpret_cast<codec_type *>(data), data_size, hc_indices, num_indices);
+    }
+
+  private:
+    std::unique_ptr<decompressor<codec_type>> _codec;
+};
+
+template<typename Profile>
+scratch_extent get_profile_scratch_extent(const compressor_requirements *requirements) {
+    return requirements ? get_scratch_extent(*requirements, Profile::hypercube_side_length) : scratch_extent{};
+}
+
+template<typename T>
+std::unique_ptr<compressor<T>> make_compressor(isa isa_level, dim_type dims, unsigned num_threads,
+        thread_placement placement, const lossy_precision &precision, hypercube_size size, scratch_arena *arena,
+        const compressor_requirements *requirements) {
+    if constexpr (!std::is_same_v<codec_value_type<T>, T>) {
+        auto codec = make_compressor<codec_value_type<T>>(
+                isa_level, dims, num_threads, placement, precision, size, arena, requirements);
+        return std::make_unique<codec_value_compressor<T>>(std::move(codec), size);
     } else {
-#if NDZIP_OPENMP_SUPPORT
-        return detail::make_with_profile<compressor, detail::cpu::openmp_compressor, T>(dims, num_threads);
-#else
-        abort();  // unreachable
-#endif
+        return make_for_isa_and_profile<T>(isa_level, dims, size, [=, &precision](auto isa_tag, auto p) {
+            return make_profile_compressor<decltype(p)>(isa_tag, num_threads, placement, precision, arena,
+                    get_profile_scratch_extent<decltype(p)>(requirements));
+        });
     }
 }
 
 template<typename T>
-std::unique_ptr<decompressor<T>> make_decompressor(dim_type dims, unsigned num_threads) {
-    num_threads = detail::cpu::get_final_num_threads(num_threads);
-    if (num_threads == 1) {
-        return detail::make_with_profile<decompressor, detail::cpu::serial_decompressor, T>(dims);
+std::unique_ptr<decompressor<T>> make_decompressor(isa isa_level, dim_type dims, unsigned num_threads,
+        thread_placement placement, hypercube_size size, scratch_arena *arena,
+        const compressor_requirements *requirements) {
+    if constexpr (!std::is_same_v<codec_value_type<T>, T>) {
+        return std::make_unique<codec_value_decompressor<T>>(make_decompressor<codec_value_type<T>>(
+                isa_level, dims, num_threads, placement, size, arena, requirements));
     } else {
-#if NDZIP_OPENMP_SUPPORT
-        return detail::make_with_profile<decompressor, detail::cpu::openmp_decompressor, T>(dims, num_threads);
-#else
-        abort();  // unreachable
-#endif
+        return make_for_isa_and_profile<T>(isa_level, dims, size, [=](auto isa_tag, auto p) {
+            return make_profile_decompressor<decltype(p)>(
+                    isa_tag, num_threads, placement, arena, get_profile_scratch_extent<decltype(p)>(requirements));
+        });
+    }
+}
+
+template<typename T>
+size_t required_scratch_bytes(
+        const compressor_requirements &req, unsigned num_threads, thread_placement placement, hypercube_size size) {
+    auto codec_bytes = [&](auto /* no ISA */, auto p) {
+        using profile = decltype(p);
+        const auto max_extent = get_profile_scratch_extent<profile>(&req);
+        if (num_threads == 1) { return serial_codec_scratch_bytes<profile>(max_extent); }
+        return std::max(openmp_compressor_scratch_bytes<profile>(num_threads, placement, max_extent),
+                openmp_decompressor_scratch_bytes<profile>(num_threads, max_extent));
+    };
+    using codec_type = codec_value_type<T>;
+    switch (get_dimensionality(req)) {
+        case 1: return make_for_hypercube_size<codec_type, 1>(nullptr, size, codec_bytes);
+        case 2: return make_for_hypercube_size<codec_type, 2>(nullptr, size, codec_bytes);
+        case 3: return make_for_hypercube_size<codec_type, 3>(nullptr, size, codec_bytes);
+        default: throw std::runtime_error{"Invalid dimensionality"};
     }
 }
 
+#define NDZIP_INSTANTIATE_MAKE_ISA_CODECS(T) \
+    template std::unique_ptr<compressor<T>> make_compressor<T>(isa, dim_type, unsigned, thread_placement, \
+            const lossy_precision &, hypercube_size, scratch_arena *, const compressor_requirements *); \
+    template std::unique_ptr<decompressor<T>> make_decompressor<T>(isa, dim_type, unsigned, thread_placement, \
+            hypercube_size, scratch_arena *, const compressor_requirements *);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MAKE_ISA_CODECS)
+#undef NDZIP_INSTANTIATE_MAKE_ISA_CODECS
+
+}  // namespace ndzip::detail::cpu
+
+namespace ndzip {
+
+template<typename T>
+std::unique_ptr<compressor<T>> make_compressor(dim_type dims, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, hypercube_size size) {
+    num_threads = detail::cpu::get_final_num_threads(num_threads);
+    return detail::cpu::make_compressor<T>(
+            detail::cpu::preferred_isa(), dims, num_threads, placement, precision, size);
+}
+
+template<typename T>
+std::unique_ptr<decompressor<T>>
+make_decompressor(dim_type dims, unsigned num_threads, thread_placement placement, hypercube_size size) {
+    num_threads = detail::cpu::get_final_num_threads(num_threads);
+    return detail::cpu::make_decompressor<T>(detail::cpu::preferred_isa(), dims, num_threads, placement, size);
+}
+
+template<typename T>
+std::unique_ptr<compressor<T>> make_compressor(const compressor_requirements &req, scratch_arena &arena,
+        unsigned num_threads, thread_placement placement, const lossy_precision &precision, hypercube_size size) {
+    num_threads = detail::cpu::get_final_num_threads(num_threads);
+    return detail::cpu::make_compressor<T>(detail::cpu::preferred_isa(), detail::get_dimensionality(req),
+            num_threads, placement, precision, size, &arena, &req);
+}
+
+template<typename T>
+std::unique_ptr<decompressor<T>> make_decompressor(const compressor_requirements &req, scratch_arena &arena,
+        unsigned num_threads, thread_placement placement, hypercube_size size) {
+    num_threads = detail::cpu::get_final_num_threads(num_threads);
+    return detail::cpu::make_decompressor<T>(detail::cpu::preferred_isa(), detail::get_dimensionality(req),
+            num_threads, placement, size, &arena, &req);
+}
+
+template<typename T>
+size_t required_scratch_bytes(
+        const compressor_requirements &req, unsigned num_threads, thread_placement placement, hypercube_size size) {
+    num_threads = detail::cpu::get_final_num_threads(num_threads);
+    // The arena memory may begin at any address
+    return scratch_arena::alignment
+            + detail::cpu::required_scratch_bytes<T>(req, num_threads, placement, size);
+}
+
+#define NDZIP_INSTANTIATE_MAKE_CODECS(T) \
+    template std::unique_ptr<compressor<T>> make_compressor<T>( \
+            dim_type, unsigned, thread_placement, const lossy_precision &, hypercube_size); \
+    template std::unique_ptr<decompressor<T>> make_decompressor<T>( \
+            dim_type, unsigned, thread_placement, hypercube_size); \
+    template std::unique_ptr<compressor<T>> make_compressor<T>(const compressor_requirements &, scratch_arena &, \
+            unsigned, thread_placement, const lossy_precision &, hypercube_size); \
+    template std::unique_ptr<decompressor<T>> make_decompressor<T>( \
+            const compressor_requirements &, scratch_arena &, unsigned, thread_placement, hypercube_size); \
+    template size_t required_scratch_bytes<T>( \
+            const compressor_requirements &, unsigned, thread_placement, hypercube_size);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MAKE_CODECS)
+#undef NDZIP_INSTANTIATE_MAKE_CODECS
+
 }  // namespace ndzip
 namespace ndzip::detail::cpu {
 
@@ -61,23 +315,47 @@ class cpu_offloader final : public offloader<T> {
 
     cpu_offloader() = default;
 
-    explicit cpu_offloader(dim_type dims, unsigned num_threads)
-        : _co{make_compressor<T>(dims, num_threads)}, _de{make_decompressor<T>(dims, num_threads)} {}
+    explicit cpu_offloader(dim_type dims, unsigned num_threads, thread_placement placement,
+            const lossy_precision &precision, hypercube_size size)
+        : _co{ndzip::make_compressor<T>(dims, num_threads, placement, precision, size)}
+        , _de{ndzip::make_decompressor<T>(dims, num_threads, placement, size)} {}
+
+    ~cpu_offloader() override { this->finish_async(); }
 
   protected:
-    index_type do_compress(const value_type *data, const extent &data_size, compressed_type *stream,
+    size_t do_compress(const value_type *data, const extent &data_size, compressed_type *stream,
             kernel_duration *duration) override {
-        // TODO duration
-        return _co->compress(data, data_size, stream);
+        return timed(duration, [&] { return _co->compress(data, data_size, stream); });
     }
 
-    index_type do_decompress(const compressed_type *stream, [[maybe_unused]] index_type stream_length, value_type *data,
+    size_t do_decompress(const compressed_type *stream, [[maybe_unused]] size_t stream_length, value_type *data,
             const extent &data_size, kernel_duration *duration) override {
-        // TODO duration
-        return _de->decompress(stream, data, data_size);
+        return timed(duration, [&] { return _de->decompress(stream, data, data_size); });
+    }
+
+    void do_decompress_region(const compressed_type *stream, [[maybe_unused]] size_t stream_length,
+            const extent &data_size, const extent &region_offset, const extent &region_size, value_type *region,
+            kernel_duration *duration) override {
+        timed(duration, [&] { _de->decompress_region(stream, data_size, region_offset, region_size, region); });
     }
 
   private:
+    // The CPU codecs run synchronously, so the kernel duration is the wall time of the call. A per-thread breakdown by
+    // stage is printed by the codecs themselves when NDZIP_VERBOSE is set.
+    template<typename F>
+    static auto timed(kernel_duration *duration, F &&f) {
+        if (!duration) { return f(); }
+        const auto start = std::chrono::steady_clock::now();
+        if constexpr (std::is_void_v<decltype(f())>) {
+            f();
+            *duration = std::chrono::duration_cast<kernel_duration>(std::chrono::steady_clock::now() - start);
+        } else {
+            auto result = f();
+            *duration = std::chrono::duration_cast<kernel_duration>(std::chrono::steady_clock::now() - start);
+            return result;
+        }
+    }
+
     std::unique_ptr<compressor<T>> _co;
     std::unique_ptr<decompressor<T>> _de;
 };
@@ -87,11 +365,15 @@ class cpu_offloader final : public offloader<T> {
 namespace ndzip {
 
 template<typename T>
-std::unique_ptr<offloader<T>> make_cpu_offloader(dim_type dims, unsigned num_threads) {
-    return std::make_unique<detail::cpu::cpu_offloader<T>>(dims, num_threads);
+std::unique_ptr<offloader<T>> make_cpu_offloader(dim_type dims, unsigned num_threads, thread_placement placement,
+        const lossy_precision &precision, hypercube_size size) {
+    return std::make_unique<detail::cpu::cpu_offloader<T>>(dims, num_threads, placement, precision, size);
 }
 
-template std::unique_ptr<offloader<float>> make_cpu_offloader<float>(dim_type, unsigned);
-template std::unique_ptr<offloader<double>> make_cpu_offloader<double>(dim_type, unsigned);
+#define NDZIP_INSTANTIATE_MAKE_CPU_OFFLOADER(T) \
+    template std::unique_ptr<offloader<T>> make_cpu_offloader<T>( \
+            dim_type, unsigned, thread_placement, const lossy_precision &, hypercube_size);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MAKE_CPU_OFFLOADER)
+#undef NDZIP_INSTANTIATE_MAKE_CPU_OFFLOADER
 
 }  // namespace ndzip
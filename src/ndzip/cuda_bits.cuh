@@ -184,7 +184,7 @@ class cuda_buffer {
     cuda_buffer &operator=(cuda_buffer &&other) noexcept {
         reset();
         std::swap(_memory, other._memory);
-        std::swap(_memory, other._size);
+        std::swap(_size, other._size);
         return *this;
     }
 
@@ -658,20 +658,24 @@ class cuda_offloader final : public offloader<typename Profile::value_type> {
     using bits_type = typename Profile::bits_type;
     constexpr static dim_type dimensions = Profile::dimensions;
 
+    ~cuda_offloader() override { this->finish_async(); }
+
   protected:
-    index_type do_compress(
+    size_t do_compress(
             const value_type *data, const extent &data_size, bits_type *stream, kernel_duration *duration) override;
 
-    index_type do_decompress(const bits_type *stream, index_type length, value_type *data, const extent &data_size,
+    size_t do_decompress(const bits_type *stream, size_t length, value_type *data, const extent &data_size,
             kernel_duration *duration) override;
 };
 
 template<typename Profile>
-index_type cuda_offloader<Profile>::do_compress(
+size_t cuda_offloader<Profile>::do_compress(
         const value_type *data, const extent &data_size, bits_type *raw_stream, kernel_duration *out_kernel_duration) {
     // TODO edge case w/ 0 hypercubes
 
-    const auto num_hypercubes = detail::num_hypercubes(data_size);
+    const auto static_size = static_extent<dimensions>{data_size};
+    gpu::check_gpu_array_size<Profile>(static_size);
+    const auto num_hypercubes = detail::num_hypercubes(static_size);
     if (verbose()) {
         printf("Have %u hypercubes\n", num_hypercubes);
     }
@@ -714,13 +718,14 @@ index_type cuda_offloader<Profile>::do_compress(
 }
 
 template<typename Profile>
-index_type cuda_offloader<Profile>::do_decompress(const bits_type *raw_stream, index_type length, value_type *data,
+size_t cuda_offloader<Profile>::do_decompress(const bits_type *raw_stream, size_t length, value_type *data,
         const extent &data_size, kernel_duration *out_kernel_duration) {
     if (data_size.dimensions() != dimensions) {
         throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
     }
 
     const auto static_size = static_extent<dimensions>{data_size};
+    gpu::check_gpu_array_size<Profile>(static_size);
     const auto num_hypercubes = detail::num_hypercubes(static_size);
 
     // TODO the range computation here is questionable at best
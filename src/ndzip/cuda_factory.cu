@@ -14,7 +14,7 @@ std::unique_ptr<ndzip::cuda_decompressor<T>> ndzip::make_cuda_decompressor(dim_t
 }
 
 template<typename T>
-std::unique_ptr<ndzip::offloader<T>> ndzip::make_cuda_offloader(dim_type dimensions) {
+std::unique_ptr<ndzip::offloader<T>> ndzip::detail::make_cuda_offloader(dim_type dimensions) {
     return detail::make_with_profile<offloader, detail::gpu_cuda::cuda_offloader, T>(dimensions);
 }
 
@@ -26,7 +26,7 @@ template std::unique_ptr<ndzip::cuda_decompressor<float>> make_cuda_decompressor
 template std::unique_ptr<ndzip::cuda_compressor<double>> make_cuda_compressor<double>(
         const compressor_requirements &, cudaStream_t);
 template std::unique_ptr<ndzip::cuda_decompressor<double>> make_cuda_decompressor<double>(dim_type, cudaStream_t);
-template std::unique_ptr<offloader<float>> make_cuda_offloader<float>(dim_type);
-template std::unique_ptr<offloader<double>> make_cuda_offloader<double>(dim_type);
+template std::unique_ptr<offloader<float>> detail::make_cuda_offloader<float>(dim_type);
+template std::unique_ptr<offloader<double>> detail::make_cuda_offloader<double>(dim_type);
 
 }  // namespace ndzip
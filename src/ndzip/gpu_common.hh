@@ -32,6 +32,17 @@ NDZIP_UNIVERSAL index_type global_offset(index_type local_offset, static_extent<
 }
 
 
+// GPU kernels index elements and stream words with 32-bit arithmetic and write narrow stream headers directly
+template<typename Profile>
+void check_gpu_array_size(const static_extent<Profile::dimensions> &data_size) {
+    if (num_elements(data_size) > ~index_type{}
+            || stream<Profile>::needs_wide_offsets(num_hypercubes(data_size))) {
+        throw std::runtime_error{"array of " + std::to_string(num_elements(data_size))
+                + " elements exceeds the 32-bit limit of the GPU codecs"};
+    }
+}
+
+
 // We want to maintain a fixed number of threads per SM to control occupancy. Occupancy is
 // primarily limited by local memory usage, so we adjust the group size to keep local memory
 // requirement constant -- 256 threads/group for 32 bit, 512 threads/group for 64 bit.
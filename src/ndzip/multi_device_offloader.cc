@@ -0,0 +1,336 @@
+#include "common.hh"
+
+#include <ndzip/offload.hh>
+
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace ndzip::detail {
+
+// Splits every array into one shard of contiguous hypercube rows per device. Since hypercubes are numbered in
+// row-major order, each shard is an array of its own whose hypercubes appear unchanged in the stream of the full
+// array: shard streams are stitched by concatenating their hypercube data and shifting their header entries. Shard
+// borders, followed by the rows not covered by hypercubes, form the array border, which the calling thread handles
+// on the CPU while one host thread per device drives the shards.
+template<typename Profile>
+class multi_device_offloader final : public offloader<typename Profile::value_type> {
+  public:
+    using value_type = typename Profile::value_type;
+    using bits_type = typename Profile::bits_type;
+    constexpr static dim_type dimensions = Profile::dimensions;
+
+    explicit multi_device_offloader(std::vector<std::unique_ptr<offloader<value_type>>> devices);
+
+    ~multi_device_offloader() override { this->finish_async(); }
+
+  protected:
+    size_t do_compress(
+            const value_type *data, const extent &data_size, bits_type *stream, kernel_duration *duration) override;
+
+    size_t do_decompress(const bits_type *stream, size_t length, value_type *data, const extent &data_size,
+            kernel_duration *duration) override;
+
+  private:
+    constexpr static index_type side_length = Profile::hypercube_side_length;
+
+    struct shard {
+        extent size;
+        index_type first_hc_index;
+        index_type num_hcs;
+        size_t first_element;
+        size_t first_border_element;  // position of the shard border within the array border
+        size_t num_border_elements;
+    };
+
+    std::vector<std::unique_ptr<offloader<value_type>>> _devices;
+    std::vector<std::vector<bits_type>> _shard_streams;
+    std::vector<kernel_duration> _shard_durations;
+    std::vector<std::unique_ptr<compressor<value_type>>> _shard_border_compressors;
+    std::unique_ptr<compressor<value_type>> _border_compressor;
+    std::unique_ptr<decompressor<value_type>> _border_decompressor;
+    std::vector<bits_type> _border;
+    std::vector<bits_type> _border_stream;
+
+    // Empty if the array has less than two rows of hypercubes, since the first device alone handles it then
+    std::vector<shard> make_shards(const static_extent<dimensions> &data_size) const;
+
+    // Invokes shard_fn(i) for every shard on a thread of its own and host_fn() on the calling thread
+    template<typename ShardFn, typename HostFn>
+    void run_concurrently(size_t num_shards, ShardFn &&shard_fn, HostFn &&host_fn);
+
+    kernel_duration max_shard_duration(size_t num_shards) const;
+};
+
+template<typename Profile>
+multi_device_offloader<Profile>::multi_device_offloader(std::vector<std::unique_ptr<offloader<value_type>>> devices)
+    : _devices(std::move(devices)) {
+    if (_devices.empty()) { throw std::runtime_error{"multi-device offloader requires at least one device"}; }
+    for (auto &device : _devices) {
+        if (!device) { throw std::runtime_error{"multi-device offloader requires non-null devices"}; }
+    }
+    if constexpr (has_border_stream<dimensions>) {
+        _border_compressor = make_compressor<value_type>(1, 1);
+        _border_decompressor = make_decompressor<value_type>(1, 1);
+    }
+}
+
+template<typename Profile>
+auto multi_device_offloader<Profile>::make_shards(const static_extent<dimensions> &data_size) const
+        -> std::vector<shard> {
+    const index_type num_hc_rows = data_size[0] / side_length;
+    const auto num_shards = std::min(num_hc_rows, static_cast<index_type>(_devices.size()));
+    if (num_shards < 2) { return {}; }
+
+    const index_type hcs_per_row = num_hypercubes(data_size) / num_hc_rows;
+    size_t elements_per_row = side_length;
+    for (dim_type d = 1; d < dimensions; ++d) {
+        elements_per_row *= data_size[d];
+    }
+
+    std::vector<shard> shards;
+    shards.reserve(num_shards);
+    size_t first_border_element = 0;
+    for (index_type i = 0; i < num_shards; ++i) {
+        const auto first_row = static_cast<index_type>(uint64_t{num_hc_rows} * i / num_shards);
+        const auto end_row = static_cast<index_type>(uint64_t{num_hc_rows} * (i + 1) / num_shards);
+        auto shard_size = data_size;
+        shard_size[0] = (end_row - first_row) * side_length;
+        const auto num_border_elements = border_element_count(shard_size, side_length);
+        shards.push_back(shard{shard_size, first_row * hcs_per_row, (end_row - first_row) * hcs_per_row,
+                first_row * elements_per_row, first_border_element, num_border_elements});
+        first_border_element += num_border_elements;
+    }
+    return shards;
+}
+
+template<typename Profile>
+template<typename ShardFn, typename HostFn>
+void multi_device_offloader<Profile>::run_concurrently(size_t num_shards, ShardFn &&shard_fn, HostFn &&host_fn) {
+    std::vector<std::exception_ptr> errors(num_shards + 1);
+    std::vector<std::thread> threads;
+    threads.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+        threads.emplace_back([&, i] {
+            try {
+                shard_fn(i);
+            } catch (...) { errors[i] = std::current_exception(); }
+        });
+    }
+    try {
+        host_fn();
+    } catch (...) { errors[num_shards] = std::current_exception(); }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto &error : errors) {
+        if (error) { std::rethrow_exception(error); }
+    }
+}
+
+template<typename Profile>
+kernel_duration multi_device_offloader<Profile>::max_shard_duration(size_t num_shards) const {
+    // Devices run concurrently, so the slowest one determines the kernel time of the array
+    kernel_duration duration{};
+    for (size_t i = 0; i < num_shards; ++i) {
+        duration = std::max(duration, _shard_durations[i]);
+    }
+    return duration;
+}
+
+template<typename Profile>
+size_t multi_device_offloader<Profile>::do_compress(
+        const value_type *data, const extent &data_size, bits_type *raw_stream, kernel_duration *duration) {
+    if (data_size.dimensions() != dimensions) {
+        throw std::runtime_error{"data dimensionality does not match compressor dimensionality"};
+    }
+
+    const auto static_size = static_extent<dimensions>{data_size};
+    const auto shards = make_shards(static_size);
+    if (shards.empty()) { return _devices[0]->compress(data, data_size, raw_stream, duration); }
+
+    const auto num_border_elements = border_element_count(static_size, side_length);
+    const auto &last_shard = shards.back();
+    const auto trailing_rows_element = last_shard.first_element + num_elements(last_shard.size);
+    const auto trailing_rows_border_element = last_shard.first_border_element + last_shard.num_border_elements;
+
+    _shard_streams.resize(shards.size());
+    _shard_durations.assign(shards.size(), kernel_duration{});
+    size_t border_length = 0;
+    run_concurrently(
+            shards.size(),
+            [&](size_t i) {
+                const auto &s = shards[i];
+                auto &shard_stream = _shard_streams[i];
+                shard_stream.resize(compressed_length_bound<value_type>(s.size));
+                _devices[i]->compress(data + s.first_element, s.size, shard_stream.data(),
+                        duration ? &_shard_durations[i] : nullptr);
+            },
+            [&] {
+                if constexpr (dimensions > 1) {
+                    // Shard streams carry the shard border behind their own hypercubes, so the border is packed again
+                    if (num_border_elements == 0) { return; }
+                    _border.resize(num_border_elements);
+                    for (auto &s : shards) {
+                        pack_border(_border.data() + s.first_border_element, data + s.first_element,
+                                static_extent<dimensions>{s.size}, side_length);
+                    }
+                    memcpy(_border.data() + trailing_rows_border_element, data + trailing_rows_element,
+                            (num_border_elements - trailing_rows_border_element) * sizeof(value_type));
+                }
+                if constexpr (has_border_stream<dimensions>) {
+                    if (num_border_elements == 0) { return; }
+                    const auto border_size = border_extent(static_size, side_length);
+                    _border_stream.resize(compressed_length_bound<value_type>(border_size));
+                    // pack_border stores value bits verbatim
+                    border_length = _border_compressor->compress(
+                            reinterpret_cast<const value_type *>(_border.data()), border_size, _border_stream.data());
+                }
+            });
+
+    // The stream layout only depends on the data type, not on the dimensionality of the profile
+    using stream_profile = profile<value_type, 1>;
+    const auto num_hcs = num_hypercubes(static_size);
+    const auto header_length = stream<stream_profile>::header_length(num_hcs);
+    stream<stream_profile> stream{num_hcs, raw_stream};
+    memset(raw_stream, 0, header_length * sizeof(bits_type));  // includes the padding after an odd number of entries
+
+    size_t hypercubes_length = 0;
+    for (size_t i = 0; i < shards.size(); ++i) {
+        const auto &s = shards[i];
+        detail::stream<const stream_profile> shard_stream{s.num_hcs, _shard_streams[i].data()};
+        for (index_type hc_index = 0; hc_index < s.num_hcs; ++hc_index) {
+            stream.set_offset_after(
+                    s.first_hc_index + hc_index, hypercubes_length + shard_stream.offset_after(hc_index));
+        }
+        const auto shard_hypercubes_length = static_cast<size_t>(shard_stream.border() - shard_stream.hypercube(0));
+        memcpy(stream.hypercube(0) + hypercubes_length, shard_stream.hypercube(0),
+                shard_hypercubes_length * sizeof(bits_type));
+        hypercubes_length += shard_hypercubes_length;
+    }
+
+    const auto border_offset = header_length + hypercubes_length;
+    if constexpr (dimensions == 1) {
+        // The border of a one-dimensional array is stored verbatim
+        memcpy(raw_stream + border_offset, data + trailing_rows_element, num_border_elements * sizeof(value_type));
+        border_length = num_border_elements;
+    } else if constexpr (!has_border_stream<dimensions>) {
+        memcpy(raw_stream + border_offset, _border.data(), num_border_elements * sizeof(bits_type));
+        border_length = num_border_elements;
+    } else {
+        memcpy(raw_stream + border_offset, _border_stream.data(), border_length * sizeof(bits_type));
+    }
+
+    if (duration) { *duration = max_shard_duration(shards.size()); }
+    return border_offset + border_length;
+}
+
+template<typename Profile>
+size_t multi_device_offloader<Profile>::do_decompress(const bits_type *raw_stream, size_t length, value_type *data,
+        const extent &data_size, kernel_duration *duration) {
+    if (data_size.dimensions() != dimensions) {
+        throw std::runtime_error{"data dimensionality does not match decompressor dimensionality"};
+    }
+
+    const auto static_size = static_extent<dimensions>{data_size};
+    const auto shards = make_shards(static_size);
+    if (shards.empty()) { return _devices[0]->decompress(raw_stream, length, data, data_size, duration); }
+
+    using stream_profile = profile<value_type, 1>;
+    const auto num_hcs = num_hypercubes(static_size);
+    detail::stream<const stream_profile> stream{num_hcs, raw_stream};
+    const auto border_offset = static_cast<size_t>(stream.border() - raw_stream);
+
+    const auto num_border_elements = border_element_count(static_size, side_length);
+    const auto &last_shard = shards.back();
+    const auto trailing_rows_element = last_shard.first_element + num_elements(last_shard.size);
+    const auto trailing_rows_border_element = last_shard.first_border_element + last_shard.num_border_elements;
+
+    // Shards are decompressed from streams of their own, whose borders are re-encoded from the decoded array border.
+    // The border is a small fraction of all elements, so this costs little compared to the hypercubes.
+    // The border elements in the order of pack_border
+    const bits_type *border = stream.border();
+    size_t border_length = num_border_elements;
+    if constexpr (has_border_stream<dimensions>) {
+        if (num_border_elements > 0) {
+            _border.resize(num_border_elements);
+            border_length = _border_decompressor->decompress(stream.border(),
+                    reinterpret_cast<value_type *>(_border.data()), border_extent(static_size, side_length));
+        }
+        border = _border.data();
+        if (_shard_border_compressors.size() < shards.size()) { _shard_border_compressors.resize(shards.size()); }
+    }
+
+    _shard_streams.resize(shards.size());
+    _shard_durations.assign(shards.size(), kernel_duration{});
+    run_concurrently(
+            shards.size(),
+            [&](size_t i) {
+                const auto &s = shards[i];
+                const auto first_offset = s.first_hc_index > 0 ? stream.offset_after(s.first_hc_index - 1) : 0;
+                const auto hypercubes_length = stream.offset_after(s.first_hc_index + s.num_hcs - 1) - first_offset;
+                const auto header_length = detail::stream<stream_profile>::header_length(s.num_hcs);
+                const auto border_bound = s.num_border_elements > 0
+                        ? compressed_length_bound<value_type>(extent{static_cast<index_type>(s.num_border_elements)})
+                        : 0;
+
+                auto &shard_stream_buf = _shard_streams[i];
+                shard_stream_buf.resize(header_length + hypercubes_length + border_bound);
+                detail::stream<stream_profile> shard_stream{s.num_hcs, shard_stream_buf.data()};
+                memset(shard_stream_buf.data(), 0, header_length * sizeof(bits_type));
+                for (index_type hc_index = 0; hc_index < s.num_hcs; ++hc_index) {
+                    shard_stream.set_offset_after(
+                            hc_index, stream.offset_after(s.first_hc_index + hc_index) - first_offset);
+                }
+                memcpy(shard_stream.hypercube(0), stream.hypercube(0) + first_offset,
+                        hypercubes_length * sizeof(bits_type));
+
+                size_t shard_border_length = 0;
+                if constexpr (has_border_stream<dimensions>) {
+                    if (s.num_border_elements > 0) {
+                        auto &border_compressor = _shard_border_compressors[i];
+                        if (!border_compressor) { border_compressor = make_compressor<value_type>(1, 1); }
+                        shard_border_length = border_compressor->compress(
+                                reinterpret_cast<const value_type *>(border + s.first_border_element),
+                                extent{static_cast<index_type>(s.num_border_elements)},
+                                shard_stream.hypercube(0) + hypercubes_length);
+                    }
+                } else {
+                    memcpy(shard_stream.hypercube(0) + hypercubes_length, border + s.first_border_element,
+                            s.num_border_elements * sizeof(bits_type));
+                    shard_border_length = s.num_border_elements;
+                }
+
+                const auto shard_stream_length = header_length + hypercubes_length + shard_border_length;
+                _devices[i]->decompress(shard_stream_buf.data(), shard_stream_length, data + s.first_element, s.size,
+                        duration ? &_shard_durations[i] : nullptr);
+            },
+            [&] {
+                // Rows past the last full row of hypercubes belong to the border in their entirety
+                memcpy(data + trailing_rows_element, border + trailing_rows_border_element,
+                        (num_border_elements - trailing_rows_border_element) * sizeof(value_type));
+            });
+
+    if (duration) { *duration = max_shard_duration(shards.size()); }
+    return border_offset + border_length;
+}
+
+}  // namespace ndzip::detail
+
+namespace ndzip {
+
+template<typename T>
+std::unique_ptr<offloader<T>>
+make_multi_device_offloader(dim_type dimensions, std::vector<std::unique_ptr<offloader<T>>> devices) {
+    return detail::make_with_profile<offloader, detail::multi_device_offloader, T>(dimensions, std::move(devices));
+}
+
+#define NDZIP_INSTANTIATE_MAKE_MULTI_DEVICE_OFFLOADER(T) \
+    template std::unique_ptr<offloader<T>> make_multi_device_offloader<T>( \
+            dim_type, std::vector<std::unique_ptr<offloader<T>>>);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MAKE_MULTI_DEVICE_OFFLOADER)
+#undef NDZIP_INSTANTIATE_MAKE_MULTI_DEVICE_OFFLOADER
+
+}  // namespace ndzip
@@ -0,0 +1,209 @@
+#include "common.hh"
+
+#include <utility>
+#include <vector>
+
+
+namespace ndzip::detail {
+
+// Every full row of hypercubes (a slab of side_length rows) is compressed as an array of its own. Since hypercubes
+// are numbered in row-major order and the border is packed in linear element order, the slab streams splice into the
+// stream of the full array: hypercube data is concatenated, slab header entries are shifted by the length of all
+// preceding slabs, and slab borders, followed by the remaining rows not covered by hypercubes, form the array border,
+// which is compressed once all rows are known (or stored verbatim, see has_border_stream).
+template<typename T>
+class slab_stream_compressor final : public stream_compressor<T> {
+  public:
+    using value_type = T;
+    using compressed_type = detail::bits_type<T>;
+    using sink_type = typename stream_compressor<T>::sink_type;
+
+    slab_stream_compressor(const extent &data_size, sink_type sink, unsigned num_threads);
+
+    void write_rows(const value_type *rows, index_type num_rows) override;
+
+    index_type rows_per_slab() const override { return _side_length; }
+
+    size_t finish() override;
+
+  private:
+    extent _size;
+    extent _slab_size;
+    index_type _side_length;
+    index_type _row_length;
+    index_type _hc_rows;  // rows covered by hypercubes
+    index_type _num_slab_hypercubes;
+    index_type _num_hypercubes;
+    size_t _header_length;
+    sink_type _sink;
+    std::unique_ptr<compressor<T>> _compressor;
+    std::unique_ptr<compressor<T>> _border_compressor;
+    std::vector<compressed_type> _slab_stream;
+    std::vector<value_type> _partial_slab;
+    index_type _partial_slab_rows = 0;
+    index_type _rows_written = 0;
+    std::vector<size_t> _offsets_after_hcs;
+    size_t _hypercubes_length = 0;
+    std::vector<compressed_type> _border;
+    bool _finished = false;
+
+    void compress_slab(const value_type *slab);
+
+    template<dim_type Dims>
+    void append_slab_border(const value_type *slab);
+    void append_border(const value_type *elements, size_t count);
+};
+
+template<typename T>
+slab_stream_compressor<T>::slab_stream_compressor(const extent &data_size, sink_type sink, unsigned num_threads)
+    : _size(data_size)
+    , _slab_size(data_size)
+    , _side_length(hypercube_side_length_for(data_size.dimensions(), hypercube_size::standard))
+    , _row_length(num_elements(data_size) / std::max(data_size[0], index_type{1}))
+    , _hc_rows(data_size[0] / _side_length * _side_length)
+    , _sink(std::move(sink))
+    , _compressor(make_compressor<T>(data_size.dimensions(), num_threads))
+    , _border_compressor(make_compressor<T>(1, num_threads)) {
+    _slab_size[0] = _side_length;
+    _num_slab_hypercubes = num_hypercubes(_slab_size);
+    _num_hypercubes = num_hypercubes(data_size);
+    _header_length = stream<profile<T, 1>>::header_length(_num_hypercubes);
+    _offsets_after_hcs.reserve(_num_hypercubes);
+    if (_hc_rows > 0) { _slab_stream.resize(compressed_length_bound<T>(_slab_size)); }
+}
+
+template<typename T>
+void slab_stream_compressor<T>::compress_slab(const value_type *slab) {
+    _compressor->compress(slab, _slab_size, _slab_stream.data());
+
+    // The stream layout only depends on the data type, not on the dimensionality of the profile
+    detail::stream<const profile<T, 1>> slab_stream{_num_slab_hypercubes, _slab_stream.data()};
+    for (index_type hc_index = 0; hc_index < _num_slab_hypercubes; ++hc_index) {
+        _offsets_after_hcs.push_back(_hypercubes_length + slab_stream.offset_after(hc_index));
+    }
+
+    const auto *hypercubes = slab_stream.hypercube(0);
+    const auto hypercubes_length = static_cast<size_t>(slab_stream.border() - hypercubes);
+    if (hypercubes_length > 0) { _sink(_header_length + _hypercubes_length, hypercubes, hypercubes_length); }
+    _hypercubes_length += hypercubes_length;
+
+    // The compressed slab border is of no use for the array border, so its elements are packed again
+    switch (_size.dimensions()) {
+        case 1: break;  // a slab of a one-dimensional array is a single hypercube
+        case 2: append_slab_border<2>(slab); break;
+        case 3: append_slab_border<3>(slab); break;
+        default: abort();
+    }
+}
+
+template<typename T>
+template<dim_type Dims>
+void slab_stream_compressor<T>::append_slab_border(const value_type *slab) {
+    const auto slab_size = static_extent<Dims>{_slab_size};
+    const auto old_size = _border.size();
+    _border.resize(old_size + border_element_count(slab_size, _side_length));
+    pack_border(_border.data() + old_size, slab, slab_size, _side_length);
+}
+
+template<typename T>
+void slab_stream_compressor<T>::append_border(const value_type *elements, size_t count) {
+    const auto old_size = _border.size();
+    _border.resize(old_size + count);
+    memcpy(_border.data() + old_size, elements, count * sizeof(value_type));
+}
+
+template<typename T>
+void slab_stream_compressor<T>::write_rows(const value_type *rows, index_type num_rows) {
+    if (_finished) { throw std::runtime_error{"stream_compressor: write_rows() called after finish()"}; }
+    if (num_rows > _size[0] - _rows_written) {
+        throw std::runtime_error{"stream_compressor: " + std::to_string(_rows_written + num_rows)
+                + " rows written to an array of " + std::to_string(_size[0]) + " rows"};
+    }
+
+    while (num_rows > 0) {
+        if (_rows_written >= _hc_rows) {
+            // Rows past the last full row of hypercubes belong to the border in their entirety
+            append_border(rows, size_t{num_rows} * _row_length);
+            _rows_written += num_rows;
+            break;
+        }
+
+        index_type consumed;
+        if (_partial_slab_rows == 0 && num_rows >= _side_length) {
+            compress_slab(rows);
+            consumed = _side_length;
+        } else {
+            consumed = std::min(num_rows, _side_length - _partial_slab_rows);
+            _partial_slab.resize(size_t{_side_length} * _row_length);
+            memcpy(_partial_slab.data() + size_t{_partial_slab_rows} * _row_length, rows,
+                    size_t{consumed} * _row_length * sizeof(value_type));
+            _partial_slab_rows += consumed;
+            if (_partial_slab_rows == _side_length) {
+                compress_slab(_partial_slab.data());
+                _partial_slab_rows = 0;
+            }
+        }
+        rows += size_t{consumed} * _row_length;
+        num_rows -= consumed;
+        _rows_written += consumed;
+    }
+}
+
+template<typename T>
+size_t slab_stream_compressor<T>::finish() {
+    if (_finished) { throw std::runtime_error{"stream_compressor: finish() called twice"}; }
+    if (_rows_written != _size[0]) {
+        throw std::runtime_error{"stream_compressor: finish() called after " + std::to_string(_rows_written)
+                + " of " + std::to_string(_size[0]) + " rows"};
+    }
+    _finished = true;
+
+    const auto border_offset = _header_length + _hypercubes_length;
+    size_t border_length = 0;
+    if (!_border.empty()) {
+        if (_border.size() > std::numeric_limits<index_type>::max()) {
+            throw std::runtime_error{"stream_compressor: array border exceeds the 32-bit limit"};
+        }
+        if constexpr (stream_format_version < 2) {
+            // The border is stored verbatim, see has_border_stream
+            border_length = _border.size();
+            _sink(border_offset, _border.data(), border_length);
+        } else {
+            const auto border_size = extent{static_cast<index_type>(_border.size())};
+            std::vector<compressed_type> border_stream(compressed_length_bound<T>(border_size));
+            // pack_border stores value bits verbatim
+            border_length = _border_compressor->compress(
+                    reinterpret_cast<const value_type *>(_border.data()), border_size, border_stream.data());
+            _sink(border_offset, border_stream.data(), border_length);
+        }
+    }
+
+    if (_header_length > 0) {
+        std::vector<compressed_type> header(_header_length);
+        stream<profile<T, 1>> header_stream{_num_hypercubes, header.data()};
+        for (index_type hc_index = 0; hc_index < _num_hypercubes; ++hc_index) {
+            header_stream.set_offset_after(hc_index, _offsets_after_hcs[hc_index]);
+        }
+        _sink(0, header.data(), _header_length);
+    }
+
+    return border_offset + border_length;
+}
+
+}  // namespace ndzip::detail
+
+namespace ndzip {
+
+template<typename T>
+std::unique_ptr<stream_compressor<T>> make_stream_compressor(
+        const extent &data_size, typename stream_compressor<T>::sink_type sink, unsigned num_threads) {
+    return std::make_unique<detail::slab_stream_compressor<T>>(data_size, std::move(sink), num_threads);
+}
+
+#define NDZIP_INSTANTIATE_MAKE_STREAM_COMPRESSOR(T) \
+    template std::unique_ptr<stream_compressor<T>> make_stream_compressor<T>( \
+            const extent &, stream_compressor<T>::sink_type, unsigned);
+NDZIP_FOR_EACH_CPU_VALUE_TYPE(NDZIP_INSTANTIATE_MAKE_STREAM_COMPRESSOR)
+#undef NDZIP_INSTANTIATE_MAKE_STREAM_COMPRESSOR
+
+}  // namespace ndzip
@@ -757,10 +757,10 @@ class sycl_offloader final : public offloader<typename Profile::value_type> {
     constexpr static auto dimensions = Profile::dimensions;
 
   protected:
-    index_type do_compress(
+    size_t do_compress(
             const value_type *data, const extent &data_size, bits_type *stream, kernel_duration *duration) override;
 
-    index_type do_decompress(const bits_type *stream, index_type length, value_type *data, const extent &data_size,
+    size_t do_decompress(const bits_type *stream, size_t length, value_type *data, const extent &data_size,
             kernel_duration *duration) override;
 
   private:
@@ -787,15 +787,18 @@ class sycl_offloader final : public offloader<typename Profile::value_type> {
                     (unsigned long) device.get_info<sycl::info::device::local_mem_size>());
         }
     }
+
+    ~sycl_offloader() override { this->finish_async(); }
 };
 
 template<typename Profile>
-index_type sycl_offloader<Profile>::do_compress(
+size_t sycl_offloader<Profile>::do_compress(
         const value_type *data, const extent &data_size, bits_type *raw_stream, kernel_duration *out_kernel_duration) {
     using sam = sycl::access::mode;
 
     // TODO edge case w/ 0 hypercubes
 
+    gpu::check_gpu_array_size<Profile>(static_extent<dimensions>{data_size});
     const auto num_hypercubes = detail::num_hypercubes(data_size);
     if (verbose()) {
         printf("Have %u hypercubes\n", num_hypercubes);
@@ -852,10 +855,12 @@ index_type sycl_offloader<Profile>::do_compress(
 }
 
 template<typename Profile>
-index_type sycl_offloader<Profile>::do_decompress(const bits_type *raw_stream, index_type length, value_type *data,
+size_t sycl_offloader<Profile>::do_decompress(const bits_type *raw_stream, size_t length, value_type *data,
         const extent &data_size, kernel_duration *out_kernel_duration) {
     using sam = sycl::access::mode;
 
+    gpu::check_gpu_array_size<Profile>(static_extent<dimensions>{data_size});
+
     // TODO the range computation here is questionable at best
     sycl::buffer<bits_type> stream_buf{length};
     sycl::buffer<value_type, dimensions> data_buf{extent_cast<dimensions, sycl::range<dimensions>>(data_size)};
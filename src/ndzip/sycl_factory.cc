@@ -25,7 +25,7 @@ std::unique_ptr<ndzip::sycl_buffer_decompressor<T, Dims>> ndzip::make_sycl_buffe
 }
 
 template<typename T>
-std::unique_ptr<ndzip::offloader<T>> ndzip::make_sycl_offloader(dim_type dimensions, bool enable_profiling) {
+std::unique_ptr<ndzip::offloader<T>> ndzip::detail::make_sycl_offloader(dim_type dimensions, bool enable_profiling) {
     return detail::make_with_profile<offloader, detail::gpu_sycl::sycl_offloader, T>(
             dimensions, enable_profiling, detail::verbose());
 }
@@ -60,7 +60,7 @@ template std::unique_ptr<sycl_buffer_decompressor<double, 1>> make_sycl_buffer_d
 template std::unique_ptr<sycl_buffer_decompressor<double, 2>> make_sycl_buffer_decompressor<double, 2>(sycl::queue &);
 template std::unique_ptr<sycl_buffer_decompressor<double, 3>> make_sycl_buffer_decompressor<double, 3>(sycl::queue &);
 
-template std::unique_ptr<offloader<float>> make_sycl_offloader<float>(dim_type, bool);
-template std::unique_ptr<offloader<double>> make_sycl_offloader<double>(dim_type, bool);
+template std::unique_ptr<offloader<float>> detail::make_sycl_offloader<float>(dim_type, bool);
+template std::unique_ptr<offloader<double>> detail::make_sycl_offloader<double>(dim_type, bool);
 
 }  // namespace ndzip
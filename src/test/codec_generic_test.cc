@@ -1,10 +1,15 @@
 #include "test_utils.hh"
 
 #include <iostream>
+#include <thread>
 
 #include <ndzip/common.hh>
 #include <ndzip/cpu_codec.inl>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 
 using namespace ndzip;
 using namespace ndzip::detail;
@@ -62,13 +67,32 @@ TEMPLATE_TEST_CASE("CPU zero-word compaction is reversible", "[cpu]", uint32_t,
 }
 
 
-TEMPLATE_TEST_CASE("CPU bit transposition is reversible", "[cpu]", uint32_t, uint64_t) {
+TEST_CASE("CPU stream copy reproduces unaligned ranges of every length", "[cpu]") {
+    std::vector<std::byte> src(20000);
+    auto gen = std::minstd_rand();  // NOLINT(cert-msc51-cpp)
+    for (auto &b : src) {
+        b = static_cast<std::byte>(gen());
+    }
+
+    for (size_t n_bytes : {0, 1, 31, 4095, 4096, 4097, 12345, 19000}) {
+        for (size_t misalignment : {0, 4, 8, 17}) {
+            INFO("n_bytes = " << n_bytes << ", misalignment = " << misalignment);
+            std::vector<std::byte> dest(src.size() + misalignment + 1, std::byte{0xa5});
+            cpu::copy_to_stream(dest.data() + misalignment, src.data() + 3, n_bytes);
+            CHECK(std::equal(src.begin() + 3, src.begin() + 3 + n_bytes, dest.begin() + misalignment));
+            CHECK(dest[misalignment + n_bytes] == std::byte{0xa5});
+        }
+    }
+}
+
+
+TEMPLATE_TEST_CASE("CPU bit transposition is reversible", "[cpu]", uint8_t, uint16_t, uint32_t, uint64_t) {
     alignas(cpu::simd_width_bytes) TestType input[bits_of<TestType>];
     auto rng = std::minstd_rand(1);
-    auto bit_dist = std::uniform_int_distribution<TestType>();
+    auto bit_dist = std::uniform_int_distribution<uint64_t>();
     auto shift_dist = std::uniform_int_distribution<index_type>(0, bits_of<TestType> - 1);
     for (auto &value : input) {
-        value = bit_dist(rng) >> shift_dist(rng);
+        value = static_cast<TestType>(static_cast<TestType>(bit_dist(rng)) >> shift_dist(rng));
     }
 
     alignas(cpu::simd_width_bytes) TestType transposed[bits_of<TestType>];
@@ -81,7 +105,27 @@ TEMPLATE_TEST_CASE("CPU bit transposition is reversible", "[cpu]", uint32_t, uin
 }
 
 
-using border_slice = std::pair<index_type, index_type>;
+TEMPLATE_TEST_CASE("CPU bit transposition matches the trivial implementation", "[cpu]", uint8_t, uint16_t, uint32_t,
+        uint64_t) {
+    alignas(cpu::simd_width_bytes) TestType input[bits_of<TestType>];
+    auto rng = std::minstd_rand(1);
+    auto bit_dist = std::uniform_int_distribution<uint64_t>();
+    auto shift_dist = std::uniform_int_distribution<index_type>(0, bits_of<TestType> - 1);
+    for (auto &value : input) {
+        value = static_cast<TestType>(static_cast<TestType>(bit_dist(rng)) >> shift_dist(rng));
+    }
+
+    alignas(cpu::simd_width_bytes) TestType transposed[bits_of<TestType>];
+    cpu::transpose_bits(input, transposed);
+
+    alignas(cpu::simd_width_bytes) TestType reference[bits_of<TestType>];
+    cpu::transpose_bits_trivial(input, reference);
+
+    CHECK(memcmp(transposed, reference, sizeof reference) == 0);
+}
+
+
+using border_slice = std::pair<size_t, size_t>;
 using slice_vec = std::vector<border_slice>;
 
 namespace std {
@@ -94,7 +138,7 @@ template<dim_type Dims>
 static auto dump_border_slices(const static_extent<Dims> &size, index_type side_length) {
     slice_vec v;
     for_each_border_slice(
-            size, side_length, [&](index_type offset, index_type count) { v.emplace_back(offset, count); });
+            size, side_length, [&](size_t offset, size_t count) { v.emplace_back(offset, count); });
     return v;
 }
 
@@ -111,6 +155,56 @@ TEST_CASE("for_each_border_slice iterates correctly") {
 }
 
 
+TEST_CASE("border_slices splits the border at arbitrary element boundaries") {
+    const auto size = static_extent<3>{9, 10, 11};
+    const index_type side_length = 4;
+    const border_slices<3> slices{size, side_length};
+    REQUIRE(slices.num_elements() == border_element_count(size, side_length));
+
+    std::vector<size_t> expected_offsets;
+    for_each_border_slice(size, side_length, [&](size_t offset, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            expected_offsets.push_back(offset + i);
+        }
+    });
+
+    for (size_t num_shares : {1, 2, 7, 100}) {
+        INFO("num_shares = " << num_shares);
+        std::vector<size_t> offsets(slices.num_elements(), SIZE_MAX);
+        for (size_t share = 0; share < num_shares; ++share) {
+            slices.for_each_in_range(slices.num_elements() * share / num_shares,
+                    slices.num_elements() * (share + 1) / num_shares,
+                    [&](size_t array_offset, size_t border_offset, size_t count) {
+                        for (size_t i = 0; i < count; ++i) {
+                            offsets[border_offset + i] = array_offset + i;
+                        }
+                    });
+        }
+        CHECK(offsets == expected_offsets);
+    }
+}
+
+
+#if NDZIP_OPENMP_SUPPORT
+TEST_CASE("multi-threaded codecs pack and unpack large borders in parallel", "[encoder][de][border][omp]") {
+    // 80856 border elements, enough for parallel_border_copy to split them among threads
+    const auto size = extent{70, 70, 70};
+    const auto input_data = make_random_vector<float>(num_elements(size));
+
+    std::vector<uint32_t> serial_stream(compressed_length_bound<float>(size));
+    serial_stream.resize(make_compressor<float>(3, 1)->compress(input_data.data(), size, serial_stream.data()));
+
+    std::vector<uint32_t> parallel_stream(compressed_length_bound<float>(size));
+    parallel_stream.resize(make_compressor<float>(3, 4)->compress(input_data.data(), size, parallel_stream.data()));
+    CHECK_FOR_VECTOR_EQUALITY(parallel_stream, serial_stream);
+
+    std::vector<float> output_data(input_data.size());
+    make_decompressor<float>(3, 4)->decompress(serial_stream.data(), output_data.data(), size);
+    CHECK_FOR_VECTOR_EQUALITY(output_data, input_data);
+}
+#endif
+
+
 TEMPLATE_TEST_CASE("file produces a sane hypercube / header layout", "[file]", (std::integral_constant<dim_type, 1>),
         (std::integral_constant<dim_type, 2>), (std::integral_constant<dim_type, 3>) ) {
     constexpr dim_type dims = TestType::value;
@@ -155,3 +249,536 @@ TEMPLATE_TEST_CASE("file produces a sane hypercube / header layout", "[file]", (
     // CHECK(f.file_header_length() == f.num_hypercubes() * sizeof(index_type));
     CHECK(num_hypercubes(size) == ipow(n_hypercubes_per_dim, dims));
 }
+
+
+TEST_CASE("stream_compressor rejects an incorrect number of rows", "[encoder][stream]") {
+    const auto size = extent{40, 70};
+    const auto sink = [](size_t, const uint32_t *, size_t) {};
+    const std::vector<float> rows(num_elements(size));
+
+    const auto incomplete = make_stream_compressor<float>(size, sink, 1);
+    incomplete->write_rows(rows.data(), 39);
+    CHECK_THROWS(incomplete->finish());
+
+    const auto excess = make_stream_compressor<float>(size, sink, 1);
+    excess->write_rows(rows.data(), 39);
+    CHECK_THROWS(excess->write_rows(rows.data(), 2));
+}
+
+
+TEMPLATE_TEST_CASE("stream header entries widen to 64 bits beyond 2^32 compressed words", "[stream]", float, double) {
+    using profile = detail::profile<TestType, 2>;
+    using bits_type = typename profile::bits_type;
+
+    const auto max_narrow_hypercubes = static_cast<index_type>(
+            uint64_t{std::numeric_limits<index_type>::max()} / profile::compressed_block_length_bound);
+    CHECK(!stream<profile>::needs_wide_offsets(max_narrow_hypercubes));
+    CHECK(stream<profile>::needs_wide_offsets(max_narrow_hypercubes + 1));
+    CHECK(stream<profile>::header_length(max_narrow_hypercubes)
+            == div_ceil(size_t{max_narrow_hypercubes} * sizeof(uint32_t), sizeof(bits_type)));
+
+    // 1024 x 1024 hypercubes, no border
+    const auto size = extent{1024 * profile::hypercube_side_length, 1024 * profile::hypercube_side_length};
+    const index_type num_hcs = 1024 * 1024;
+    const auto hcs_bound = size_t{num_hcs} * profile::compressed_block_length_bound;
+    CHECK(hcs_bound > std::numeric_limits<index_type>::max());
+    CHECK(compressed_length_bound<TestType>(size) == num_hcs * sizeof(uint64_t) / sizeof(bits_type) + hcs_bound);
+
+    std::vector<bits_type> header(stream<profile>::header_length(num_hcs));
+    stream<profile> out{num_hcs, header.data()};
+    REQUIRE(out.wide_offsets);
+    for (index_type hc_index = 0; hc_index < num_hcs; ++hc_index) {
+        out.set_offset_after(hc_index, size_t{hc_index + 1} * profile::compressed_block_length_bound);
+    }
+
+    stream<const profile> in{num_hcs, header.data()};
+    CHECK(in.offset_after(num_hcs - 1) == hcs_bound);
+    CHECK(in.hypercube_size(0) == profile::compressed_block_length_bound);
+    CHECK(in.hypercube_size(num_hcs - 1) == profile::compressed_block_length_bound);
+}
+
+
+#if defined(__linux__)
+
+// Anonymous memory that is only backed by physical pages once written, so that mostly-zero arrays beyond 2^32 elements
+// fit into a test
+template<typename T>
+class sparse_buffer {
+  public:
+    explicit sparse_buffer(size_t size) : _bytes(size * sizeof(T)) {
+        _memory = mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (_memory == MAP_FAILED) { throw std::bad_alloc{}; }
+    }
+
+    sparse_buffer(const sparse_buffer &) = delete;
+    sparse_buffer &operator=(const sparse_buffer &) = delete;
+
+    ~sparse_buffer() { munmap(_memory, _bytes); }
+
+    T *data() { return static_cast<T *>(_memory); }
+
+  private:
+    void *_memory;
+    size_t _bytes;
+};
+
+TEST_CASE("arrays whose hypercubes exceed 2^32 words round-trip with 64-bit header entries", "[encoder][de][stream]") {
+    using profile = detail::profile<uint8_t, 2>;
+    constexpr auto side_length = profile::hypercube_side_length;
+
+    // The smallest square grid of 8-bit hypercubes that needs wide offsets, and a border
+    const index_type num_hcs = 1024 * 1024;
+    const auto size = extent{1024 * side_length + 3, 1024 * side_length + 5};
+    REQUIRE(stream<profile>::needs_wide_offsets(num_hcs));
+    REQUIRE(num_elements(size) > std::numeric_limits<index_type>::max());
+
+    // Random boxes covering the first hypercube, hypercubes in the middle of the grid, and the last hypercube together
+    // with the border corner, everything else is zero. The last box is all zero.
+    const extent boxes[][2] = {
+            {{0, 0}, {side_length, side_length}},
+            {{512 * side_length + 10, 300 * side_length + 20}, {100, 90}},
+            {{1023 * side_length, 1023 * side_length}, {side_length + 3, side_length + 5}},
+            {{700 * side_length, 5}, {side_length, 2 * side_length}},
+    };
+    sparse_buffer<uint8_t> data(num_elements(size));
+    auto gen = std::minstd_rand();
+    std::uniform_int_distribution<unsigned> dist(0, 255);
+    for (size_t b = 0; b + 1 < std::size(boxes); ++b) {
+        const auto &[offset, box] = boxes[b];
+        for (index_type i = 0; i < box[0]; ++i) {
+            for (index_type j = 0; j < box[1]; ++j) {
+                data.data()[linear_index(size, extent{offset[0] + i, offset[1] + j})]
+                        = static_cast<uint8_t>(dist(gen));
+            }
+        }
+    }
+
+    sparse_buffer<uint8_t> compressed(compressed_length_bound<uint8_t>(size));
+    const auto length = make_compressor<uint8_t>(2, 1)->compress(data.data(), size, compressed.data());
+    CHECK(length > stream<profile>::header_length(num_hcs));
+    CHECK(stream<profile>::header_length(num_hcs) == num_hcs * sizeof(uint64_t));
+
+    stream<const profile> in{num_hcs, compressed.data()};
+    REQUIRE(in.wide_offsets);
+#if NDZIP_STREAM_FORMAT_VERSION >= 3
+    // Constant hypercubes are a single word, hypercubes of random bytes do not compress
+    CHECK(in.hypercube_size(0) == profile::compressed_block_length_bound);
+    CHECK(in.hypercube_size(1) == 1);
+    CHECK(in.hypercube_size(num_hcs - 1) == profile::compressed_block_length_bound);
+#else
+    // Zero hypercubes are one all-zero head word per group of 8 elements
+    CHECK(in.hypercube_size(1) == ipow(side_length, 2) / bits_of<uint8_t>);
+#endif
+
+    const auto decompressor = make_decompressor<uint8_t>(2, 1);
+    for (const auto &[offset, box] : boxes) {
+        CAPTURE(offset[0], offset[1]);
+        std::vector<uint8_t> expected(num_elements(box));
+        for (index_type i = 0; i < box[0]; ++i) {
+            for (index_type j = 0; j < box[1]; ++j) {
+                expected[i * box[1] + j] = data.data()[linear_index(size, extent{offset[0] + i, offset[1] + j})];
+            }
+        }
+        std::vector<uint8_t> region(expected.size());
+        decompressor->decompress_region(compressed.data(), size, offset, box, region.data());
+        CHECK_FOR_VECTOR_EQUALITY(region, expected);
+    }
+}
+
+#endif
+
+
+TEMPLATE_TEST_CASE("mantissa truncation honors its error bound", "[lossy]", float, double) {
+    using bits_type = detail::bits_type<TestType>;
+    const auto truncate = [](const mantissa_truncation<TestType> &truncation, TestType x) {
+        return bit_cast<TestType>(truncation(bit_cast<bits_type>(x)).bits);
+    };
+    // The largest value the compressor may choose for the free bits
+    const auto truncate_up = [](const mantissa_truncation<TestType> &truncation, TestType x) {
+        const auto [bits, free_bits] = truncation(bit_cast<bits_type>(x));
+        return bit_cast<TestType>(static_cast<bits_type>(bits | ((bits_type{1} << free_bits) - 1)));
+    };
+
+    CHECK(mantissa_truncation<TestType>{}.is_lossless());
+    CHECK(mantissa_truncation<TestType>{lossy_precision::mantissa_bits(64)}.is_lossless());
+    CHECK(mantissa_truncation<TestType>{lossy_precision::absolute_error(0)}.is_lossless());
+
+    const mantissa_truncation<TestType> one_bit{lossy_precision::mantissa_bits(1)};
+    CHECK(truncate(one_bit, TestType{1.9}) == TestType{1.5});
+    CHECK(truncate(one_bit, TestType{-3.3}) == TestType{-3});
+
+    const TestType bound = 0.01;
+    const mantissa_truncation<TestType> bounded{lossy_precision::absolute_error(bound)};
+    for (TestType x : {TestType{0}, TestType{0.004}, TestType{-0.004}, TestType{-0.0123}, TestType{0.7},
+                 TestType{-1234.5678}, std::numeric_limits<TestType>::denorm_min(),
+                 std::numeric_limits<TestType>::max()}) {
+        CAPTURE(x);
+        CHECK(std::abs(truncate(bounded, x) - x) <= bound);
+        CHECK(std::abs(truncate_up(bounded, x) - x) <= bound);
+    }
+    CHECK(truncate(bounded, TestType{0.004}) == 0);
+    // Values below the bound keep their sign, so that any subnormal the compressor chooses errs by less than the bound
+    CHECK(std::signbit(truncate(bounded, TestType{-0.004})));
+    CHECK(std::signbit(truncate_up(bounded, TestType{-0.004})));
+    // Values whose unit in the last place exceeds the bound are kept as they are
+    CHECK(truncate(bounded, std::numeric_limits<TestType>::max()) == std::numeric_limits<TestType>::max());
+
+    for (const auto &truncation : {one_bit, bounded}) {
+        CHECK(std::isinf(truncate(truncation, std::numeric_limits<TestType>::infinity())));
+        // A NaN with only low payload bits set would otherwise turn into infinity
+        const auto nan = bit_cast<TestType>(bit_cast<bits_type>(std::numeric_limits<TestType>::infinity()) | 1);
+        CHECK(std::isnan(truncate(truncation, nan)));
+    }
+}
+
+
+TEMPLATE_TEST_CASE("CPU codecs reproduce arrays of 8-, 16- and 32-bit elements", "[encoder][de][types]", float16,
+        bfloat16, int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t) {
+    using value_type = TestType;
+    using bits_type = ndzip::compressed_type<value_type>;
+
+    for (dim_type dims = 1; dims <= 3; ++dims) {
+        INFO("dims = " << dims);
+        const auto side_length = dims == 1 ? hypercube_side_length<1>
+                : dims == 2                ? hypercube_side_length<2>
+                                           : hypercube_side_length<3>;
+        const auto size = extent::broadcast(dims, side_length * 2 + 3);
+        const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+        const auto isas = cpu::supported_isas();
+        REQUIRE(!isas.empty());
+        std::vector<bits_type> reference_stream(ndzip::compressed_length_bound<value_type>(size));
+        reference_stream.resize(cpu::make_compressor<value_type>(isas.back(), dims, 1, thread_placement::any)
+                                        ->compress(input_data.data(), size, reference_stream.data()));
+
+        for (auto isa : isas) {
+            INFO("isa = " << cpu::to_string(isa));
+            for (unsigned num_threads : {1u, 3u}) {
+#if !NDZIP_OPENMP_SUPPORT
+                if (num_threads > 1) { continue; }
+#endif
+                INFO("num_threads = " << num_threads);
+                std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+                stream.resize(cpu::make_compressor<value_type>(isa, dims, num_threads, thread_placement::any)
+                                      ->compress(input_data.data(), size, stream.data()));
+                CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+
+                std::vector<value_type> output_data(input_data.size());
+                cpu::make_decompressor<value_type>(isa, dims, num_threads, thread_placement::any)
+                        ->decompress(reference_stream.data(), output_data.data(), size);
+                CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+            }
+        }
+    }
+}
+
+
+TEMPLATE_TEST_CASE("signed integer arrays share the codec of their unsigned type", "[encoder][types]", int8_t, int16_t,
+        int32_t) {
+    using value_type = TestType;
+    using unsigned_type = std::make_unsigned_t<value_type>;
+
+    // A slope through zero, whose two's complement differences are all one
+    const auto size = extent{4 * hypercube_side_length<2>, hypercube_side_length<2>};
+    std::vector<value_type> input_data(num_elements(size));
+    for (size_t i = 0; i < input_data.size(); ++i) {
+        input_data[i] = static_cast<value_type>(static_cast<int>(i % hypercube_side_length<2>) - 32);
+    }
+
+    std::vector<ndzip::compressed_type<value_type>> stream(ndzip::compressed_length_bound<value_type>(size));
+    stream.resize(make_compressor<value_type>(2, 1)->compress(input_data.data(), size, stream.data()));
+    CHECK(stream.size() * 2 < input_data.size());
+
+    // The signed codec is the unsigned one applied to the same bits
+    std::vector<ndzip::compressed_type<value_type>> unsigned_stream(stream.size());
+    make_compressor<unsigned_type>(2, 1)->compress(
+            reinterpret_cast<const unsigned_type *>(input_data.data()), size, unsigned_stream.data());
+    CHECK(unsigned_stream == stream);
+
+    std::vector<value_type> output_data(input_data.size());
+    make_decompressor<value_type>(2, 1)->decompress(stream.data(), output_data.data(), size);
+    CHECK(output_data == input_data);
+
+    CHECK_THROWS(make_compressor<value_type>(2, 1, thread_placement::any, lossy_precision::mantissa_bits(4)));
+}
+
+
+TEMPLATE_TEST_CASE("hypercube summaries select the hypercubes a range query decompresses", "[encoder][de][summary]",
+        float, double, int16_t, int32_t) {
+    using value_type = TestType;
+    constexpr auto side_length = hypercube_side_length<2>;
+
+    // A ramp from -24 to 16 whose hypercubes cover different ranges of values
+    const auto size = extent{2 * side_length + 7, 3 * side_length + 5};
+    std::vector<value_type> input_data(num_elements(size));
+    for (index_type x = 0; x < size[0]; ++x) {
+        for (index_type y = 0; y < size[1]; ++y) {
+            input_data[x * size[1] + y] = static_cast<value_type>(static_cast<int>(x / 8) - static_cast<int>(y / 8));
+        }
+    }
+
+    const auto num_hcs = hypercube_count(size);
+    REQUIRE(num_hcs == 6);
+    std::vector<hypercube_summary<value_type>> reference_summaries(num_hcs);
+    summarize_hypercubes(input_data.data(), size, reference_summaries.data());
+    CHECK(reference_summaries[0].min == static_cast<value_type>(-7));
+    CHECK(reference_summaries[0].max == static_cast<value_type>(7));
+    CHECK(reference_summaries[2].min == static_cast<value_type>(-23));
+    CHECK(reference_summaries[5].max == static_cast<value_type>(-1));
+
+    const auto lower = static_cast<value_type>(-20), upper = static_cast<value_type>(-10);
+    const auto hc_indices = hypercubes_in_range(reference_summaries.data(), num_hcs, lower, upper);
+    CHECK(hc_indices == std::vector<index_type>{1, 2, 5});
+
+    for (unsigned num_threads : {1u, 3u}) {
+#if !NDZIP_OPENMP_SUPPORT
+        if (num_threads > 1) { continue; }
+#endif
+        INFO("num_threads = " << num_threads);
+        std::vector<compressed_type<value_type>> stream(ndzip::compressed_length_bound<value_type>(size));
+        std::vector<hypercube_summary<value_type>> summaries(num_hcs);
+        stream.resize(make_compressor<value_type>(2, num_threads)
+                              ->compress_summarized(input_data.data(), size, stream.data(), summaries.data()));
+        for (index_type i = 0; i < num_hcs; ++i) {
+            CHECK(summaries[i].min == reference_summaries[i].min);
+            CHECK(summaries[i].max == reference_summaries[i].max);
+        }
+
+        // Elements of skipped hypercubes keep their previous value, everything else is decompressed
+        const auto untouched = static_cast<value_type>(99);
+        std::vector<value_type> output_data(input_data.size(), untouched);
+        make_decompressor<value_type>(2, num_threads)
+                ->decompress_hypercubes(stream.data(), output_data.data(), size, hc_indices.data(),
+                        static_cast<index_type>(hc_indices.size()));
+        for (index_type x = 0; x < size[0]; ++x) {
+            for (index_type y = 0; y < size[1]; ++y) {
+                const auto in_border = x >= 2 * side_length || y >= 3 * side_length;
+                const auto hc_index = x / side_length * 3 + y / side_length;
+                const auto decoded = in_border
+                        || std::find(hc_indices.begin(), hc_indices.end(), hc_index) != hc_indices.end();
+                const auto i = x * size[1] + y;
+                CHECK(output_data[i] == (decoded ? input_data[i] : untouched));
+            }
+        }
+
+        const index_type out_of_range[] = {1, num_hcs};
+        CHECK_THROWS_AS(make_decompressor<value_type>(2, num_threads)
+                                ->decompress_hypercubes(stream.data(), output_data.data(), size, out_of_range, 2),
+                std::runtime_error);
+    }
+}
+
+
+TEST_CASE("hypercube summaries leave out NaNs and order half-precision values", "[summary]") {
+    const auto size = extent{2 * hypercube_side_length<1>};
+    std::vector<float> data(num_elements(size), std::numeric_limits<float>::quiet_NaN());
+    data[0] = -2.f;
+    data[1] = 5.f;
+    std::vector<hypercube_summary<float>> summaries(2);
+    summarize_hypercubes(data.data(), size, summaries.data());
+    CHECK(summaries[0].min == -2.f);
+    CHECK(summaries[0].max == 5.f);
+    CHECK(hypercubes_in_range(summaries.data(), 2, -std::numeric_limits<float>::infinity(),
+                  std::numeric_limits<float>::infinity())
+            == std::vector<index_type>{0});
+    CHECK(hypercubes_in_range(summaries.data(), 2, 0.f, std::numeric_limits<float>::quiet_NaN()).empty());
+
+    // -1 to 2 in binary16
+    const hypercube_summary<float16> half_summary{float16{0xbc00}, float16{0x4000}};
+    CHECK(hypercubes_in_range(&half_summary, 1, float16{0x3e00}, float16{0x4200}).size() == 1);  // 1.5 to 3
+    CHECK(hypercubes_in_range(&half_summary, 1, float16{0xc200}, float16{0xc000}).empty());  // -3 to -2
+}
+
+
+TEMPLATE_TEST_CASE("CPU codecs reproduce arrays with every hypercube size", "[encoder][de][hypercube-size]", float,
+        double) {
+    using value_type = TestType;
+    using bits_type = ndzip::compressed_type<value_type>;
+
+    for (auto hc_size : {hypercube_size::smaller, hypercube_size::standard, hypercube_size::larger}) {
+        for (dim_type dims = 1; dims <= 3; ++dims) {
+            INFO("hypercube size = " << static_cast<int>(hc_size) << ", dims = " << dims);
+            const auto side_length = hypercube_side_length_for(dims, hc_size);
+            const auto size = extent::broadcast(dims, side_length * 2 + 3);
+            const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+            const auto isas = cpu::supported_isas();
+            REQUIRE(!isas.empty());
+            const auto bound = ndzip::compressed_length_bound<value_type>(size, hc_size);
+            std::vector<bits_type> reference_stream(bound);
+            reference_stream.resize(
+                    cpu::make_compressor<value_type>(isas.back(), dims, 1, thread_placement::any, {}, hc_size)
+                            ->compress(input_data.data(), size, reference_stream.data()));
+            CHECK(reference_stream.size() <= bound);
+
+            for (auto isa : isas) {
+                INFO("isa = " << cpu::to_string(isa));
+                for (unsigned num_threads : {1u, 3u}) {
+#if !NDZIP_OPENMP_SUPPORT
+                    if (num_threads > 1) { continue; }
+#endif
+                    INFO("num_threads = " << num_threads);
+                    std::vector<bits_type> stream(bound);
+                    stream.resize(cpu::make_compressor<value_type>(
+                            isa, dims, num_threads, thread_placement::any, {}, hc_size)
+                                          ->compress(input_data.data(), size, stream.data()));
+                    CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+
+                    std::vector<value_type> output_data(input_data.size());
+                    cpu::make_decompressor<value_type>(isa, dims, num_threads, thread_placement::any, hc_size)
+                            ->decompress(reference_stream.data(), output_data.data(), size);
+                    CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+                }
+            }
+        }
+    }
+
+    CHECK_THROWS(make_compressor<uint16_t>(2, 1, thread_placement::any, {}, hypercube_size::larger));
+}
+
+
+TEMPLATE_TEST_CASE("CPU codecs on a scratch arena produce the same streams as codecs that allocate",
+        "[encoder][de][scratch]", float, int16_t) {
+    using value_type = TestType;
+    using bits_type = ndzip::compressed_type<value_type>;
+
+    for (dim_type dims = 1; dims <= 3; ++dims) {
+        const auto side_length = hypercube_side_length_for(dims, hypercube_size::standard);
+        const auto large_size = extent::broadcast(dims, side_length * 2 + 3);
+        const auto small_size = extent::broadcast(dims, side_length + 1);
+        const compressor_requirements req{large_size, small_size};
+
+        for (unsigned num_threads : {1u, 3u}) {
+#if !NDZIP_OPENMP_SUPPORT
+            if (num_threads > 1) { continue; }
+#endif
+            for (auto placement : {thread_placement::any, thread_placement::numa}) {
+                INFO("dims = " << dims << ", num_threads = " << num_threads
+                               << ", placement = " << static_cast<int>(placement));
+                const auto bytes = required_scratch_bytes<value_type>(req, num_threads, placement);
+                // Both codecs share the arena, which does not begin at an aligned address
+                std::vector<std::byte> memory(2 * bytes + 1);
+                scratch_arena arena{memory.data() + 1, 2 * bytes};
+                auto compressor = make_compressor<value_type>(req, arena, num_threads, placement);
+                CHECK(arena.used() <= bytes);
+                auto decompressor = make_decompressor<value_type>(req, arena, num_threads, placement);
+                CHECK(arena.used() <= 2 * bytes);
+
+                for (auto &size : {large_size, small_size, large_size}) {
+                    const auto input_data = make_random_vector<value_type>(num_elements(size));
+                    std::vector<bits_type> reference_stream(compressed_length_bound<value_type>(size));
+                    reference_stream.resize(make_compressor<value_type>(dims, num_threads, placement)
+                                                    ->compress(input_data.data(), size, reference_stream.data()));
+
+                    std::vector<bits_type> stream(compressed_length_bound<value_type>(size));
+                    stream.resize(compressor->compress(input_data.data(), size, stream.data()));
+                    CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+
+                    std::vector<value_type> output_data(input_data.size());
+                    decompressor->decompress(stream.data(), output_data.data(), size);
+                    CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+                }
+
+                // Arrays with a larger border than the requirements allow for do not fit into the arena, which only holds
+                // the border where it is compressed as a one-dimensional array of its own, see has_border_stream
+                if (dims > 1 && NDZIP_STREAM_FORMAT_VERSION >= 2) {
+                    const auto oversized = extent::broadcast(dims, side_length * 2 + 5);
+                    const auto input_data = make_random_vector<value_type>(num_elements(oversized));
+                    std::vector<bits_type> stream(compressed_length_bound<value_type>(oversized));
+                    CHECK_THROWS_AS(compressor->compress(input_data.data(), oversized, stream.data()),
+                            std::length_error);
+                }
+
+                scratch_arena too_small{memory.data(), bytes / 2};
+                CHECK_THROWS_AS(make_compressor<value_type>(req, too_small, num_threads, placement), std::bad_alloc);
+            }
+        }
+    }
+}
+
+
+TEST_CASE("stage_timer only reads the clock when enabled", "[cpu][profile]") {
+    using namespace std::chrono_literals;
+    using cpu::codec_stage;
+    using cpu::stage_timer;
+
+    stage_timer disabled;
+    std::this_thread::sleep_for(1ms);
+    disabled.lap(codec_stage::block_transform);
+    CHECK(!disabled.enabled());
+    CHECK(disabled.total() == kernel_duration{});
+
+    stage_timer enabled{true};
+    std::this_thread::sleep_for(1ms);
+    enabled.lap(codec_stage::block_transform);
+    enabled.lap(codec_stage::border);
+    CHECK(enabled[codec_stage::block_transform] >= 1ms);
+    CHECK(enabled[codec_stage::hypercube_memory] == kernel_duration{});
+    CHECK(enabled.total() == enabled[codec_stage::block_transform] + enabled[codec_stage::border]);
+
+    enabled += enabled;
+    CHECK(enabled[codec_stage::block_transform] >= 2ms);
+}
+
+
+TEST_CASE("CPU offloader reports the duration of a call", "[cpu][profile]") {
+    const auto size = extent{300, 200};
+    const auto data = make_random_vector<float>(num_elements(size));
+    const auto offloader = make_cpu_offloader<float>(size.dimensions(), 1);
+
+    std::vector<uint32_t> stream(compressed_length_bound<float>(size));
+    kernel_duration compress_duration{};
+    const auto stream_length = offloader->compress(data.data(), size, stream.data(), &compress_duration);
+    CHECK(compress_duration > kernel_duration{});
+
+    std::vector<float> decompressed(num_elements(size));
+    kernel_duration decompress_duration{};
+    offloader->decompress(stream.data(), stream_length, decompressed.data(), size, &decompress_duration);
+    CHECK(decompress_duration > kernel_duration{});
+    CHECK(decompressed == data);
+
+    const auto region_offset = extent{70, 10};
+    const auto region_size = extent{100, 150};
+    std::vector<float> region(num_elements(region_size));
+    kernel_duration region_duration{};
+    offloader->decompress_region(
+            stream.data(), stream_length, size, region_offset, region_size, region.data(), &region_duration);
+    CHECK(region_duration > kernel_duration{});
+    CHECK(region[0] == data[linear_index(size, region_offset)]);
+}
+
+
+TEST_CASE("asynchronous offloader calls complete in submission order", "[cpu][async]") {
+    const auto size = extent{300, 200};
+    const auto offloader = make_cpu_offloader<float>(size.dimensions());
+
+    constexpr size_t num_arrays = 4;
+    std::vector<std::vector<float>> data;
+    std::vector<std::vector<uint32_t>> streams;
+    std::vector<std::future<size_t>> compressed;
+    for (size_t i = 0; i < num_arrays; ++i) {
+        data.push_back(make_random_vector<float>(num_elements(size)));
+        streams.emplace_back(compressed_length_bound<float>(size));
+    }
+    for (size_t i = 0; i < num_arrays; ++i) {
+        compressed.push_back(offloader->compress_async(data[i].data(), size, streams[i].data()));
+    }
+
+    // Decompressions are queued behind the remaining compressions as soon as their stream is ready
+    std::vector<size_t> stream_lengths;
+    std::vector<std::vector<float>> decompressed(num_arrays, std::vector<float>(num_elements(size)));
+    std::vector<std::future<size_t>> decompressed_lengths;
+    for (size_t i = 0; i < num_arrays; ++i) {
+        stream_lengths.push_back(compressed[i].get());
+        decompressed_lengths.push_back(
+                offloader->decompress_async(streams[i].data(), stream_lengths[i], decompressed[i].data(), size));
+    }
+    for (size_t i = 0; i < num_arrays; ++i) {
+        CHECK(decompressed_lengths[i].get() == stream_lengths[i]);
+        CHECK(decompressed[i] == data[i]);
+    }
+
+    // Errors surface through the future, and synchronous calls still work afterwards
+    CHECK_THROWS(offloader->compress_async(data[0].data(), extent{300}, streams[0].data()).get());
+    CHECK(offloader->compress(data[0].data(), size, streams[0].data()) == stream_lengths[0]);
+}
@@ -34,6 +34,25 @@ TEMPLATE_TEST_CASE("block transform is reversible", "[profile]", ALL_PROFILES) {
 }
 
 
+TEMPLATE_TEST_CASE("CPU block transform matches the portable implementation", "[profile][cpu]", ALL_PROFILES) {
+    using bits_type = typename TestType::bits_type;
+
+    constexpr auto hc_size = ipow(TestType::hypercube_side_length, TestType::dimensions);
+    const auto input = make_random_vector<bits_type>(hc_size);
+
+    detail::cpu::simd_aligned_buffer<bits_type> transformed(hc_size);
+    std::copy(input.begin(), input.end(), transformed.data());
+    detail::cpu::block_transform<TestType>(transformed.data());
+
+    auto reference = input;
+    detail::block_transform(reference.data(), TestType::dimensions, TestType::hypercube_side_length);
+    CHECK(std::equal(reference.begin(), reference.end(), transformed.data()));
+
+    detail::cpu::inverse_block_transform<TestType>(transformed.data());
+    CHECK(std::equal(input.begin(), input.end(), transformed.data()));
+}
+
+
 TEMPLATE_TEST_CASE("decode(encode(input)) reproduces the input", "[encoder][de]", ALL_PROFILES) {
     using profile = TestType;
     using value_type = typename profile::value_type;
@@ -96,6 +115,506 @@ TEMPLATE_TEST_CASE("decode(encode(input)) reproduces the input", "[encoder][de]"
 }
 
 
+TEMPLATE_TEST_CASE("Offloaders can be reused across arrays of different sizes", "[encoder][de]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+
+    auto test_offloader = [&](auto &&offloader) {
+        for (index_type n : {side_length * 2 + 1, side_length * 3 - 1, side_length - 1, side_length * 2 + 1}) {
+            const auto size = extent::broadcast(dims, n);
+            const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+            std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+            stream.resize(offloader.compress(input_data.data(), size, stream.data()));
+
+            std::vector<value_type> output_data(input_data.size());
+            CHECK(offloader.decompress(stream.data(), stream.size(), output_data.data(), size) == stream.size());
+            CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+        }
+    };
+
+    SECTION("serial CPU") { test_offloader(*make_cpu_offloader<value_type>(dims, 1)); }
+
+#if NDZIP_OPENMP_SUPPORT
+    SECTION("OpenMP CPU", "[omp]") { test_offloader(*make_cpu_offloader<value_type>(dims)); }
+#endif
+
+#if NDZIP_HIPSYCL_SUPPORT
+    SECTION("SYCL", "[sycl]") { test_offloader(*make_sycl_offloader<value_type>(dims)); }
+#endif
+
+#if NDZIP_CUDA_SUPPORT
+    SECTION("CUDA", "[cuda]") { test_offloader(*make_cuda_offloader<value_type>(dims)); }
+#endif
+}
+
+
+TEMPLATE_TEST_CASE("All CPU ISA levels produce and decode the same stream", "[encoder][de][isa]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    const auto size = extent::broadcast(dims, profile::hypercube_side_length * 2 + 3);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+    const auto isas = detail::cpu::supported_isas();
+    REQUIRE(!isas.empty());
+
+    std::vector<bits_type> reference_stream(ndzip::compressed_length_bound<value_type>(size));
+    reference_stream.resize(detail::cpu::make_compressor<value_type>(isas.back(), dims, 1, thread_placement::any)
+                                    ->compress(input_data.data(), size, reference_stream.data()));
+
+    for (auto isa : isas) {
+        INFO("isa = " << detail::cpu::to_string(isa));
+        for (unsigned num_threads : {1u, 3u}) {
+#if !NDZIP_OPENMP_SUPPORT
+            if (num_threads > 1) { continue; }
+#endif
+            INFO("num_threads = " << num_threads);
+            std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+            stream.resize(detail::cpu::make_compressor<value_type>(isa, dims, num_threads, thread_placement::any)
+                                  ->compress(input_data.data(), size, stream.data()));
+            CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+
+            std::vector<value_type> output_data(input_data.size());
+            detail::cpu::make_decompressor<value_type>(isa, dims, num_threads, thread_placement::any)
+                    ->decompress(reference_stream.data(), output_data.data(), size);
+            CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+        }
+    }
+}
+
+
+#if NDZIP_OPENMP_SUPPORT
+TEMPLATE_TEST_CASE("NUMA thread placement produces and decodes the same stream", "[encoder][de][omp][numa]",
+        ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    const auto size = extent::broadcast(dims, profile::hypercube_side_length * 2 + 3);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+    std::vector<bits_type> reference_stream(ndzip::compressed_length_bound<value_type>(size));
+    reference_stream.resize(make_compressor<value_type>(dims, 1)->compress(
+            input_data.data(), size, reference_stream.data()));
+
+    // More threads than hypercubes leaves some threads with an empty range
+    for (unsigned num_threads : {2u, 3u, 16u}) {
+        INFO("num_threads = " << num_threads);
+        const auto compressor = make_compressor<value_type>(dims, num_threads, thread_placement::numa);
+        const auto decompressor = make_decompressor<value_type>(dims, num_threads, thread_placement::numa);
+
+        // Compress twice to exercise re-use of the thread-local scratch streams
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+            stream.resize(compressor->compress(input_data.data(), size, stream.data()));
+            CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+        }
+
+        std::vector<value_type> output_data(input_data.size());
+        decompressor->decompress(reference_stream.data(), output_data.data(), size);
+        CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+    }
+}
+#endif
+
+#if NDZIP_STREAM_FORMAT_VERSION >= 2
+TEMPLATE_TEST_CASE("borders of multi-dimensional arrays are compressed", "[encoder][border]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    if constexpr (dims > 1) {
+        // Hypercubes cover about half (2D) or less than half (3D) of the array
+        const auto size = extent::broadcast(dims, 4 * side_length - 1);
+        const auto num_border_elements = border_element_count(static_extent<dims>{size}, side_length);
+        const std::vector<value_type> input_data(num_elements(size), value_type{1.5});
+
+        const auto num_threads = GENERATE(1u, 3u);
+        CAPTURE(num_threads);
+
+        std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+        const auto stream_length
+                = make_compressor<value_type>(dims, num_threads)->compress(input_data.data(), size, stream.data());
+        CHECK(stream_length < num_border_elements / 4);
+
+        std::vector<value_type> output_data(input_data.size());
+        CHECK(make_decompressor<value_type>(dims, num_threads)->decompress(stream.data(), output_data.data(), size)
+                == stream_length);
+        CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+    }
+}
+#else
+TEMPLATE_TEST_CASE("borders are stored verbatim", "[encoder][border]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    const auto size = extent::broadcast(dims, 2 * side_length - 1);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+    std::vector<bits_type> border(border_element_count(static_extent<dims>{size}, side_length));
+    pack_border(border.data(), input_data.data(), static_extent<dims>{size}, side_length);
+
+    const auto num_threads = GENERATE(1u, 3u);
+    CAPTURE(num_threads);
+
+    std::vector<bits_type> stream_buffer(ndzip::compressed_length_bound<value_type>(size));
+    const auto stream_length = make_compressor<value_type>(dims, num_threads)
+                                       ->compress(input_data.data(), size, stream_buffer.data());
+    detail::stream<const profile> stream{num_hypercubes(size), stream_buffer.data()};
+    CHECK(stream_length == static_cast<size_t>(stream.border() - stream_buffer.data()) + border.size());
+    CHECK(std::equal(border.begin(), border.end(), stream.border()));
+}
+#endif
+
+
+#if NDZIP_STREAM_FORMAT_VERSION >= 3
+TEMPLATE_TEST_CASE("constant and incompressible hypercubes are stored as one word and verbatim", "[encoder][de][encoding]",
+        ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    constexpr auto hc_size = ipow(side_length, dims);
+
+    // The first hypercube is constant, all others hold random bits (short of NaNs and infinities)
+    const auto size = extent::broadcast(dims, 2 * side_length);
+    auto input_bits = make_random_vector<bits_type>(num_elements(size));
+    const auto constant_bits = bit_cast<bits_type>(value_type{1.5});
+    for (size_t i = 0; i < input_bits.size(); ++i) {
+        const auto position = extent_from_linear_id(i, static_extent<dims>{size});
+        bool in_first_hypercube = true;
+        for (dim_type d = 0; d < dims; ++d) {
+            in_first_hypercube &= position[d] < side_length;
+        }
+        input_bits[i] = in_first_hypercube ? constant_bits : input_bits[i] & ~(bits_type{1} << (bits_of<bits_type> - 2));
+    }
+    std::vector<value_type> input_data(input_bits.size());
+    memcpy(input_data.data(), input_bits.data(), input_bits.size() * sizeof(bits_type));
+
+    const auto num_threads = GENERATE(1u, 3u);
+    CAPTURE(num_threads);
+
+    std::vector<bits_type> stream_buffer(ndzip::compressed_length_bound<value_type>(size));
+    const auto stream_length = make_compressor<value_type>(dims, num_threads)
+                                       ->compress(input_data.data(), size, stream_buffer.data());
+    CHECK(stream_length <= stream_buffer.size());
+
+    detail::stream<const profile> stream{num_hypercubes(size), stream_buffer.data()};
+    CHECK(stream.hypercube_size(0) == 1);
+    CHECK(stream.hypercube(0)[0] == constant_bits);
+    for (index_type hc_index = 1; hc_index < stream.num_hypercubes; ++hc_index) {
+        CHECK(stream.hypercube_size(hc_index) == hc_size);
+    }
+
+    std::vector<value_type> output_data(input_data.size());
+    CHECK(make_decompressor<value_type>(dims, num_threads)->decompress(stream_buffer.data(), output_data.data(), size)
+            == stream_length);
+    std::vector<bits_type> output_bits(output_data.size());
+    memcpy(output_bits.data(), output_data.data(), output_data.size() * sizeof(bits_type));
+    CHECK_FOR_VECTOR_EQUALITY(input_bits, output_bits);
+}
+#endif
+
+
+TEMPLATE_TEST_CASE("lossy precision bounds the error and shortens the stream", "[encoder][lossy]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    // Includes a border, which is truncated alongside the hypercubes
+    const auto size = extent::broadcast(dims, profile::hypercube_side_length * 2 + 3);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+    const auto compress = [&](unsigned num_threads, const lossy_precision &precision) {
+        std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+        stream.resize(make_compressor<value_type>(dims, num_threads, thread_placement::any, precision)
+                              ->compress(input_data.data(), size, stream.data()));
+        return stream;
+    };
+    const auto decompress = [&](const std::vector<bits_type> &stream) {
+        std::vector<value_type> output_data(input_data.size());
+        CHECK(make_decompressor<value_type>(dims, 1)->decompress(stream.data(), output_data.data(), size)
+                == stream.size());
+        return output_data;
+    };
+
+    const auto lossless_stream = compress(1, lossy_precision{});
+
+    SECTION("mantissa bits") {
+        const auto precision = lossy_precision::mantissa_bits(8);
+        const auto stream = compress(1, precision);
+        CHECK(stream.size() < lossless_stream.size());
+        CHECK_FOR_VECTOR_EQUALITY(compress(3, precision), stream);
+
+        // Sign, exponent and the kept mantissa bits survive, the low bits are chosen by the compressor
+        const mantissa_truncation<value_type> truncation{precision};
+        const auto output_data = decompress(stream);
+        size_t num_violations = 0;
+        for (size_t i = 0; i < input_data.size(); ++i) {
+            num_violations += truncation(bit_cast<bits_type>(output_data[i])).bits
+                    != truncation(bit_cast<bits_type>(input_data[i])).bits;
+        }
+        CHECK(num_violations == 0);
+    }
+
+    SECTION("absolute error") {
+        const value_type bound = 1e-3;
+        const auto precision = lossy_precision::absolute_error(bound);
+        const auto stream = compress(1, precision);
+        CHECK(stream.size() < lossless_stream.size());
+        CHECK_FOR_VECTOR_EQUALITY(compress(3, precision), stream);
+
+        const auto output_data = decompress(stream);
+        size_t num_violations = 0;
+        for (size_t i = 0; i < input_data.size(); ++i) {
+            num_violations += !(std::abs(output_data[i] - input_data[i]) <= bound);
+        }
+        CHECK(num_violations == 0);
+    }
+}
+
+
+TEMPLATE_TEST_CASE("lossy precision keeps the documented guarantees", "[encoder][lossy]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+    using limits = std::numeric_limits<value_type>;
+
+    constexpr auto dims = profile::dimensions;
+    const auto size = extent::broadcast(dims, profile::hypercube_side_length * 2 + 3);
+
+    // Both signs and magnitudes from the subnormal range up to well above the error bounds below, with zeros,
+    // infinities and NaNs mixed in
+    auto input_data = make_random_vector<value_type>(num_elements(size));
+    auto gen = std::minstd_rand();
+    std::uniform_int_distribution<int> exponent_dist(limits::min_exponent - 20, 8);
+    for (size_t i = 0; i < input_data.size(); ++i) {
+        auto value = std::ldexp(input_data[i], exponent_dist(gen));
+        if (i % 2 == 1) { value = -value; }
+        switch (i % 101) {
+            case 0: value = 0; break;
+            case 1: value = -value_type{0}; break;
+            case 2: value = limits::infinity(); break;
+            case 3: value = -limits::infinity(); break;
+            case 4: value = limits::quiet_NaN(); break;
+        }
+        input_data[i] = value;
+    }
+
+    const auto round_trip = [&](const lossy_precision &precision) {
+        std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+        stream.resize(make_compressor<value_type>(dims, 1, thread_placement::any, precision)
+                              ->compress(input_data.data(), size, stream.data()));
+        std::vector<value_type> output_data(input_data.size());
+        CHECK(make_decompressor<value_type>(dims, 1)->decompress(stream.data(), output_data.data(), size)
+                == stream.size());
+        return output_data;
+    };
+
+    // Errors are computed in long double, where they cannot round up to the bound
+    const auto error = [](value_type output, value_type input) {
+        return std::abs(static_cast<long double>(output) - static_cast<long double>(input));
+    };
+
+    SECTION("mantissa bits") {
+        const unsigned kept_bits = GENERATE(0u, 5u, 12u);
+        CAPTURE(kept_bits);
+        const auto output_data = round_trip(lossy_precision::mantissa_bits(kept_bits));
+        size_t num_violations = 0;
+        for (size_t i = 0; i < input_data.size(); ++i) {
+            const auto in = input_data[i];
+            const auto out = output_data[i];
+            if (!std::isfinite(in)) {
+                num_violations += bit_cast<bits_type>(out) != bit_cast<bits_type>(in);
+            } else {
+                num_violations += std::signbit(out) != std::signbit(in);
+                if (std::isnormal(in)) {
+                    num_violations += std::ilogb(out) != std::ilogb(in);
+                    num_violations += !(error(out, in) < std::ldexp(std::abs(static_cast<long double>(in)),
+                                                -static_cast<int>(kept_bits)));
+                }
+            }
+        }
+        CHECK(num_violations == 0);
+    }
+
+    SECTION("absolute error") {
+        // Includes a power of two, which is the largest power of two not exceeding itself
+        const double bound = GENERATE(1e-3, 0.25, 1e-30);
+        CAPTURE(bound);
+        const auto output_data = round_trip(lossy_precision::absolute_error(bound));
+        const auto below_bound_limit = std::ldexp(1.0L, std::ilogb(bound));
+        size_t num_violations = 0;
+        size_t num_below_bound = 0;
+        for (size_t i = 0; i < input_data.size(); ++i) {
+            const auto in = input_data[i];
+            const auto out = output_data[i];
+            if (!std::isfinite(in)) {
+                num_violations += bit_cast<bits_type>(out) != bit_cast<bits_type>(in);
+            } else {
+                num_violations += std::signbit(out) != std::signbit(in);
+                num_violations += !(error(out, in) < bound);
+                if (std::abs(static_cast<long double>(in)) < below_bound_limit) {
+                    ++num_below_bound;
+                    num_violations += std::isnormal(out);
+                }
+            }
+        }
+        CHECK(num_below_bound > 0);
+        CHECK(num_violations == 0);
+    }
+}
+
+
+TEMPLATE_TEST_CASE("multi-device offloader produces the same stream as a single offloader", "[encoder][multi]",
+        ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    // Single row of hypercubes (one device only), aligned, and unaligned with an uneven split of rows across devices
+    const auto n = GENERATE(side_length + 3, 2 * side_length, 5 * side_length - 1);
+    const auto num_devices = GENERATE(2u, 3u);
+    CAPTURE(n, num_devices);
+    const auto size = extent::broadcast(dims, n);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+
+    std::vector<bits_type> reference_stream(ndzip::compressed_length_bound<value_type>(size));
+    reference_stream.resize(make_cpu_offloader<value_type>(dims, 1)->compress(
+            input_data.data(), size, reference_stream.data()));
+
+    std::vector<std::unique_ptr<offloader<value_type>>> devices;
+    for (unsigned i = 0; i < num_devices; ++i) {
+        devices.push_back(make_cpu_offloader<value_type>(dims, 1));
+    }
+    const auto offloader = make_multi_device_offloader<value_type>(dims, std::move(devices));
+
+    std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+    stream.resize(offloader->compress(input_data.data(), size, stream.data()));
+    CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+
+    std::vector<value_type> output_data(input_data.size());
+    CHECK(offloader->decompress(stream.data(), stream.size(), output_data.data(), size) == stream.size());
+    CHECK_FOR_VECTOR_EQUALITY(input_data, output_data);
+}
+
+TEMPLATE_TEST_CASE("stream_compressor produces the same stream as compressor", "[encoder][stream]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    const auto size = extent::broadcast(dims, side_length * 2 + 3);
+    const auto input_data = make_random_vector<value_type>(num_elements(size));
+    const auto row_length = num_elements(size) / size[0];
+
+    std::vector<bits_type> reference_stream(ndzip::compressed_length_bound<value_type>(size));
+    reference_stream.resize(make_compressor<value_type>(dims, 1)->compress(
+            input_data.data(), size, reference_stream.data()));
+
+    index_type rows_per_call;
+    SECTION("all rows at once") { rows_per_call = size[0]; }
+    SECTION("one slab at a time") { rows_per_call = side_length; }
+    SECTION("unaligned groups of rows") { rows_per_call = side_length / 2 + 1; }
+    SECTION("single rows") { rows_per_call = 1; }
+
+    std::vector<bits_type> stream;
+    size_t highest_hypercube_offset = 0;
+    const auto sink = [&](size_t offset, const bits_type *words, size_t count) {
+        if (offset > 0 && offset < highest_hypercube_offset) { FAIL("hypercube data emitted out of order"); }
+        highest_hypercube_offset = std::max(highest_hypercube_offset, offset);
+        if (stream.size() < offset + count) { stream.resize(offset + count); }
+        std::copy_n(words, count, stream.begin() + offset);
+    };
+    const auto compressor = make_stream_compressor<value_type>(size, sink, 1);
+    CHECK(compressor->rows_per_slab() == side_length);
+
+    for (index_type row = 0; row < size[0]; row += rows_per_call) {
+        const auto num_rows = std::min(rows_per_call, size[0] - row);
+        compressor->write_rows(input_data.data() + row * row_length, num_rows);
+    }
+    const auto stream_length = compressor->finish();
+
+    CHECK(stream_length == reference_stream.size());
+    CHECK_FOR_VECTOR_EQUALITY(stream, reference_stream);
+}
+
+TEMPLATE_TEST_CASE("decompress_region reproduces a box of the input", "[encoder][de][region]", ALL_PROFILES) {
+    using profile = TestType;
+    using value_type = typename profile::value_type;
+    using bits_type = typename profile::bits_type;
+
+    constexpr auto dims = profile::dimensions;
+    constexpr auto side_length = profile::hypercube_side_length;
+    const index_type n = side_length * 3 - 1;
+    const auto size = static_extent<dims>::broadcast(n);
+
+    const auto input_data = make_random_vector<value_type>(ipow(n, dims));
+    std::vector<bits_type> stream(ndzip::compressed_length_bound<value_type>(size));
+    stream.resize(make_cpu_offloader<value_type>(dims, 1)->compress(input_data.data(), size, stream.data()));
+
+    auto test_region = [&](auto &&decoder, const static_extent<dims> &region_offset,
+                               const static_extent<dims> &region_size) {
+        std::vector<value_type> expected_data(num_elements(region_size));
+        copy_box_intersection(expected_data.data(), region_offset, region_size, input_data.data(),
+                static_extent<dims>{}, size);
+
+        std::vector<value_type> output_data(expected_data.size());
+        decoder.decompress_region(stream.data(), stream.size(), size, region_offset, region_size, output_data.data());
+        CHECK_FOR_VECTOR_EQUALITY(expected_data, output_data);
+    };
+
+    auto test_decoder = [&](auto &&decoder) {
+        // straddles hypercube boundaries
+        test_region(decoder, static_extent<dims>::broadcast(side_length / 2 + 1),
+                static_extent<dims>::broadcast(side_length + side_length / 3));
+        // overlaps hypercubes and the border
+        test_region(decoder, static_extent<dims>::broadcast(side_length + 3),
+                static_extent<dims>::broadcast(n - side_length - 3));
+        // border only
+        test_region(decoder, static_extent<dims>::broadcast(n - 2), static_extent<dims>::broadcast(2));
+        // whole array
+        test_region(decoder, static_extent<dims>{}, size);
+        // empty
+        test_region(decoder, static_extent<dims>::broadcast(1), static_extent<dims>{});
+
+        CHECK_THROWS(test_region(decoder, static_extent<dims>::broadcast(1), size));
+    };
+
+    SECTION("serial CPU decompress") { test_decoder(*make_cpu_offloader<value_type>(dims, 1)); }
+
+#if NDZIP_OPENMP_SUPPORT
+    SECTION("OpenMP CPU decompress", "[omp]") { test_decoder(*make_cpu_offloader<value_type>(dims)); }
+#endif
+
+#if NDZIP_HIPSYCL_SUPPORT
+    SECTION("SYCL decompress", "[sycl]") { test_decoder(*make_sycl_offloader<value_type>(dims)); }
+#endif
+
+#if NDZIP_CUDA_SUPPORT
+    SECTION("CUDA decompress", "[cuda]") { test_decoder(*make_cuda_offloader<value_type>(dims)); }
+#endif
+}
+
+
 #if NDZIP_OPENMP_SUPPORT || NDZIP_HIPSYCL_SUPPORT || NDZIP_CUDA_SUPPORT
 TEMPLATE_TEST_CASE("file headers from different encoders are identical", "[header]", ALL_PROFILES) {
     using value_type = typename TestType::value_type;
@@ -1052,7 +1571,7 @@ TEMPLATE_TEST_CASE("Encoders compress and decompress files with 0 hypercubes", "
 
     const size_t input_bound = 1;
     std::vector<value_type> input(input_bound, value_type{42});  // dummy input
-    const auto compressed_bound = std::max(index_type{1}, compressed_length_bound<value_type>(size));
+    const auto compressed_bound = std::max(size_t{1}, compressed_length_bound<value_type>(size));
 
     using offloader_constructor = std::unique_ptr<offloader<value_type>> (*)();
     const auto [offloader_name, make_offloader] = GENERATE(values<std::pair<const char *, offloader_constructor>>({
@@ -0,0 +1,79 @@
+#include "test_utils.hh"
+
+#include <cmath>
+
+#include <ndzip/hdf5.hh>
+
+
+using namespace ndzip;
+
+
+TEST_CASE("suggested HDF5 chunk shapes consist of whole hypercubes", "[hdf5]") {
+    CHECK(hdf5::suggest_chunk_shape({512, 512, 512}, sizeof(float), size_t{1} << 22u)
+            == std::vector<hsize_t>{16, 128, 512});
+    CHECK(hdf5::suggest_chunk_shape({100, 1000}, sizeof(double), size_t{1} << 20u) == std::vector<hsize_t>{64, 960});
+    CHECK(hdf5::suggest_chunk_shape({10000}, sizeof(double)) == std::vector<hsize_t>{8192});
+
+    // Dimensions smaller than a hypercube are covered entirely, outer dimensions fill the remaining budget
+    CHECK(hdf5::suggest_chunk_shape({10, 8, 16, 16, 16}, sizeof(float), 16 * 4096 * sizeof(float))
+            == std::vector<hsize_t>{2, 8, 16, 16, 16});
+    CHECK(hdf5::suggest_chunk_shape({3, 10}, sizeof(float)) == std::vector<hsize_t>{3, 10});
+}
+
+
+template<typename T>
+static void test_hdf5_round_trip(hid_t file, const char *name, const std::vector<hsize_t> &shape, hid_t type,
+        const std::vector<T> &data, unsigned num_threads) {
+    const auto space = H5Screate_simple(static_cast<int>(shape.size()), shape.data(), nullptr);
+    const auto dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    // A small chunk size gives partial chunks at the edges of the dataset, which HDF5 pads to the full chunk shape
+    const auto chunk = hdf5::suggest_chunk_shape(shape, sizeof(T), 64 * 1024);
+    REQUIRE(H5Pset_chunk(dcpl, static_cast<int>(chunk.size()), chunk.data()) >= 0);
+    REQUIRE(hdf5::set_filter(dcpl, num_threads) >= 0);
+
+    const auto dataset = H5Dcreate2(file, name, type, space, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    REQUIRE(dataset >= 0);
+    REQUIRE(H5Dwrite(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, data.data()) >= 0);
+    CHECK(H5Dget_storage_size(dataset) < data.size() * sizeof(T));
+
+    std::vector<T> read_back(data.size());
+    REQUIRE(H5Dread(dataset, type, H5S_ALL, H5S_ALL, H5P_DEFAULT, read_back.data()) >= 0);
+    CHECK(read_back == data);
+
+    H5Dclose(dataset);
+    H5Pclose(dcpl);
+    H5Sclose(space);
+}
+
+
+TEST_CASE("HDF5 filter reproduces chunked datasets", "[hdf5]") {
+    REQUIRE(hdf5::register_filter() >= 0);
+    REQUIRE(H5Zfilter_avail(hdf5::filter_id) > 0);
+
+    // In-memory file without backing store
+    const auto fapl = H5Pcreate(H5P_FILE_ACCESS);
+    REQUIRE(H5Pset_fapl_core(fapl, 1 << 20, false) >= 0);
+    const auto file = H5Fcreate("ndzip_filter_test.h5", H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    REQUIRE(file >= 0);
+
+    const std::vector<hsize_t> shape{40, 70, 90};
+    std::vector<float> smooth(40 * 70 * 90);
+    for (size_t i = 0; i < smooth.size(); ++i) {
+        smooth[i] = std::sin(static_cast<float>(i) * 0.001f);
+    }
+    SECTION("float, serial") { test_hdf5_round_trip(file, "serial", shape, H5T_NATIVE_FLOAT, smooth, 1); }
+    SECTION("float, multi-threaded") { test_hdf5_round_trip(file, "parallel", shape, H5T_NATIVE_FLOAT, smooth, 0); }
+
+    SECTION("int16, 4D") {
+        // The two outer dimensions of a chunk fold into one hypercube side length, so that chunks are not all border,
+        // which is stored verbatim before stream format version 2
+        std::vector<int16_t> ramp(8 * 4 * 40 * 70);
+        for (size_t i = 0; i < ramp.size(); ++i) {
+            ramp[i] = static_cast<int16_t>(i / 7);
+        }
+        test_hdf5_round_trip(file, "ramp", {8, 4, 40, 70}, H5T_NATIVE_INT16, ramp, 1);
+    }
+
+    H5Fclose(file);
+    H5Pclose(fapl);
+}
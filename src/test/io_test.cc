@@ -0,0 +1,98 @@
+#include "test_utils.hh"
+
+#include <cstdio>
+
+#include <io/io.hh>
+
+
+using namespace ndzip;
+using namespace ndzip::detail;
+
+
+#if NDZIP_SUPPORT_IO_URING
+
+// Compressed chunks have lengths that are no multiple of the O_DIRECT alignment, so the output stream writes and the
+// input stream reads them at unaligned positions, and read_some() returns chunks spanning two segments
+TEST_CASE("arrays round-trip through compressed files written and read with io_uring", "[io]") {
+    using compressed_type = ndzip::compressed_type<float>;
+    const char *raw_file_name = "ndzip_io_test.raw";
+    const char *compressed_file_name = "ndzip_io_test.nd";
+
+    const auto queue_depth = GENERATE(2u, 4u);
+    const io_uring_io_factory io(queue_depth);
+
+    const extent size{100, 150};
+    const auto chunk_length = static_cast<size_t>(num_elements(size));
+    const auto chunk_size = chunk_length * sizeof(float);
+    const size_t num_chunks = 7;
+    const auto data = make_random_vector<float>(num_chunks * chunk_length);
+
+    {
+        const auto out = io.create_output_stream(raw_file_name, chunk_size);
+        for (size_t i = 0; i < num_chunks; ++i) {
+            memcpy(out->get_write_buffer(), data.data() + i * chunk_length, chunk_size);
+            out->commit_chunk(chunk_size);
+        }
+    }
+
+    const auto max_compressed_chunk_size = compressed_length_bound<float>(size) * sizeof(compressed_type);
+    std::vector<size_t> compressed_chunk_sizes;
+    {
+        const auto compressor = make_compressor<float>(2, 1);
+        const auto in = io.create_input_stream(raw_file_name, chunk_size);
+        const auto out = io.create_output_stream(compressed_file_name, max_compressed_chunk_size);
+        for (size_t i = 0; i < num_chunks; ++i) {
+            const auto chunk = static_cast<const float *>(in->read_exact());
+            REQUIRE(chunk != nullptr);
+            CHECK(std::equal(chunk, chunk + chunk_length, data.data() + i * chunk_length));
+            const auto compressed_size
+                    = compressor->compress(chunk, size, static_cast<compressed_type *>(out->get_write_buffer()))
+                    * sizeof(compressed_type);
+            out->commit_chunk(compressed_size);
+            compressed_chunk_sizes.push_back(compressed_size);
+        }
+        CHECK(in->read_exact() == nullptr);
+    }
+
+    const auto decompressor = make_decompressor<float>(2, 1);
+    std::vector<float> decompressed(chunk_length);
+    {
+        const auto in = io.create_input_stream(compressed_file_name, max_compressed_chunk_size);
+        size_t compressed_bytes_left = 0;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            const auto [chunk, bytes_in_chunk] = in->read_some(compressed_bytes_left);
+            REQUIRE(bytes_in_chunk >= compressed_chunk_sizes[i]);
+            CHECK(decompressor->decompress(static_cast<const compressed_type *>(chunk), decompressed.data(), size)
+                            * sizeof(compressed_type)
+                    == compressed_chunk_sizes[i]);
+            CHECK(std::equal(decompressed.begin(), decompressed.end(), data.data() + i * chunk_length));
+            compressed_bytes_left = bytes_in_chunk - compressed_chunk_sizes[i];
+        }
+        CHECK(compressed_bytes_left == 0);
+    }
+
+    {
+        const auto in = io.create_random_access_input(compressed_file_name);
+        size_t offset = 0;
+        for (size_t i = 0; i < num_chunks; ++i) {
+            offset += compressed_chunk_sizes[i];
+        }
+        CHECK(in->size() == offset);
+        for (size_t i = num_chunks; i-- > 0;) {
+            offset -= compressed_chunk_sizes[i];
+            const auto chunk = in->read_at(offset, compressed_chunk_sizes[i]);
+            decompressor->decompress(static_cast<const compressed_type *>(chunk), decompressed.data(), size);
+            CHECK(std::equal(decompressed.begin(), decompressed.end(), data.data() + i * chunk_length));
+        }
+    }
+
+    std::remove(raw_file_name);
+    std::remove(compressed_file_name);
+}
+
+
+TEST_CASE("io_uring I/O rejects queue depths below 2", "[io]") {
+    CHECK_THROWS_AS(io_uring_io_factory{1}, std::invalid_argument);
+}
+
+#endif
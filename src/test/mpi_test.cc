@@ -0,0 +1,107 @@
+#define CATCH_CONFIG_RUNNER
+#include "test_utils.hh"
+
+#include <cmath>
+#include <fstream>
+
+#include <ndzip/mpi.hh>
+
+
+using namespace ndzip;
+
+
+// Rank r owns rows [r * 64, (r + 1) * 64) of a 2D field, which are whole hypercube rows. The last rank additionally
+// owns a remainder that leaves a border, and the number of columns is not a multiple of the side length either.
+static extent local_extent(int rank, int num_ranks) {
+    return extent{rank == num_ranks - 1 ? index_type{64 + 37} : index_type{64}, 200};
+}
+
+template<typename T>
+static std::vector<T> local_field(int rank, int num_ranks, unsigned seed) {
+    const auto size = local_extent(rank, num_ranks);
+    std::vector<T> field(num_elements(size));
+    for (index_type i = 0; i < size[0]; ++i) {
+        for (index_type j = 0; j < size[1]; ++j) {
+            const auto y = static_cast<float>(rank * 64 + i);
+            const auto x = static_cast<float>(j);
+            field[i * size[1] + j] = static_cast<T>(100 * std::sin(0.01f * (x + seed) * y) + 100);
+        }
+    }
+    return field;
+}
+
+
+TEMPLATE_TEST_CASE("Domain-decomposed fields round-trip through a shared file", "[mpi]", float, uint16_t) {
+    using compressed_type = detail::bits_type<TestType>;
+    const char *file_name = "ndzip_mpi_test.bin";
+
+    int rank, num_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    const auto size = local_extent(rank, num_ranks);
+    const auto first = local_field<TestType>(rank, num_ranks, 0);
+    const auto second = local_field<TestType>(rank, num_ranks, 1);
+
+    // Two consecutive fields behind a 16-byte application header
+    const MPI_Offset app_header_bytes = 16;
+    MPI_Offset first_bytes, second_bytes;
+    {
+        MPI_File file;
+        REQUIRE(MPI_File_open(MPI_COMM_WORLD, file_name, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file)
+                == MPI_SUCCESS);
+        auto compressor = make_compressor<TestType>(2, 1);
+        first_bytes = mpi::write_compressed(MPI_COMM_WORLD, file, app_header_bytes, *compressor, first.data(), size);
+        second_bytes = mpi::write_compressed(
+                MPI_COMM_WORLD, file, app_header_bytes + first_bytes, *compressor, second.data(), size);
+        MPI_File_close(&file);
+    }
+
+    {
+        MPI_File file;
+        REQUIRE(MPI_File_open(MPI_COMM_WORLD, file_name, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) == MPI_SUCCESS);
+        auto decompressor = make_decompressor<TestType>(2, 1);
+        std::vector<TestType> read_back(first.size());
+        CHECK(mpi::read_compressed(MPI_COMM_WORLD, file, app_header_bytes, *decompressor, read_back.data(), size)
+                == first_bytes);
+        CHECK(read_back == first);
+        CHECK(mpi::read_compressed(MPI_COMM_WORLD, file, app_header_bytes + first_bytes, *decompressor,
+                      read_back.data(), size)
+                == second_bytes);
+        CHECK(read_back == second);
+        MPI_File_close(&file);
+    }
+
+    // Without MPI, the streams of all ranks are located through the header and decompress as regular ndzip streams
+    if (rank == 0) {
+        std::ifstream in(file_name, std::ios::binary);
+        in.seekg(app_header_bytes + first_bytes);
+        std::vector<uint64_t> offsets_after(num_ranks);
+        in.read(reinterpret_cast<char *>(offsets_after.data()), num_ranks * sizeof(uint64_t));
+        std::vector<compressed_type> streams(offsets_after.back());
+        in.read(reinterpret_cast<char *>(streams.data()), streams.size() * sizeof(compressed_type));
+        REQUIRE(in);
+        CHECK(static_cast<MPI_Offset>(num_ranks * sizeof(uint64_t) + streams.size() * sizeof(compressed_type))
+                == second_bytes);
+
+        auto decompressor = make_decompressor<TestType>(2, 1);
+        for (int r = 0; r < num_ranks; ++r) {
+            const auto expected = local_field<TestType>(r, num_ranks, 1);
+            std::vector<TestType> decompressed(expected.size());
+            const auto stream = streams.data() + (r == 0 ? 0 : offsets_after[r - 1]);
+            CHECK(decompressor->decompress(stream, decompressed.data(), local_extent(r, num_ranks))
+                    == offsets_after[r] - (r == 0 ? 0 : offsets_after[r - 1]));
+            CHECK(decompressed == expected);
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) { MPI_File_delete(file_name, MPI_INFO_NULL); }
+}
+
+
+int main(int argc, char **argv) {
+    MPI_Init(&argc, &argv);
+    const auto result = Catch::Session().run(argc, argv);
+    MPI_Finalize();
+    return result;
+}
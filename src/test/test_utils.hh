@@ -7,11 +7,13 @@
 // prototype)
 #include <algorithm>
 #include <complex>
+#include <cstring>
 #include <random>
 #include <sstream>
 #include <vector>
 
 #include <catch2/catch.hpp>
+#include <ndzip/ndzip.hh>
 
 
 template<typename Arithmetic>
@@ -21,14 +23,40 @@ static std::vector<Arithmetic> make_random_vector(size_t size) {
     if constexpr (std::is_floating_point_v<Arithmetic>) {
         auto dist = std::uniform_real_distribution<Arithmetic>();
         std::generate(vector.begin(), vector.end(), [&] { return dist(gen); });
+    } else if constexpr (std::is_integral_v<Arithmetic>) {
+        // uniform_int_distribution is undefined for 8-bit types
+        using int_type = std::conditional_t<std::is_signed_v<Arithmetic>, int64_t, uint64_t>;
+        auto dist = std::uniform_int_distribution<int_type>(
+                std::numeric_limits<Arithmetic>::min(), std::numeric_limits<Arithmetic>::max());
+        std::generate(vector.begin(), vector.end(), [&] { return static_cast<Arithmetic>(dist(gen)); });
     } else {
-        auto dist = std::uniform_int_distribution<Arithmetic>();
-        std::generate(vector.begin(), vector.end(), [&] { return dist(gen); });
+        // ndzip::float16 and ndzip::bfloat16, filled with the upper half of the bits of a random float
+        static_assert(sizeof(Arithmetic) == sizeof(uint16_t));
+        auto dist = std::uniform_real_distribution<float>();
+        std::generate(vector.begin(), vector.end(), [&] {
+            const auto value = dist(gen);
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof bits);
+            return Arithmetic{static_cast<uint16_t>(bits >> 16u)};
+        });
     }
     return vector;
 }
 
 
+// Elements in a form std::ostream prints as numbers
+template<typename T>
+auto printable(T value) {
+    if constexpr (std::is_same_v<T, ndzip::float16> || std::is_same_v<T, ndzip::bfloat16>) {
+        return value.bits;
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+        return int{value};
+    } else {
+        return value;
+    }
+}
+
+
 template<typename T>
 void check_for_vector_equality(const T *lhs, const T *rhs, size_t size, const char *file, int line) {
     size_t first_mismatch = SIZE_MAX, last_mismatch = 0;
@@ -45,7 +73,7 @@ void check_for_vector_equality(const T *lhs, const T *rhs, size_t size, const ch
            << " and " << last_mismatch << ":\n    {";
         for (auto *vec : {&lhs, &rhs}) {
             for (size_t i = first_mismatch; i <= last_mismatch;) {
-                ss << (*vec)[i];
+                ss << printable((*vec)[i]);
                 if (i < last_mismatch) { ss << ", "; }
                 if (i >= first_mismatch + 20 && i < last_mismatch - 20) {
                     i = last_mismatch - 20;